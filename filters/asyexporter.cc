@@ -64,23 +64,28 @@ void AsyExporter::run(const KigPart &doc, KigWidget &w)
     delete opts;
     delete kfd;
 
-    QFile file(file_name);
-    if (!file.open(QIODevice::WriteOnly)) {
+    if (!write(doc.document(), w.screenInfo(), file_name, showgrid, showaxes, showframe)) {
         KMessageBox::error(&w,
                            i18n("The file \"%1\" could not be opened. Please "
                                 "check if the file permissions are set correctly.",
                                 file_name));
-        return;
-    };
+    }
+}
+
+bool AsyExporter::write(const KigDocument &doc, const ScreenInfo &si, const QString &file_name, bool showgrid, bool showaxes, bool showframe)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
 
-    const double bottom = w.showingRect().bottom();
-    const double left = w.showingRect().left();
-    const double height = w.showingRect().height();
-    const double width = w.showingRect().width();
+    const double bottom = si.shownRect().bottom();
+    const double left = si.shownRect().left();
+    const double height = si.shownRect().height();
+    const double width = si.shownRect().width();
 
-    std::vector<ObjectHolder *> os = doc.document().objects();
+    std::vector<ObjectHolder *> os = doc.objects();
     QTextStream stream(&file);
-    AsyExporterImpVisitor visitor(stream, w);
+    AsyExporterImpVisitor visitor(stream, doc, si);
 
     // Start building the output stream containing the asymptote script commands
 
@@ -132,4 +137,5 @@ void AsyExporter::run(const KigPart &doc, KigWidget &w)
 
     // And close the output file
     file.close();
+    return true;
 }
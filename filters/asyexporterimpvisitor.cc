@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "asyexporterimpvisitor.h"
+#include "filters-common.h"
 
 #include "../misc/goniometry.h"
 #include "../objects/bezier_imp.h"
@@ -98,7 +99,7 @@ void AsyExporterImpVisitor::emitLine(const Coordinate &a, const Coordinate &b, c
 double AsyExporterImpVisitor::dimRealToCoord(int dim)
 {
     QRect qr(0, 0, dim, dim);
-    Rect r = mw.screenInfo().fromScreen(qr);
+    Rect r = msi.fromScreen(qr);
     return fabs(r.width());
 }
 
@@ -112,41 +113,7 @@ void AsyExporterImpVisitor::visit(ObjectHolder *obj)
 
 void AsyExporterImpVisitor::plotGenericCurve(const CurveImp *imp)
 {
-    std::vector<std::vector<Coordinate>> coordlist;
-    coordlist.push_back(std::vector<Coordinate>());
-    uint curid = 0;
-
-    Coordinate c;
-    Coordinate prev = Coordinate::invalidCoord();
-    for (double i = 0.0; i <= 1.0; i += 0.0001) {
-        c = imp->getPoint(i, mw.document());
-        if (!c.valid()) {
-            if (coordlist[curid].size() > 0) {
-                coordlist.push_back(std::vector<Coordinate>());
-                ++curid;
-                prev = Coordinate::invalidCoord();
-            }
-            continue;
-        }
-        if (!((fabs(c.x) <= 10000) && (fabs(c.y) <= 10000)))
-            continue;
-        // if there's too much distance between this coordinate and the previous
-        // one, then it's another piece of curve not joined with the rest
-        if (prev.valid() && (c.distance(prev) > 50.0)) {
-            coordlist.push_back(std::vector<Coordinate>());
-            ++curid;
-        }
-        coordlist[curid].push_back(c);
-        prev = c;
-    }
-    // special case for ellipse
-    if (const ConicImp *conic = dynamic_cast<const ConicImp *>(imp)) {
-        // if ellipse, close its path
-        // THSI IS WRONG, think of ellipse arcs!!
-        if (conic->conicType() == 1 && coordlist.size() == 1 && coordlist[0].size() > 1) {
-            coordlist[0].push_back(coordlist[0][0]);
-        }
-    }
+    const std::vector<std::vector<Coordinate>> coordlist = filtersTessellateCurve(imp, mdoc, msr, msi.pixelWidth() / 4);
     for (uint i = 0; i < coordlist.size(); ++i) {
         uint s = coordlist[i].size();
         // there's no point in draw curves empty or with only one point
@@ -264,7 +231,6 @@ void AsyExporterImpVisitor::visit(const ConicImp *imp)
 
 void AsyExporterImpVisitor::visit(const CubicImp *imp)
 {
-    // FIXME: cubic are not drawn correctly with plotGenericCurve
     plotGenericCurve(imp);
 }
 
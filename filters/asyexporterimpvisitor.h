@@ -7,6 +7,7 @@
 #include "../kig/kig_document.h"
 #include "../kig/kig_part.h"
 #include "../kig/kig_view.h"
+#include "../misc/screeninfo.h"
 
 #include "../objects/bezier_imp.h"
 #include "../objects/circle_imp.h"
@@ -26,16 +27,18 @@ class AsyExporterImpVisitor : public ObjectImpVisitor
 {
     QTextStream &mstream;
     ObjectHolder *mcurobj;
-    const KigWidget &mw;
+    const KigDocument &mdoc;
+    const ScreenInfo msi;
     Rect msr;
 
 public:
     void visit(ObjectHolder *obj);
 
-    AsyExporterImpVisitor(QTextStream &s, const KigWidget &w)
+    AsyExporterImpVisitor(QTextStream &s, const KigDocument &doc, const ScreenInfo &si)
         : mstream(s)
-        , mw(w)
-        , msr(mw.showingRect())
+        , mdoc(doc)
+        , msi(si)
+        , msr(si.shownRect())
     {
     }
     using ObjectImpVisitor::visit;
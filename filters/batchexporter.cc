@@ -0,0 +1,236 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "batchexporter.h"
+
+#include "asyexporter.h"
+#include "exporter.h"
+#include "filter.h"
+#include "latexexporter.h"
+#include "latexexporteroptions.h"
+#include "native-binary-filter.h"
+#include "native-filter.h"
+#include "svgexporter.h"
+#include "xfigexporter.h"
+
+#include "../kig/kig_document.h"
+#include "../misc/calcpaths.h"
+#include "../misc/rect.h"
+#include "../misc/screeninfo.h"
+#include "../objects/object_calcer.h"
+#include "../objects/object_type_factory.h"
+#ifdef KIG_ENABLE_PYTHON_SCRIPTING
+#include "../scripting/python_scripter.h"
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <memory>
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QMimeDatabase>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+
+// some filters, like the KGeo one, keep their state in members while
+// loading, so the files they read are loaded one at a time.  Everything
+// else, i.e. loading with the native filters, calculating and
+// exporting, runs in parallel..
+static QMutex loadlock;
+// keeps the lines of different threads apart..
+static QMutex outputlock;
+
+static const char *const vectorformats[] = {"native", "kigz", "kigb", "svg", "pstricks", "tikz", "asymptote", "xfig"};
+
+static bool isImageFormat(const QString &format)
+{
+    return QImageWriter::supportedImageFormats().contains(format.toLatin1());
+}
+
+KigBatchExporter::KigBatchExporter(const QStringList &formats, const QString &outdir, const QSize &size)
+    : mformats(formats)
+    , moutdir(outdir)
+    , msize(size)
+{
+}
+
+QStringList KigBatchExporter::supportedFormats()
+{
+    QStringList ret;
+    for (const char *f : vectorformats)
+        ret << QString::fromLatin1(f);
+    const QList<QByteArray> images = QImageWriter::supportedImageFormats();
+    for (const QByteArray &f : images)
+        ret << QString::fromLatin1(f);
+    return ret;
+}
+
+QString KigBatchExporter::outputFile(const QString &file, const QString &format) const
+{
+    QString ext = format;
+    if (format == QLatin1String("native"))
+        ext = QStringLiteral("kig");
+    else if (format == QLatin1String("pstricks"))
+        ext = QStringLiteral("tex");
+    else if (format == QLatin1String("tikz"))
+        ext = QStringLiteral("tikz");
+    else if (format == QLatin1String("asymptote"))
+        ext = QStringLiteral("asy");
+    else if (format == QLatin1String("xfig"))
+        ext = QStringLiteral("fig");
+
+    QFileInfo fi(file);
+    const QString dir = moutdir.isEmpty() ? fi.absolutePath() : moutdir;
+    return dir + QLatin1Char('/') + fi.completeBaseName() + QLatin1Char('.') + ext;
+}
+
+bool KigBatchExporter::checkOutputFiles(const QStringList &files) const
+{
+    // e.g. "--export-to native foo.kig" would overwrite foo.kig, and
+    // a.kig and a.kigz would both be exported to a.svg, by two threads
+    // at the same time..
+    std::map<QString, QString> inputs;
+    for (const QString &file : files)
+        inputs[QDir::cleanPath(QFileInfo(file).absoluteFilePath())] = file;
+    std::map<QString, QString> outputs;
+    for (const QString &file : files) {
+        for (const QString &format : mformats) {
+            const QString out = QDir::cleanPath(QFileInfo(outputFile(file, format)).absoluteFilePath());
+            std::map<QString, QString>::const_iterator i = inputs.find(out);
+            if (i != inputs.end()) {
+                qCritical().noquote() << "Exporting" << file << "to" << format << "would overwrite" << i->second << "- use --output-dir to write it somewhere else.";
+                return false;
+            }
+            i = outputs.find(out);
+            if (i != outputs.end()) {
+                qCritical().noquote() << "Both" << i->second << "and" << file << "would be exported to" << out;
+                return false;
+            }
+            outputs[out] = file;
+        }
+    }
+    return true;
+}
+
+bool KigBatchExporter::write(const KigDocument &doc, const QString &format, const QString &outfile, const QSize &size)
+{
+    const Rect shown = doc.suggestedRect().matchShape(Rect::fromQRect(QRect(QPoint(0, 0), size)));
+    const ScreenInfo si(shown, QRect(QPoint(0, 0), size));
+
+    if (format == QLatin1String("native") || format == QLatin1String("kigz") || format == QLatin1String("kigb"))
+        return KigFilters::instance()->save(doc, outfile);
+    else if (format == QLatin1String("svg"))
+        return SVGExporter::write(doc, si, outfile, doc.grid(), doc.axes());
+    else if (format == QLatin1String("pstricks"))
+        return LatexExporter::write(doc, si, outfile, LatexExporterOptions::PSTricks, doc.grid(), doc.axes(), false, true);
+    else if (format == QLatin1String("tikz"))
+        return LatexExporter::write(doc, si, outfile, LatexExporterOptions::TikZ, doc.grid(), doc.axes(), false, true);
+    else if (format == QLatin1String("asymptote"))
+        return AsyExporter::write(doc, si, outfile, doc.grid(), doc.axes(), false);
+    else if (format == QLatin1String("xfig"))
+        return XFigExporter::write(doc, si, outfile);
+    else if (isImageFormat(format))
+        return ImageExporter::write(doc, si, outfile, doc.grid(), doc.axes());
+    return false;
+}
+
+bool KigBatchExporter::process(const QString &file) const
+{
+    QElapsedTimer total;
+    total.start();
+    QString report = file + QLatin1Char(':');
+    bool ok = true;
+
+    const QMimeDatabase mimeDb;
+    KigFilter *filter = KigFilters::instance()->find(mimeDb.mimeTypeForFile(file).name());
+    std::unique_ptr<KigDocument> doc;
+    if (filter) {
+        QElapsedTimer t;
+        t.start();
+        {
+            QMutexLocker loading(filter->isReentrant() ? nullptr : &loadlock);
+            doc.reset(filter->load(file));
+        }
+        report += QStringLiteral(" load %1 ms").arg(t.nsecsElapsed() / 1e6, 0, 'f', 1);
+    }
+
+    if (!doc) {
+        report += filter ? QStringLiteral(" FAILED to load") : QStringLiteral(" FAILED, unsupported file type");
+        ok = false;
+    } else {
+        // the filters calc every object while loading, but some of them
+        // build the hierarchy out of order..
+        QElapsedTimer t;
+        t.start();
+        std::vector<ObjectCalcer *> tmp = calcPath(getAllParents(getAllCalcers(doc->objects())));
+        for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
+            (*i)->calc(*doc);
+        report += QStringLiteral(", calc %1 ms").arg(t.nsecsElapsed() / 1e6, 0, 'f', 1);
+
+        for (const QString &format : mformats) {
+            t.restart();
+            const bool written = write(*doc, format, outputFile(file, format), msize);
+            report += QStringLiteral(", %1 %2 ms").arg(format).arg(t.nsecsElapsed() / 1e6, 0, 'f', 1);
+            if (!written) {
+                report += QStringLiteral(" FAILED");
+                ok = false;
+            }
+        }
+    }
+    report += QStringLiteral(", total %1 ms\n").arg(total.nsecsElapsed() / 1e6, 0, 'f', 1);
+
+    QMutexLocker l(&outputlock);
+    fputs(report.toLocal8Bit().constData(), stdout);
+    fflush(stdout);
+    return ok;
+}
+
+int KigBatchExporter::run(const QStringList &files, int jobs) const
+{
+    if (!checkOutputFiles(files))
+        return files.size();
+
+    // nothing here may show a message box, and the singletons have to
+    // exist before the worker threads start using them..
+    KigFilter::setBatchMode(true);
+    KigFilters::instance();
+    ObjectTypeFactory::instance();
+#ifdef KIG_ENABLE_PYTHON_SCRIPTING
+    // python is bound to the thread that starts it, and loci drawn in the
+    // exports may still run scripts..
+    PythonScripter::instance();
+#endif
+    if (!moutdir.isEmpty())
+        QDir().mkpath(moutdir);
+
+    QElapsedTimer total;
+    total.start();
+    std::atomic<int> failures(0);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs > 0 ? jobs : QThread::idealThreadCount());
+    for (const QString &file : files) {
+        pool.start([this, file, &failures]() {
+            if (!process(file))
+                ++failures;
+        });
+    }
+    pool.waitForDone();
+
+    fprintf(stdout,
+            "%lld files, %d failed, %.1f s on %d threads\n",
+            static_cast<long long>(files.size()),
+            failures.load(),
+            total.nsecsElapsed() / 1e9,
+            pool.maxThreadCount());
+    KigFilter::setBatchMode(false);
+    return failures.load();
+}
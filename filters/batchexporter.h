@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <QSize>
+#include <QString>
+#include <QStringList>
+
+class KigDocument;
+
+/**
+ * Converts and exports many files without a GUI, e.g. for
+ * "kig --export-to svg --export-to kig *.fgeo".  Every input file is
+ * read with the KigFilter for its mime type, and then written once for
+ * every requested output format.  The files are processed concurrently
+ * on a thread pool, only the filters that are not
+ * KigFilter::isReentrant() load one file at a time, and the time spent
+ * on each of them is printed on stdout.
+ */
+class KigBatchExporter
+{
+public:
+    /**
+     * \p formats are the names of the output formats, see
+     * supportedFormats().  The output files are written to \p outdir,
+     * or next to the input files if it is empty.  \p size is the size
+     * in pixels of the exported view, it also gives the aspect ratio
+     * for the vector formats.
+     */
+    KigBatchExporter(const QStringList &formats, const QString &outdir, const QSize &size);
+
+    /**
+     * all the format names we understand: native, kigz, kigb, svg,
+     * pstricks, tikz, asymptote, xfig, and the image formats Qt can
+     * write, like png or jpg.
+     */
+    static QStringList supportedFormats();
+
+    /**
+     * Process \p files using \p jobs threads, or one per core if \p
+     * jobs is 0.  Returns the number of files that failed.  Nothing is
+     * done, and every file fails, if an output file would overwrite an
+     * input file or another output file.
+     */
+    int run(const QStringList &files, int jobs) const;
+
+    /**
+     * Write \p doc to \p outfile in \p format, one of
+     * supportedFormats(), showing what fits in a view of \p size
+     * pixels.  The objects of \p doc must have been calculated.
+     */
+    static bool write(const KigDocument &doc, const QString &format, const QString &outfile, const QSize &size);
+
+private:
+    bool process(const QString &file) const;
+    QString outputFile(const QString &file, const QString &format) const;
+    /**
+     * complains on stderr and returns false if two of the files we
+     * would read and write are the same..
+     */
+    bool checkOutputFiles(const QStringList &files) const;
+
+    QStringList mformats;
+    QString moutdir;
+    QSize msize;
+};
@@ -730,8 +730,10 @@ KigDocument *KigFilterDrgeo::importFigure(const QDomNode &f, const bool grid)
         }
     }
 
+    ret->beginTransaction();
     ret->addObjects(holders);
     ret->addObjects(holders2);
+    ret->commitTransaction();
     ret->setGrid(grid);
     ret->setAxes(grid);
     return ret;
@@ -17,6 +17,7 @@
 #include "../misc/kigfiledialog.h"
 #include "../misc/kigpainter.h"
 
+#include <QImage>
 #include <QImageWriter>
 #include <QMimeDatabase>
 #include <QStandardPaths>
@@ -109,19 +110,36 @@ void ImageExporter::run(const KigPart &doc, KigWidget &w)
         return;
     };
 
-    QPixmap img(imgsize);
-    img.fill(Qt::white);
-    KigPainter p(ScreenInfo(w.screenInfo().shownRect(), img.rect()), &img, doc.document());
-    p.setWholeWinOverlay();
-    p.drawGrid(doc.document().coordinateSystem(), showgrid, showaxes);
-    // FIXME: show the selections ?
-    p.drawObjects(doc.document().objects(), false);
+    file.close();
+
+    if (!write(doc.document(), ScreenInfo(w.screenInfo().shownRect(), QRect(QPoint(0, 0), imgsize)), filename, showgrid, showaxes)) {
+        KMessageBox::error(&w, i18n("Sorry, something went wrong while saving to image \"%1\"", filename));
+    }
+}
+
+bool ImageExporter::write(const KigDocument &doc, const ScreenInfo &si, const QString &filename, bool showgrid, bool showaxes)
+{
+    QMimeDatabase db;
+    QMimeType mimeType = db.mimeTypeForFile(filename, QMimeDatabase::MatchExtension);
+    if (!QImageWriter::supportedMimeTypes().contains(mimeType.name().toUtf8()))
+        return false;
     const QStringList types = mimeType.suffixes();
     if (types.isEmpty())
-        return; // TODO error dialog?
-    if (!img.save(filename, types.at(0).toLatin1())) {
-        KMessageBox::error(&w, i18n("Sorry, something went wrong while saving to image \"%1\"", filename));
+        return false;
+
+    // a QImage, not a QPixmap, so that this also works outside of the
+    // GUI thread..
+    QImage img(si.viewRect().size(), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::white);
+    {
+        KigPainter p(ScreenInfo(si.shownRect(), img.rect()), &img, doc);
+        p.setWholeWinOverlay();
+        p.drawGrid(doc.coordinateSystem(), showgrid, showaxes);
+        // FIXME: show the selections ?
+        p.drawObjects(doc.objects(), false);
     }
+
+    return img.save(filename, types.at(0).toLatin1());
 }
 
 KigExportManager::KigExportManager()
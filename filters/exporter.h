@@ -9,9 +9,11 @@
 #include <vector>
 
 class QString;
+class KigDocument;
 class KigPart;
 class KigWidget;
 class KActionCollection;
+class ScreenInfo;
 
 class KigExporter;
 
@@ -82,4 +84,11 @@ public:
     QString menuEntryName() const override;
     QString menuIcon() const override;
     void run(const KigPart &doc, KigWidget &w) override;
+
+    /**
+     * Render the part \p si of \p doc to the image file \p file,
+     * without asking the user anything.  The image format is taken
+     * from the file name.  Returns false on failure.
+     */
+    static bool write(const KigDocument &doc, const ScreenInfo &si, const QString &file, bool showgrid, bool showaxes);
 };
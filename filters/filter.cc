@@ -11,15 +11,19 @@
 #include "drgeo-filter.h"
 #include "kgeo-filter.h"
 #include "kseg-filter.h"
+#include "native-binary-filter.h"
 #include "native-filter.h"
-#ifdef WITH_GEOGEBRA
 #include "geogebra-filter.h"
-#endif // WITH_GEOGEBRA
+
+#include "../misc/kigtracer.h"
+
+#include <QDebug>
 
 #include <KLocalizedString>
 #include <KMessageBox>
 
 KigFilters *KigFilters::sThis;
+bool KigFilter::sBatchMode = false;
 
 KigFilter *KigFilters::find(const QString &mime)
 {
@@ -36,10 +40,9 @@ KigFilters::KigFilters()
     mFilters.push_back(KigFilterKSeg::instance());
     mFilters.push_back(KigFilterCabri::instance());
     mFilters.push_back(KigFilterNative::instance());
+    mFilters.push_back(KigFilterNativeBinary::instance());
     mFilters.push_back(KigFilterDrgeo::instance());
-#ifdef WITH_GEOGEBRA
     mFilters.push_back(KigFilterGeogebra::instance());
-#endif // WITH_GEOGEBRA
 }
 
 KigFilters *KigFilters::instance()
@@ -60,8 +63,22 @@ bool KigFilter::supportMime(const QString &)
     return false;
 }
 
+bool KigFilter::isReentrant() const
+{
+    return false;
+}
+
+void KigFilter::setBatchMode(bool batch)
+{
+    sBatchMode = batch;
+}
+
 void KigFilter::fileNotFound(const QString &file) const
 {
+    if (sBatchMode) {
+        qWarning() << "The file" << file << "could not be opened.";
+        return;
+    }
     KMessageBox::error(nullptr,
                        i18n("The file \"%1\" could not be opened.  "
                             "This probably means that it does not "
@@ -77,6 +94,11 @@ void KigFilter::parseError(const QString &explanation) const
         "cannot be opened.");
     const QString title = i18n("Parse Error");
 
+    if (sBatchMode) {
+        qWarning().noquote() << text << explanation;
+        return;
+    }
+
     if (explanation.isEmpty())
         KMessageBox::error(nullptr, text, title);
     else
@@ -85,15 +107,26 @@ void KigFilter::parseError(const QString &explanation) const
 
 void KigFilter::notSupported(const QString &explanation) const
 {
+    if (sBatchMode) {
+        qWarning().noquote() << "Kig cannot open this file:" << explanation;
+        return;
+    }
     KMessageBox::detailedError(nullptr, i18n("Kig cannot open this file."), explanation, i18n("Not Supported"));
 }
 
 void KigFilter::warning(const QString &explanation) const
 {
+    if (sBatchMode) {
+        qWarning().noquote() << explanation;
+        return;
+    }
     KMessageBox::information(nullptr, explanation);
 }
 
 bool KigFilters::save(const KigDocument &data, const QString &tofile)
 {
+    KigTracer::Span span("save", "file");
+    if (tofile.endsWith(QLatin1String(".kigb"), Qt::CaseInsensitive))
+        return KigFilterNativeBinary::instance()->save(data, tofile);
     return KigFilterNative::instance()->save(data, tofile);
 }
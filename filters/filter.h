@@ -22,8 +22,8 @@ public:
     KigFilter *find(const QString &mime);
 
     /**
-     * saving is always done with the native filter.  We don't support
-     * output filters.
+     * saving is always done with the native filter, or its binary
+     * variant for *.kigb files.  We don't support output filters.
      */
     bool save(const KigDocument &data, const QString &outfile);
 
@@ -62,10 +62,19 @@ protected:
     void notSupported(const QString &explanation) const;
     void warning(const QString &explanation) const;
 
+    static bool sBatchMode;
+
 public:
     KigFilter();
     virtual ~KigFilter();
 
+    /**
+     * In batch mode, the error functions above print to stderr instead
+     * of showing a message box, so that the filters can be used without
+     * a GUI, and from other threads than the GUI thread.
+     */
+    static void setBatchMode(bool batch);
+
     /**
      * can the filter handle the mimetype \p mime ?
      */
@@ -80,4 +89,12 @@ public:
      * the returned KigDocument ( that was allocated with "new" ).
      */
     virtual KigDocument *load(const QString &fromfile) = 0;
+
+    /**
+     * can load() run on more than one thread at the same time ?  Some
+     * filters keep their state in members or statics while loading, so
+     * the default is no, and the batch exporter loads the files of such
+     * filters one at a time.
+     */
+    virtual bool isReentrant() const;
 };
@@ -4,11 +4,16 @@
 
 #include "filters-common.h"
 
+#include <cmath>
+#include <stack>
+#include <utility>
 #include <vector>
 
 #include <QByteArray>
 #include <QString>
 
+#include "../misc/rect.h"
+#include "../objects/curve_imp.h"
 #include "../objects/object_calcer.h"
 #include "../objects/object_factory.h"
 
@@ -21,3 +26,165 @@ ObjectTypeCalcer *filtersConstructTextObject(const Coordinate &c, ObjectCalcer *
     args.push_back(propo);
     return fact->labelCalcer(QStringLiteral("%1"), c, needframe, args, doc);
 }
+
+struct CurveSample {
+    double t;
+    Coordinate p;
+    // valid, and not too far from the window..
+    bool ok;
+};
+
+static CurveSample makeSample(const Rect &box, double t, const Coordinate &p)
+{
+    CurveSample s;
+    s.t = t;
+    s.p = p;
+    s.ok = s.p.valid() && box.contains(s.p);
+    return s;
+}
+
+static CurveSample sampleCurve(const CurveImp *curve, const KigDocument &doc, const Rect &box, double t)
+{
+    return makeSample(box, t, curve->getPoint(t, doc));
+}
+
+static double distanceToSegment(const Coordinate &p, const Coordinate &a, const Coordinate &b)
+{
+    const Coordinate d = b - a;
+    const double l = d.squareLength();
+    if (l == 0.)
+        return (p - a).length();
+    double u = ((p - a) * d) / l;
+    u = std::fmax(0., std::fmin(1., u));
+    return (p - (a + d * u)).length();
+}
+
+void filtersSimplifyPolyline(std::vector<Coordinate> &line, double tolerance)
+{
+    if (line.size() < 3)
+        return;
+    std::vector<bool> keep(line.size(), false);
+    keep.front() = true;
+    keep.back() = true;
+    std::stack<std::pair<uint, uint>> ranges;
+    ranges.push(std::make_pair(0u, static_cast<uint>(line.size() - 1)));
+    while (!ranges.empty()) {
+        const uint first = ranges.top().first;
+        const uint last = ranges.top().second;
+        ranges.pop();
+        double maxdist = 0.;
+        uint maxi = first;
+        for (uint i = first + 1; i < last; ++i) {
+            const double d = distanceToSegment(line[i], line[first], line[last]);
+            if (d > maxdist) {
+                maxdist = d;
+                maxi = i;
+            }
+        }
+        if (maxdist > tolerance) {
+            keep[maxi] = true;
+            ranges.push(std::make_pair(first, maxi));
+            ranges.push(std::make_pair(maxi, last));
+        }
+    }
+    uint j = 0;
+    for (uint i = 0; i < line.size(); ++i)
+        if (keep[i])
+            line[j++] = line[i];
+    line.resize(j);
+}
+
+static void flushPolyline(std::vector<std::vector<Coordinate>> &ret, std::vector<Coordinate> &cur)
+{
+    if (cur.size() > 1)
+        ret.push_back(cur);
+    cur.clear();
+}
+
+static void continuePolyline(std::vector<std::vector<Coordinate>> &ret, std::vector<Coordinate> &cur, const Coordinate &p)
+{
+    // the intervals are processed from left to right, so if the last
+    // point isn't where this one starts, something was left out..
+    if (!cur.empty() && cur.back() != p)
+        flushPolyline(ret, cur);
+    if (cur.empty())
+        cur.push_back(p);
+}
+
+std::vector<std::vector<Coordinate>> filtersTessellateCurve(const CurveImp *curve, const KigDocument &doc, const Rect &window, double tolerance)
+{
+    // points this far outside the window are left out, this is what
+    // cuts off the branches of hyperbolas and the like that go to
+    // infinity..
+    const Rect w = window.normalized();
+    const Rect box(w.left() - w.width(), w.bottom() - w.height(), 3 * w.width(), 3 * w.height());
+
+    // half of the tolerance is for the sampling, the other half for
+    // the simplification..
+    const double sigma = tolerance / 2;
+    // two points further apart than this at the finest subdivision are
+    // on different pieces of the curve..
+    const double maxjump = 10 * tolerance;
+    // the intervals are never larger than hmax, and never smaller than
+    // hmin..
+    const double hmax = 1. / 64;
+    const double hmin = 1e-9;
+    static const int maxsamples = 50000;
+
+    std::vector<std::vector<Coordinate>> ret;
+    std::vector<Coordinate> cur;
+
+    // we don't use recursion, but a stack of parameter intervals, that
+    // are pushed so that they are popped from left to right..
+    std::stack<std::pair<CurveSample, CurveSample>> work;
+    // the initial samples are computed in one go, which is a lot
+    // cheaper for loci through python scripts..
+    std::vector<double> params;
+    for (int i = 0; i <= 64; ++i)
+        params.push_back(i * hmax);
+    const std::vector<Coordinate> points = curve->getPoints(params, doc);
+    std::vector<CurveSample> initial;
+    for (int i = 0; i <= 64; ++i)
+        initial.push_back(makeSample(box, params[i], points[i]));
+    for (int i = 63; i >= 0; --i)
+        work.push(std::make_pair(initial[i], initial[i + 1]));
+    int count = initial.size();
+
+    while (!work.empty()) {
+        const CurveSample a = work.top().first;
+        const CurveSample b = work.top().second;
+        work.pop();
+        const double h = b.t - a.t;
+        const CurveSample m = sampleCurve(curve, doc, box, (a.t + b.t) / 2);
+        ++count;
+
+        if (!a.ok && !b.ok && !m.ok && h <= hmax / 4) {
+            // nothing to see here..
+            flushPolyline(ret, cur);
+        } else if (a.ok && b.ok && m.ok && h <= hmax && distanceToSegment(m.p, a.p, b.p) <= sigma) {
+            // flat enough
+            continuePolyline(ret, cur, a.p);
+            cur.push_back(m.p);
+            cur.push_back(b.p);
+        } else if (h < hmin || count >= maxsamples) {
+            // we can't subdivide any further, this is either the end of
+            // a piece of the curve, a jump, or a very sharp corner..
+            if (a.ok && b.ok && (b.p - a.p).length() <= maxjump) {
+                continuePolyline(ret, cur, a.p);
+                cur.push_back(b.p);
+            } else {
+                if (a.ok)
+                    continuePolyline(ret, cur, a.p);
+                flushPolyline(ret, cur);
+            }
+        } else {
+            work.push(std::make_pair(m, b));
+            work.push(std::make_pair(a, m));
+        }
+    }
+    flushPolyline(ret, cur);
+
+    for (std::vector<std::vector<Coordinate>>::iterator i = ret.begin(); i != ret.end(); ++i)
+        filtersSimplifyPolyline(*i, sigma);
+    return ret;
+}
@@ -4,14 +4,37 @@
 
 #pragma once
 
+#include <vector>
+
+#include "../misc/coordinate.h"
+
 class ObjectTypeCalcer;
-class Coordinate;
 class ObjectCalcer;
 class QByteArray;
 class KigDocument;
+class CurveImp;
+class Rect;
 
 /**
  * constructs a text object with text "%1", location \p c, and variable
  * parts given by the argument \p arg of obj \p o.
  */
 ObjectTypeCalcer *filtersConstructTextObject(const Coordinate &c, ObjectCalcer *o, const QByteArray &arg, const KigDocument &doc, bool needframe);
+
+/**
+ * approximates \p curve with polylines that are never further than
+ * \p tolerance from it, for the exporters that write curves as lists
+ * of coordinates.  The parameter interval is subdivided where the
+ * curve bends, so straight parts only cost a few points.  The curve is
+ * broken up where it is invalid, where it jumps, and where it leaves
+ * the neighbourhood of \p window, and every polyline is simplified
+ * afterwards.  Polylines with less than two points are not returned.
+ */
+std::vector<std::vector<Coordinate>> filtersTessellateCurve(const CurveImp *curve, const KigDocument &doc, const Rect &window, double tolerance);
+
+/**
+ * Douglas-Peucker: drop the points of \p line that are within \p
+ * tolerance of the polyline through the remaining ones.  The first
+ * and the last point are always kept.
+ */
+void filtersSimplifyPolyline(std::vector<Coordinate> &line, double tolerance);
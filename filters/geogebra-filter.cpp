@@ -19,10 +19,8 @@
 #include <KZip>
 #include <QDebug>
 
-#include <QFile>
-#include <QXmlQuery>
-
 #include <algorithm>
+#include <memory>
 
 KigFilterGeogebra *KigFilterGeogebra::instance()
 {
@@ -49,19 +47,16 @@ KigDocument *KigFilterGeogebra::load(const QString &sFrom)
         const KZipFileEntry *geogebraXMLEntry = dynamic_cast<const KZipFileEntry *>(geogebraFile.directory()->entry(QStringLiteral("geogebra.xml")));
 
         if (geogebraXMLEntry) {
-            QXmlNamePool np;
-            QXmlQuery geogebraXSLT(QXmlQuery::XSLT20, np);
-            const QString encodedData = QString::fromUtf8(geogebraXMLEntry->data().constData());
-            QFile queryDevice(QStringLiteral(":/kig/geogebra/geogebra.xsl"));
-            GeogebraTransformer ggbtransform(document, np);
-
-            queryDevice.open(QFile::ReadOnly);
-            geogebraXSLT.setFocus(encodedData);
-            geogebraXSLT.setQuery(&queryDevice);
-            geogebraXSLT.evaluateTo(&ggbtransform);
-            queryDevice.close();
-
-            assert(ggbtransform.getNumberOfSections() == 1);
+            // read the xml straight out of the archive, without keeping a
+            // copy of it in memory..
+            std::unique_ptr<QIODevice> dev(geogebraXMLEntry->createDevice());
+            GeogebraTransformer ggbtransform(document);
+            ggbtransform.transform(dev.get());
+
+            if (ggbtransform.getNumberOfSections() == 0) {
+                qWarning() << "No construction found in the GeoGebra file";
+                return document;
+            }
 
             const GeogebraSection &gs = ggbtransform.getSection(0);
             const std::vector<ObjectCalcer *> &f = gs.getOutputObjects();
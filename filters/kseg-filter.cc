@@ -670,8 +670,10 @@ KigDocument *KigFilterKSeg::load(const QString &file)
     };
 
     // no more data in the file.
+    retdoc->beginTransaction();
     retdoc->addObjects(ret);
     retdoc->addObjects(ret2);
+    retdoc->commitTransaction();
     retdoc->setAxes(false);
     retdoc->setGrid(false);
     return retdoc;
@@ -8,6 +8,7 @@
 #include "latexexporteroptions.h"
 
 #include "asyexporterimpvisitor.h"
+#include "filters-common.h"
 #include "pgfexporterimpvisitor.h"
 
 #include "../kig/kig_document.h"
@@ -77,7 +78,8 @@ class PSTricksExportImpVisitor : public ObjectImpVisitor
 {
     QTextStream &mstream;
     ObjectHolder *mcurobj;
-    const KigWidget &mw;
+    const KigDocument &mdoc;
+    const ScreenInfo msi;
     Rect msr;
     std::vector<ColorMap> mcolors;
     QString mcurcolorid;
@@ -86,10 +88,11 @@ public:
     void visit(ObjectHolder *obj);
     void mapColor(const QColor &color);
 
-    PSTricksExportImpVisitor(QTextStream &s, const KigWidget &w)
+    PSTricksExportImpVisitor(QTextStream &s, const KigDocument &doc, const ScreenInfo &si)
         : mstream(s)
-        , mw(w)
-        , msr(mw.showingRect())
+        , mdoc(doc)
+        , msi(si)
+        , msr(si.shownRect())
     {
     }
     using ObjectImpVisitor::visit;
@@ -195,7 +198,7 @@ void PSTricksExportImpVisitor::mapColor(const QColor &color)
 double PSTricksExportImpVisitor::dimRealToCoord(int dim)
 {
     QRect qr(0, 0, dim, dim);
-    Rect r = mw.screenInfo().fromScreen(qr);
+    Rect r = msi.fromScreen(qr);
     return fabs(r.width());
 }
 
@@ -217,50 +220,14 @@ void PSTricksExportImpVisitor::plotGenericCurve(const CurveImp *imp)
     if (width == -1)
         width = 1;
 
-    QString prefix = QStringLiteral("\\pscurve[linecolor=%1,linewidth=%2,%3]").arg(mcurcolorid).arg(width / 100.0).arg(writeStyle(mcurobj->drawer()->style()));
-
-    std::vector<std::vector<Coordinate>> coordlist;
-    coordlist.push_back(std::vector<Coordinate>());
-    uint curid = 0;
-
-    Coordinate c;
-    Coordinate prev = Coordinate::invalidCoord();
-    for (double i = 0.0; i <= 1.0; i += 0.005) {
-        c = imp->getPoint(i, mw.document());
-        if (!c.valid()) {
-            if (coordlist[curid].size() > 0) {
-                coordlist.push_back(std::vector<Coordinate>());
-                ++curid;
-                prev = Coordinate::invalidCoord();
-            }
-            continue;
-        }
-        if (!((fabs(c.x) <= 1000) && (fabs(c.y) <= 1000)))
-            continue;
-        // if there's too much distance between this coordinate and the previous
-        // one, then it's another piece of curve not joined with the rest
-        if (prev.valid() && (c.distance(prev) > 4.0)) {
-            coordlist.push_back(std::vector<Coordinate>());
-            ++curid;
-        }
-        coordlist[curid].push_back(c);
-        prev = c;
-    }
-    // special case for ellipse
-    if (const ConicImp *conic = dynamic_cast<const ConicImp *>(imp)) {
-        // if ellipse, close its path
-        if (conic->conicType() == 1 && coordlist.size() == 1 && coordlist[0].size() > 1) {
-            coordlist[0].push_back(coordlist[0][0]);
-        }
-    }
-    for (uint i = 0; i < coordlist.size(); ++i) {
-        uint s = coordlist[i].size();
-        // there's no point in draw curves empty or with only one point
-        if (s <= 1)
-            continue;
+    // the points are an accurate polyline approximation, a \pscurve
+    // through them would only overshoot..
+    QString prefix = QStringLiteral("\\psline[linecolor=%1,linewidth=%2,%3]").arg(mcurcolorid).arg(width / 100.0).arg(writeStyle(mcurobj->drawer()->style()));
 
+    const std::vector<std::vector<Coordinate>> coordlist = filtersTessellateCurve(imp, mdoc, msr, msi.pixelWidth() / 4);
+    for (uint i = 0; i < coordlist.size(); ++i) {
         mstream << prefix;
-        for (uint j = 0; j < s; ++j)
+        for (uint j = 0; j < coordlist[i].size(); ++j)
             emitCoord(coordlist[i][j]);
         newLine();
     }
@@ -391,10 +358,9 @@ void PSTricksExportImpVisitor::visit(const ConicImp *imp)
     plotGenericCurve(imp);
 }
 
-void PSTricksExportImpVisitor::visit(const CubicImp *)
+void PSTricksExportImpVisitor::visit(const CubicImp *imp)
 {
-    // FIXME: cubic are not drawn correctly with plotGenericCurve
-    //  plotGenericCurve( imp );
+    plotGenericCurve(imp);
 }
 
 void PSTricksExportImpVisitor::visit(const SegmentImp *imp)
@@ -541,17 +507,29 @@ void LatexExporter::run(const KigPart &doc, KigWidget &w)
     cg.writeEntry("OutputFormat", (int)format);
     cg.writeEntry("Standalone", standalone);
 
-    QFile file(file_name);
-    if (!file.open(QIODevice::WriteOnly)) {
+    if (!write(doc.document(), w.screenInfo(), file_name, format, showgrid, showaxes, showframe, standalone)) {
         KMessageBox::error(&w,
                            i18n("The file \"%1\" could not be opened. Please "
                                 "check if the file permissions are set correctly.",
                                 file_name));
-        return;
-    };
+    }
+}
+
+bool LatexExporter::write(const KigDocument &doc,
+                          const ScreenInfo &si,
+                          const QString &file_name,
+                          int format,
+                          bool showgrid,
+                          bool showaxes,
+                          bool showframe,
+                          bool standalone)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
 
     QTextStream stream(&file);
-    std::vector<ObjectHolder *> os = doc.document().objects();
+    std::vector<ObjectHolder *> os = doc.objects();
 
     if (format == LatexExporterOptions::PSTricks) {
         if (standalone) {
@@ -563,10 +541,10 @@ void LatexExporter::run(const KigPart &doc, KigWidget &w)
             stream << "\\begin{document}\n";
         }
 
-        const double bottom = w.showingRect().bottom();
-        const double left = w.showingRect().left();
-        const double height = w.showingRect().height();
-        const double width = w.showingRect().width();
+        const double bottom = si.shownRect().bottom();
+        const double left = si.shownRect().left();
+        const double height = si.shownRect().height();
+        const double width = si.shownRect().width();
 
         /*
           // TODO: calculating aspect ratio...
@@ -583,7 +561,7 @@ void LatexExporter::run(const KigPart &doc, KigWidget &w)
         stream << "\\psset{xunit=" << xunit << "}\n";
         stream << "\\psset{yunit=" << yunit << "}\n";
 
-        PSTricksExportImpVisitor visitor(stream, w);
+        PSTricksExportImpVisitor visitor(stream, doc, si);
         visitor.unit = xunit;
 
         for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i) {
@@ -650,9 +628,9 @@ void LatexExporter::run(const KigPart &doc, KigWidget &w)
             stream << "\\usepgflibrary{fpu}\n";
             stream << "\\begin{document}\n";
         }
-        PGFExporterImpVisitor visitor(stream, w);
+        PGFExporterImpVisitor visitor(stream, doc, si);
 
-        Rect frameRect = w.showingRect();
+        Rect frameRect = si.shownRect();
 
         double size = qMax(frameRect.height(), frameRect.width());
         double scale = (size == 0) ? 1 : 10 / size;
@@ -706,10 +684,10 @@ void LatexExporter::run(const KigPart &doc, KigWidget &w)
         }
 
     } else if (format == LatexExporterOptions::Asymptote) {
-        const double bottom = w.showingRect().bottom();
-        const double left = w.showingRect().left();
-        const double height = w.showingRect().height();
-        const double width = w.showingRect().width();
+        const double bottom = si.shownRect().bottom();
+        const double left = si.shownRect().left();
+        const double height = si.shownRect().height();
+        const double width = si.shownRect().width();
 
         if (standalone) {
             // The header if we embed into latex
@@ -751,7 +729,7 @@ void LatexExporter::run(const KigPart &doc, KigWidget &w)
         }
 
         // Visit all the objects
-        AsyExporterImpVisitor visitor(stream, w);
+        AsyExporterImpVisitor visitor(stream, doc, si);
 
         for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i) {
             visitor.visit(*i);
@@ -776,4 +754,5 @@ void LatexExporter::run(const KigPart &doc, KigWidget &w)
 
     // And close the output file
     file.close();
+    return true;
 }
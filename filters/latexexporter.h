@@ -7,8 +7,10 @@
 #include "exporter.h"
 
 class QString;
+class KigDocument;
 class KigPart;
 class KigWidget;
+class ScreenInfo;
 
 /**
  * Export to LaTex.
@@ -21,4 +23,19 @@ public:
     QString menuEntryName() const override;
     QString menuIcon() const override;
     void run(const KigPart &doc, KigWidget &w) override;
+
+    /**
+     * Write the part \p si of \p doc to \p file, without asking the
+     * user anything.  \p format is one of
+     * LatexExporterOptions::LatexOutputFormat.  Returns false if the
+     * file could not be written.
+     */
+    static bool write(const KigDocument &doc,
+                      const ScreenInfo &si,
+                      const QString &file,
+                      int format,
+                      bool showgrid,
+                      bool showaxes,
+                      bool showframe,
+                      bool standalone);
 };
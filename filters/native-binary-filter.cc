@@ -0,0 +1,467 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "native-binary-filter.h"
+
+#include "../kig/kig_document.h"
+#include "../misc/calcpaths.h"
+#include "../misc/coordinate_system.h"
+#include "../objects/bogus_imp.h"
+#include "../objects/object_calcer.h"
+#include "../objects/object_drawer.h"
+#include "../objects/object_holder.h"
+#include "../objects/object_imp.h"
+#include "../objects/object_imp_factory.h"
+#include "../objects/object_type.h"
+#include "../objects/object_type_factory.h"
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <QDomDocument>
+#include <QFile>
+#include <QFont>
+#include <QtEndian>
+
+#include <KLocalizedString>
+
+static const quint32 binaryMagic = 0x4247494b; // "KIGB"
+static const quint32 binaryVersion = 1;
+static const quint32 noIndex = 0xffffffff;
+
+static const int headerWords = 10;
+static const int calcerWords = 6;
+static const int holderWords = 6;
+
+enum { GridFlag = 1, AxesFlag = 2 };
+enum { ShownFlag = 1 };
+
+// the kinds of calcer records
+enum { DataPacked = 0, DataXml, PropertyCalcer, TypeCalcer };
+
+static void putU32(QByteArray &a, quint32 v)
+{
+    v = qToLittleEndian(v);
+    a.append(reinterpret_cast<const char *>(&v), 4);
+}
+
+static void pad(QByteArray &a, int align)
+{
+    while (a.size() % align)
+        a.append('\0');
+}
+
+static void putF64(QByteArray &a, double d)
+{
+    quint64 v;
+    memcpy(&v, &d, 8);
+    v = qToLittleEndian(v);
+    a.append(reinterpret_cast<const char *>(&v), 8);
+}
+
+static quint32 getU32(const uchar *p)
+{
+    return qFromLittleEndian<quint32>(p);
+}
+
+static double getF64(const uchar *p)
+{
+    const quint64 v = qFromLittleEndian<quint64>(p);
+    double d;
+    memcpy(&d, &v, 8);
+    return d;
+}
+
+KigFilterNativeBinary::KigFilterNativeBinary()
+{
+}
+
+KigFilterNativeBinary::~KigFilterNativeBinary()
+{
+}
+
+KigFilterNativeBinary *KigFilterNativeBinary::instance()
+{
+    static KigFilterNativeBinary f;
+    return &f;
+}
+
+bool KigFilterNativeBinary::supportMime(const QString &mime)
+{
+    return mime == QLatin1String("application/x-kig-binary");
+}
+
+bool KigFilterNativeBinary::isReentrant() const
+{
+    return true;
+}
+
+KigDocument *KigFilterNativeBinary::load(const QString &file)
+{
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) {
+        fileNotFound(file);
+        return nullptr;
+    }
+
+    // we map the file, so nothing is copied before we actually need
+    // it..  If that's not possible, we just read it.
+    const qint64 size = f.size();
+    uchar *data = f.map(0, size);
+    if (data) {
+        KigDocument *ret = load(data, size);
+        f.unmap(data);
+        return ret;
+    }
+    QByteArray contents = f.readAll();
+    return load(reinterpret_cast<const uchar *>(contents.constData()), contents.size());
+}
+
+KigDocument *KigFilterNativeBinary::load(const uchar *data, qint64 size)
+{
+    if (size < headerWords * 4)
+        KIG_FILTER_PARSE_ERROR;
+    if (getU32(data) != binaryMagic)
+        KIG_FILTER_PARSE_ERROR;
+    const quint32 version = getU32(data + 4);
+    if (version > binaryVersion) {
+        notSupported(
+            i18n("This file was written in version %1 of the binary Kig "
+                 "format, which this Kig version cannot open.",
+                 version));
+        return nullptr;
+    }
+    const quint32 flags = getU32(data + 8);
+    const quint32 csname = getU32(data + 12);
+    const quint32 nstrings = getU32(data + 16);
+    const quint32 ncalcers = getU32(data + 20);
+    const quint32 nparents = getU32(data + 24);
+    const quint32 nholders = getU32(data + 28);
+    const quint32 payloadsize = getU32(data + 32);
+    const quint32 stringsize = getU32(data + 36);
+
+    // check that all the tables fit in the file before looking at any
+    // of them..
+    const qint64 stringsoff = headerWords * 4;
+    const qint64 calcersoff = stringsoff + stringsize;
+    const qint64 parentsoff = calcersoff + qint64(ncalcers) * calcerWords * 4;
+    const qint64 holdersoff = parentsoff + qint64(nparents) * 4;
+    const qint64 payloadoff = holdersoff + qint64(nholders) * holderWords * 4;
+    if (stringsize % 4 || payloadoff + payloadsize > size)
+        KIG_FILTER_PARSE_ERROR;
+
+    std::vector<QByteArray> strings;
+    strings.reserve(nstrings);
+    for (qint64 off = stringsoff; strings.size() < nstrings;) {
+        if (off + 4 > calcersoff)
+            KIG_FILTER_PARSE_ERROR;
+        const quint32 len = getU32(data + off);
+        off += 4;
+        if (off + len > calcersoff)
+            KIG_FILTER_PARSE_ERROR;
+        strings.push_back(QByteArray(reinterpret_cast<const char *>(data + off), len));
+        off += (len + 3) & ~3;
+    }
+    if (csname >= nstrings)
+        KIG_FILTER_PARSE_ERROR;
+
+    KigDocument *ret = new KigDocument();
+    ret->setGrid(flags & GridFlag);
+    ret->setAxes(flags & AxesFlag);
+
+    CoordinateSystem *s = CoordinateSystemFactory::build(strings[csname].constData());
+    if (!s) {
+        warning(
+            i18n("This Kig file has a coordinate system "
+                 "that this Kig version does not support.\n"
+                 "A standard coordinate system will be used "
+                 "instead."));
+    } else
+        ret->setCoordinateSystem(s);
+
+    // every type name is only looked up once..
+    std::vector<const ObjectType *> types(nstrings, nullptr);
+
+    std::vector<ObjectCalcer::shared_ptr> calcers;
+    calcers.reserve(ncalcers);
+    for (quint32 i = 0; i < ncalcers; ++i) {
+        const uchar *rec = data + calcersoff + qint64(i) * calcerWords * 4;
+        const quint32 kind = getU32(rec);
+        const quint32 name = getU32(rec + 4);
+        const quint32 firstparent = getU32(rec + 8);
+        const quint32 parentcount = getU32(rec + 12);
+        const quint32 poff = getU32(rec + 16);
+        const quint32 psize = getU32(rec + 20);
+        if (name >= nstrings)
+            KIG_FILTER_PARSE_ERROR;
+        if (qint64(firstparent) + parentcount > nparents)
+            KIG_FILTER_PARSE_ERROR;
+        if (qint64(poff) + psize > payloadsize)
+            KIG_FILTER_PARSE_ERROR;
+
+        // the calcers are stored in calc order, so the parents always
+        // come first..
+        std::vector<ObjectCalcer *> parents;
+        parents.reserve(parentcount);
+        for (quint32 j = 0; j < parentcount; ++j) {
+            const quint32 pid = getU32(data + parentsoff + qint64(firstparent + j) * 4);
+            if (pid >= i)
+                KIG_FILTER_PARSE_ERROR;
+            parents.push_back(calcers[pid].get());
+        }
+
+        const uchar *payload = data + payloadoff + poff;
+        ObjectCalcer *o = nullptr;
+        if (kind == DataPacked) {
+            if (!parents.empty())
+                KIG_FILTER_PARSE_ERROR;
+            ObjectImp *imp = nullptr;
+            const QByteArray &type = strings[name];
+            if (type == "int" && psize == 4)
+                imp = new IntImp(static_cast<qint32>(getU32(payload)));
+            else if (type == "double" && psize == 8)
+                imp = new DoubleImp(getF64(payload));
+            else if (type == "string")
+                imp = new StringImp(QString::fromUtf8(reinterpret_cast<const char *>(payload), psize));
+            else
+                KIG_FILTER_PARSE_ERROR;
+            o = new ObjectConstCalcer(imp);
+        } else if (kind == DataXml) {
+            if (!parents.empty())
+                KIG_FILTER_PARSE_ERROR;
+            QDomDocument doc;
+            if (!doc.setContent(QByteArray::fromRawData(reinterpret_cast<const char *>(payload), psize)))
+                KIG_FILTER_PARSE_ERROR;
+            QString error;
+            ObjectImp *imp = ObjectImpFactory::instance()->deserialize(QString::fromLatin1(strings[name]), doc.documentElement(), error);
+            if ((!imp) && !error.isEmpty()) {
+                parseError(error);
+                return nullptr;
+            }
+            o = new ObjectConstCalcer(imp);
+        } else if (kind == PropertyCalcer) {
+            if (parents.size() != 1)
+                KIG_FILTER_PARSE_ERROR;
+            if (parents[0]->imp()->propertiesInternalNames().indexOf(strings[name]) == -1)
+                KIG_FILTER_PARSE_ERROR;
+            o = new ObjectPropertyCalcer(parents[0], strings[name].constData());
+        } else if (kind == TypeCalcer) {
+            if (!types[name]) {
+                types[name] = ObjectTypeFactory::instance()->find(strings[name].constData());
+                if (!types[name]) {
+                    notSupported(
+                        i18n("This Kig file uses an object of type \"%1\", "
+                             "which this Kig version does not support."
+                             "Perhaps you have compiled Kig without support "
+                             "for this object type,"
+                             "or perhaps you are using an older Kig version.",
+                             QString::fromLatin1(strings[name])));
+                    return nullptr;
+                }
+            }
+            // like the XML loader, we don't sort the arguments, they
+            // were saved from a working hierarchy..
+            o = new ObjectTypeCalcer(types[name], parents, false);
+        } else
+            KIG_FILTER_PARSE_ERROR;
+
+        o->calc(*ret);
+        calcers.push_back(o);
+    }
+
+    std::vector<ObjectHolder *> holders;
+    holders.reserve(nholders);
+    for (quint32 i = 0; i < nholders; ++i) {
+        const uchar *rec = data + holdersoff + qint64(i) * holderWords * 4;
+        const quint32 id = getU32(rec);
+        const QRgb rgb = getU32(rec + 4);
+        const int width = static_cast<qint32>(getU32(rec + 8));
+        const quint32 dflags = getU32(rec + 12);
+        const quint32 font = getU32(rec + 16);
+        const quint32 ncid = getU32(rec + 20);
+        if (id >= ncalcers || font >= nstrings)
+            KIG_FILTER_PARSE_ERROR;
+
+        const bool shown = dflags & ShownFlag;
+        const Qt::PenStyle style = static_cast<Qt::PenStyle>((dflags >> 8) & 0xff);
+        const quint32 pointstyle = (dflags >> 16) & 0xff;
+        if (pointstyle >= Kig::NumberOfPointStyles)
+            KIG_FILTER_PARSE_ERROR;
+
+        QFont f;
+        if (!strings[font].isEmpty())
+            f.fromString(QString::fromUtf8(strings[font]));
+
+        ObjectConstCalcer *namecalcer = nullptr;
+        if (ncid != noIndex) {
+            if (ncid >= ncalcers)
+                KIG_FILTER_PARSE_ERROR;
+            namecalcer = dynamic_cast<ObjectConstCalcer *>(calcers[ncid].get());
+            if (!namecalcer)
+                KIG_FILTER_PARSE_ERROR;
+        }
+
+        ObjectDrawer *drawer = new ObjectDrawer(QColor(rgb), width, shown, style, static_cast<Kig::PointStyle>(pointstyle), f);
+        holders.push_back(new ObjectHolder(calcers[id].get(), drawer, namecalcer));
+    }
+
+    ret->addObjects(holders);
+    return ret;
+}
+
+/**
+ * collects the strings of a binary file, every string is stored only
+ * once..
+ */
+class StringTable
+{
+    std::map<QByteArray, quint32> mindex;
+
+public:
+    QByteArray data;
+    quint32 count = 0;
+
+    quint32 add(const QByteArray &s)
+    {
+        std::map<QByteArray, quint32>::const_iterator i = mindex.find(s);
+        if (i != mindex.end())
+            return i->second;
+        putU32(data, s.size());
+        data.append(s);
+        pad(data, 4);
+        mindex[s] = count;
+        return count++;
+    }
+};
+
+bool KigFilterNativeBinary::save(const KigDocument &kdoc, const QString &file)
+{
+    StringTable strings;
+    QByteArray calcerdata;
+    QByteArray parentdata;
+    QByteArray holderdata;
+    QByteArray payload;
+    quint32 nparents = 0;
+
+    const quint32 csname = strings.add(kdoc.coordinateSystem().type());
+
+    std::vector<ObjectHolder *> holders = kdoc.objects();
+    std::vector<ObjectCalcer *> calcers = getAllParents(getAllCalcers(holders));
+    calcers = calcPath(calcers);
+
+    std::map<const ObjectCalcer *, quint32> idmap;
+    for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i)
+        idmap[*i] = i - calcers.begin();
+
+    for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i) {
+        quint32 kind = DataPacked;
+        quint32 name = 0;
+        // doubles in the payload are kept 8-byte aligned..
+        pad(payload, 8);
+        const quint32 poff = payload.size();
+
+        if (dynamic_cast<ObjectConstCalcer *>(*i)) {
+            const ObjectImp *imp = (*i)->imp();
+            if (imp->inherits(IntImp::stype())) {
+                name = strings.add("int");
+                putU32(payload, static_cast<quint32>(static_cast<const IntImp *>(imp)->data()));
+            } else if (imp->inherits(DoubleImp::stype())) {
+                name = strings.add("double");
+                putF64(payload, static_cast<const DoubleImp *>(imp)->data());
+            } else if (imp->inherits(StringImp::stype())) {
+                name = strings.add("string");
+                payload.append(static_cast<const StringImp *>(imp)->data().toUtf8());
+            } else {
+                // everything else is stored like the XML format does it
+                kind = DataXml;
+                QDomDocument doc;
+                QDomElement e = doc.createElement(QStringLiteral("Data"));
+                const QString type = ObjectImpFactory::instance()->serialize(*imp, e, doc);
+                doc.appendChild(e);
+                name = strings.add(type.toLatin1());
+                payload.append(doc.toByteArray(-1));
+            }
+        } else if (dynamic_cast<const ObjectPropertyCalcer *>(*i)) {
+            const ObjectPropertyCalcer *o = static_cast<const ObjectPropertyCalcer *>(*i);
+            kind = PropertyCalcer;
+            name = strings.add(o->parent()->imp()->getPropName(o->propGid()));
+        } else if (dynamic_cast<const ObjectTypeCalcer *>(*i)) {
+            const ObjectTypeCalcer *o = static_cast<const ObjectTypeCalcer *>(*i);
+            kind = TypeCalcer;
+            name = strings.add(o->type()->fullName());
+        } else
+            assert(false);
+
+        const std::vector<ObjectCalcer *> parents = (*i)->parents();
+        putU32(calcerdata, kind);
+        putU32(calcerdata, name);
+        putU32(calcerdata, nparents);
+        putU32(calcerdata, parents.size());
+        putU32(calcerdata, poff);
+        putU32(calcerdata, payload.size() - poff);
+        for (std::vector<ObjectCalcer *>::const_iterator j = parents.begin(); j != parents.end(); ++j) {
+            std::map<const ObjectCalcer *, quint32>::const_iterator idp = idmap.find(*j);
+            assert(idp != idmap.end());
+            putU32(parentdata, idp->second);
+            ++nparents;
+        }
+    }
+
+    for (std::vector<ObjectHolder *>::const_iterator i = holders.begin(); i != holders.end(); ++i) {
+        std::map<const ObjectCalcer *, quint32>::const_iterator idp = idmap.find((*i)->calcer());
+        assert(idp != idmap.end());
+        const ObjectDrawer *d = (*i)->drawer();
+
+        quint32 dflags = d->shown() ? ShownFlag : 0;
+        dflags |= (static_cast<quint32>(d->style()) & 0xff) << 8;
+        dflags |= (static_cast<quint32>(d->pointStyle()) & 0xff) << 16;
+
+        quint32 ncid = noIndex;
+        if (ObjectCalcer *namecalcer = (*i)->nameCalcer()) {
+            std::map<const ObjectCalcer *, quint32>::const_iterator ncp = idmap.find(namecalcer);
+            assert(ncp != idmap.end());
+            ncid = ncp->second;
+        }
+
+        putU32(holderdata, idp->second);
+        putU32(holderdata, d->color().rgb());
+        putU32(holderdata, static_cast<quint32>(d->width()));
+        putU32(holderdata, dflags);
+        putU32(holderdata, strings.add(d->font().toString().toUtf8()));
+        putU32(holderdata, ncid);
+    }
+
+    // the payload is 8-byte aligned within the file too, an empty
+    // string at the end of the string table takes care of that..
+    if ((headerWords * 4 + strings.data.size() + calcerdata.size() + parentdata.size() + holderdata.size()) % 8) {
+        putU32(strings.data, 0);
+        ++strings.count;
+    }
+
+    QByteArray header;
+    putU32(header, binaryMagic);
+    putU32(header, binaryVersion);
+    putU32(header, (kdoc.grid() ? GridFlag : 0) | (kdoc.axes() ? AxesFlag : 0));
+    putU32(header, csname);
+    putU32(header, strings.count);
+    putU32(header, calcers.size());
+    putU32(header, nparents);
+    putU32(header, holders.size());
+    putU32(header, payload.size());
+    putU32(header, strings.data.size());
+
+    QFile f(file);
+    if (!f.open(QIODevice::WriteOnly)) {
+        fileNotFound(file);
+        return false;
+    }
+    f.write(header);
+    f.write(strings.data);
+    f.write(calcerdata);
+    f.write(parentdata);
+    f.write(holderdata);
+    f.write(payload);
+    return f.flush() && f.error() == QFileDevice::NoError;
+}
@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "filter.h"
+
+class KigDocument;
+class QString;
+
+/**
+ * A compact binary variant of Kig's native format ( *.kigb ).  It
+ * stores the same things as the 0.7 XML format, but in a form that can
+ * be read straight from a memory-mapped file:
+ *
+ * - a header with the magic "KIGB", the format version, the grid and
+ *   axes flags, the coordinate system and the sizes of all the tables
+ *   below;
+ * - a string table holding every type name, property name and font
+ *   once, so each ObjectType is looked up only once;
+ * - the calcers in calc order, one fixed size record each, pointing
+ *   into a flat array of parent indices and into the payload area;
+ * - the drawers, one fixed size record per ObjectHolder;
+ * - the payloads of the ObjectConstCalcers.  Ints, doubles and strings
+ *   are stored packed, other imps as the XML ObjectImpFactory
+ *   produces for them.
+ *
+ * All numbers are little endian and every table is 4-byte aligned.
+ * Converting a .kig file to .kigb and back gives the same .kig file.
+ */
+class KigFilterNativeBinary : public KigFilter
+{
+    KigFilterNativeBinary();
+    ~KigFilterNativeBinary();
+
+    KigDocument *load(const uchar *data, qint64 size);
+
+public:
+    static KigFilterNativeBinary *instance();
+
+    bool supportMime(const QString &mime) override;
+    KigDocument *load(const QString &file) override;
+    bool isReentrant() const override;
+
+    bool save(const KigDocument &data, const QString &file);
+};
@@ -22,16 +22,19 @@
 #include <algorithm>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 
+#include <QBuffer>
 #include <QDebug>
 #include <QDomElement>
 #include <QFile>
 #include <QFont>
-#include <QStandardPaths>
-#include <QTextStream>
 #include <QRegularExpression>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
+#include <KCompressionDevice>
 #include <KTar>
 
 struct HierElem {
@@ -82,6 +85,11 @@ bool KigFilterNative::supportMime(const QString &mime)
     return mime == QLatin1String("application/x-kig");
 }
 
+bool KigFilterNative::isReentrant() const
+{
+    return true;
+}
+
 KigDocument *KigFilterNative::load(const QString &file)
 {
     QFile ffile(file);
@@ -90,93 +98,74 @@ KigDocument *KigFilterNative::load(const QString &file)
         return nullptr;
     };
 
-    QFile kigdoc(file);
-    bool iscompressed = false;
-    if (!file.endsWith(QLatin1String(".kig"), Qt::CaseInsensitive)) {
-        // the file is compressed, so we have to decompress it and fetch the
-        // kig file inside it...
-        iscompressed = true;
-
-        QString tempdir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-        if (tempdir.isEmpty())
-            KIG_FILTER_PARSE_ERROR;
+    if (file.endsWith(QLatin1String(".kig"), Qt::CaseInsensitive))
+        return load(ffile);
 
-        tempdir += QLatin1Char('/');
-
-        QString tempname = file.section('/', -1);
-        if (file.endsWith(QLatin1String(".kigz"), Qt::CaseInsensitive)) {
-            tempname.remove(QRegularExpression("\\.[Kk][Ii][Gg][Zz]$"));
-        } else
-            KIG_FILTER_PARSE_ERROR;
-        // reading compressed file
-        KTar ark(file, QStringLiteral("application/gzip"));
-        ark.open(QIODevice::ReadOnly);
-        const KArchiveDirectory *dir = ark.directory();
-        //    assert( dir );
-        QStringList entries = dir->entries();
-        QStringList kigfiles = entries.filter(QRegularExpression("\\.kig$"));
-        if (kigfiles.count() != 1)
-            // I throw a generic parse error here, but I should warn the user that
-            // this kig archive file doesn't contain one kig file (it contains no
-            // kig files or more than one).
-            KIG_FILTER_PARSE_ERROR;
-        const KArchiveEntry *kigz = dir->entry(kigfiles.at(0));
-        if (!kigz->isFile())
-            KIG_FILTER_PARSE_ERROR;
-        dynamic_cast<const KArchiveFile *>(kigz)->copyTo(tempdir);
-        qDebug() << "extracted file: " << tempdir + kigz->name() << "exists: " << QFile::exists(tempdir + kigz->name());
-
-        kigdoc.setFileName(tempdir + kigz->name());
-    }
+    // the file is compressed, so we have to decompress it and fetch the
+    // kig file inside it, which is read straight out of the archive...
+    if (!file.endsWith(QLatin1String(".kigz"), Qt::CaseInsensitive))
+        KIG_FILTER_PARSE_ERROR;
+    ffile.close();
 
-    if (!kigdoc.open(QIODevice::ReadOnly))
+    // we unzip ourselves, KTar would otherwise unpack a gzipped archive
+    // into a temporary file..
+    KCompressionDevice gz(file, KCompressionDevice::GZip);
+    if (!gz.open(QIODevice::ReadOnly))
         KIG_FILTER_PARSE_ERROR;
+    QByteArray tardata = gz.readAll();
+    gz.close();
+    QBuffer tarbuf(&tardata);
 
-    QDomDocument doc(QStringLiteral("KigDocument"));
-    if (!doc.setContent(&kigdoc))
+    KTar ark(&tarbuf);
+    if (!ark.open(QIODevice::ReadOnly))
+        KIG_FILTER_PARSE_ERROR;
+    const KArchiveDirectory *dir = ark.directory();
+    //    assert( dir );
+    QStringList entries = dir->entries();
+    QStringList kigfiles = entries.filter(QRegularExpression("\\.kig$"));
+    if (kigfiles.count() != 1)
+        // I throw a generic parse error here, but I should warn the user that
+        // this kig archive file doesn't contain one kig file (it contains no
+        // kig files or more than one).
+        KIG_FILTER_PARSE_ERROR;
+    const KArchiveEntry *kigz = dir->entry(kigfiles.at(0));
+    if (!kigz->isFile())
         KIG_FILTER_PARSE_ERROR;
-    kigdoc.close();
 
-    // removing temp file
-    if (iscompressed)
-        kigdoc.remove();
+    std::unique_ptr<QIODevice> kigdoc(static_cast<const KArchiveFile *>(kigz)->createDevice());
+    if (!kigdoc || !kigdoc->isOpen())
+        KIG_FILTER_PARSE_ERROR;
 
-    return load(doc);
+    return load(*kigdoc);
 }
 
-KigDocument *KigFilterNative::load(const QDomDocument &doc)
+/**
+ * parses the version attribute of a KigDocument element, matches
+ * 0.1, 0.2.0, 153.128.99 etc.
+ */
+static bool parseVersion(const QString &version, int &major, int &minor)
 {
-    QDomElement main = doc.documentElement();
-
-    QString version = main.attribute(QStringLiteral("CompatibilityVersion"));
-    if (version.isEmpty())
-        version = main.attribute(QStringLiteral("Version"));
-    if (version.isEmpty())
-        version = main.attribute(QStringLiteral("version"));
-    if (version.isEmpty())
-        KIG_FILTER_PARSE_ERROR;
-
-    // matches 0.1, 0.2.0, 153.128.99 etc.
-    QRegularExpression versionre("(\\d+)\\.(\\d+)(\\.(\\d+))?");
+    static const QRegularExpression versionre("(\\d+)\\.(\\d+)(\\.(\\d+))?");
     QRegularExpressionMatch match = versionre.match(version);
     if (!match.hasMatch())
-        KIG_FILTER_PARSE_ERROR;
+        return false;
     bool ok = true;
-    int major = match.capturedView(1).toInt(&ok);
+    major = match.capturedView(1).toInt(&ok);
     bool ok2 = true;
-    int minor = match.capturedView(2).toInt(&ok2);
-    if (!ok || !ok2)
-        KIG_FILTER_PARSE_ERROR;
-
+    minor = match.capturedView(2).toInt(&ok2);
     //   int minorminor = match.captured( 4 ).toInt( &ok );
+    return ok && ok2;
+}
 
+bool KigFilterNative::supportedVersion(int major, int minor, const QString &version)
+{
     // we only support 0.[0-7] and 1.0.*
     if (major > 0 || minor > 9) {
         notSupported(
             i18n("This file was created by Kig version \"%1\", "
                  "which this version cannot open.",
                  version));
-        return nullptr;
+        return false;
     } else if (major == 0 && minor <= 3) {
         notSupported(
             i18n("This file was created by Kig version \"%1\".\n"
@@ -187,11 +176,77 @@ KigDocument *KigFilterNative::load(const QDomDocument &doc)
                  "and then save it again, which will save it in the "
                  "new format.",
                  version));
+        return false;
+    }
+    return true;
+}
+
+KigDocument *KigFilterNative::load(QIODevice &dev)
+{
+    // we only look at the root element here, the 0.7 format is then
+    // read in the same pass, without ever building a DOM tree..
+    QXmlStreamReader xml(&dev);
+    if (!xml.readNextStartElement())
+        KIG_FILTER_PARSE_ERROR;
+
+    const QXmlStreamAttributes attrs = xml.attributes();
+    QString version = attrs.value(QLatin1String("CompatibilityVersion")).toString();
+    if (version.isEmpty())
+        version = attrs.value(QLatin1String("Version")).toString();
+    if (version.isEmpty())
+        version = attrs.value(QLatin1String("version")).toString();
+    if (version.isEmpty())
+        KIG_FILTER_PARSE_ERROR;
+
+    int major = 0;
+    int minor = 0;
+    if (!parseVersion(version, major, minor))
+        KIG_FILTER_PARSE_ERROR;
+    if (!supportedVersion(major, minor, version))
+        return nullptr;
+
+    if (minor >= 7)
+        return load07(xml);
+
+    // the 0.4 format allows the objects to come in any order, so it
+    // needs the whole tree anyway..
+    if (!dev.seek(0))
+        KIG_FILTER_PARSE_ERROR;
+    QDomDocument doc(QStringLiteral("KigDocument"));
+    if (!doc.setContent(&dev))
+        KIG_FILTER_PARSE_ERROR;
+    return load04(doc.documentElement());
+}
+
+KigDocument *KigFilterNative::load(const QDomDocument &doc)
+{
+    QDomElement main = doc.documentElement();
+
+    QString version = main.attribute(QStringLiteral("CompatibilityVersion"));
+    if (version.isEmpty())
+        version = main.attribute(QStringLiteral("Version"));
+    if (version.isEmpty())
+        version = main.attribute(QStringLiteral("version"));
+    if (version.isEmpty())
+        KIG_FILTER_PARSE_ERROR;
+
+    int major = 0;
+    int minor = 0;
+    if (!parseVersion(version, major, minor))
+        KIG_FILTER_PARSE_ERROR;
+    if (!supportedVersion(major, minor, version))
         return nullptr;
-    } else if (major == 0 && minor <= 6)
+
+    if (minor <= 6)
         return load04(main);
-    else
-        return load07(main);
+
+    // there is only one reader for the 0.7 format, and it works on a
+    // stream..
+    QByteArray data = doc.toByteArray();
+    QBuffer buf(&data);
+    if (!buf.open(QIODevice::ReadOnly))
+        KIG_FILTER_PARSE_ERROR;
+    return load(buf);
 }
 
 KigDocument *KigFilterNative::load04(const QDomElement &docelem)
@@ -359,7 +414,93 @@ static const char *obsoletemessage = I18N_NOOP(
     "which is obsolete, you should save the construction with "
     "a different name and check that it works as expected.");
 
-KigDocument *KigFilterNative::load07(const QDomElement &docelem)
+/**
+ * reads the element the reader is positioned on, and all of its
+ * children, into a DOM element owned by \p doc.  ObjectImpFactory
+ * works on DOM elements, so we build one for every Data element, which
+ * is a lot smaller than building the whole document..
+ */
+static QDomElement readDomElement(QXmlStreamReader &xml, QDomDocument &doc)
+{
+    QDomElement e = doc.createElement(xml.name().toString());
+    const QXmlStreamAttributes attrs = xml.attributes();
+    for (const QXmlStreamAttribute &a : attrs)
+        e.setAttribute(a.name().toString(), a.value().toString());
+
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (xml.isEndElement())
+            break;
+        if (xml.isStartElement())
+            e.appendChild(readDomElement(xml, doc));
+        else if (xml.isCharacters() && !xml.isWhitespace())
+            e.appendChild(doc.createTextNode(xml.text().toString()));
+    }
+    return e;
+}
+
+static bool isFalse(QStringView s)
+{
+    return s == QLatin1String("false") || s == QLatin1String("no") || s == QLatin1String("0");
+}
+
+const ObjectType *KigFilterNative::findType(const QString &tmp, std::vector<ObjectCalcer *> &parents)
+{
+    const ObjectType *type = ObjectTypeFactory::instance()->find(tmp.toLatin1());
+    if (type)
+        return type;
+
+    if (tmp == QLatin1String("MeasureTransport") && parents.size() == 3) {
+        warning(i18n(obsoletemessage, tmp));
+        type = ObjectTypeFactory::instance()->find("TransportOfMeasure");
+        ObjectCalcer *circle = parents[0];
+        ObjectCalcer *point = parents[1];
+        ObjectCalcer *segment = parents[2];
+        parents[0] = segment;
+        parents[1] = circle;
+        parents[2] = point;
+    } else if (tmp == QLatin1String("LineCubicIntersection")) {
+        warning(i18n(obsoletemessage, tmp));
+        type = ObjectTypeFactory::instance()->find("CubicLineIntersection");
+    } else if (tmp == QLatin1String("InvertLine")) {
+        warning(i18n(obsoletemessage, tmp));
+        type = ObjectTypeFactory::instance()->find("CircularInversion");
+    } else if (tmp == QLatin1String("InvertSegment")) {
+        warning(i18n(obsoletemessage, tmp));
+        type = ObjectTypeFactory::instance()->find("CircularInversion");
+    } else if (tmp == QLatin1String("InvertCircle")) {
+        warning(i18n(obsoletemessage, tmp));
+        type = ObjectTypeFactory::instance()->find("CircularInversion");
+    } else if (tmp == QLatin1String("InvertArc")) {
+        warning(i18n(obsoletemessage, tmp));
+        type = ObjectTypeFactory::instance()->find("CircularInversion");
+    } else if (tmp == QLatin1String("ConicArcBTPC") && parents.size() == 4) {
+        warning(i18n(obsoletemessage, tmp));
+        type = ObjectTypeFactory::instance()->find("ConicArcBCTP");
+        //
+        // the only difference is in the order of parents
+        // entering the center first seems more useful, and allows
+        // for a better user interface
+        //
+        ObjectCalcer *point = parents[3];
+        parents[3] = parents[2];
+        parents[2] = parents[1];
+        parents[1] = parents[0];
+        parents[0] = point;
+    } else {
+        notSupported(
+            i18n("This Kig file uses an object of type \"%1\", "
+                 "which this Kig version does not support."
+                 "Perhaps you have compiled Kig without support "
+                 "for this object type,"
+                 "or perhaps you are using an older Kig version.",
+                 tmp));
+        return nullptr;
+    }
+    return type;
+}
+
+KigDocument *KigFilterNative::load07(QXmlStreamReader &xml)
 {
     KigDocument *ret = new KigDocument();
 
@@ -367,17 +508,12 @@ KigDocument *KigFilterNative::load07(const QDomElement &docelem)
     std::vector<ObjectCalcer::shared_ptr> calcers;
     std::vector<ObjectHolder *> holders;
 
-    QString t = docelem.attribute(QStringLiteral("grid"));
-    bool tmphide = (t == QLatin1String("false")) || (t == QLatin1String("no")) || (t == QLatin1String("0"));
-    ret->setGrid(!tmphide);
-    t = docelem.attribute(QStringLiteral("axes"));
-    tmphide = (t == QLatin1String("false")) || (t == QLatin1String("no")) || (t == QLatin1String("0"));
-    ret->setAxes(!tmphide);
-
-    for (QDomElement subsectionelement = docelem.firstChild().toElement(); !subsectionelement.isNull();
-         subsectionelement = subsectionelement.nextSibling().toElement()) {
-        if (subsectionelement.tagName() == QLatin1String("CoordinateSystem")) {
-            QString tmptype = subsectionelement.text();
+    ret->setGrid(!isFalse(xml.attributes().value(QLatin1String("grid"))));
+    ret->setAxes(!isFalse(xml.attributes().value(QLatin1String("axes"))));
+
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("CoordinateSystem")) {
+            QString tmptype = xml.readElementText();
             // compatibility code - to support Invisible coord system...
             if (tmptype == QLatin1String("Invisible")) {
                 tmptype = QStringLiteral("Euclidean");
@@ -394,164 +530,121 @@ KigDocument *KigFilterNative::load07(const QDomElement &docelem)
                          "instead."));
             } else
                 ret->setCoordinateSystem(s);
-        } else if (subsectionelement.tagName() == QLatin1String("Hierarchy")) {
-            for (QDomElement e = subsectionelement.firstChild().toElement(); !e.isNull(); e = e.nextSibling().toElement()) {
-                QString tmp = e.attribute(QStringLiteral("id"));
-                uint id = tmp.toInt(&ok);
-                if (id <= 0)
+        } else if (xml.name() == QLatin1String("Hierarchy")) {
+            while (xml.readNextStartElement()) {
+                const QString tag = xml.name().toString();
+                const QXmlStreamAttributes attrs = xml.attributes();
+                uint id = attrs.value(QLatin1String("id")).toUInt(&ok);
+                if (!ok || id == 0)
                     KIG_FILTER_PARSE_ERROR;
 
-                std::vector<ObjectCalcer *> parents;
-                for (QDomElement parentel = e.firstChild().toElement(); !parentel.isNull(); parentel = parentel.nextSibling().toElement()) {
-                    if (parentel.tagName() != QLatin1String("Parent"))
-                        continue;
-                    QString tmp = parentel.attribute(QStringLiteral("id"));
-                    uint parentid = tmp.toInt(&ok);
-                    if (!ok)
-                        KIG_FILTER_PARSE_ERROR;
-                    if (parentid == 0 || parentid > calcers.size())
-                        KIG_FILTER_PARSE_ERROR;
-                    ObjectCalcer *parent = calcers[parentid - 1].get();
-                    if (!parent)
-                        KIG_FILTER_PARSE_ERROR;
-                    parents.push_back(parent);
-                }
-
                 ObjectCalcer *o = nullptr;
 
-                if (e.tagName() == QLatin1String("Data")) {
-                    if (!parents.empty())
+                if (tag == QLatin1String("Data")) {
+                    // a Data element has no parents, everything inside
+                    // it belongs to the imp..
+                    QDomDocument doc;
+                    QDomElement e = readDomElement(xml, doc);
+                    if (!e.firstChildElement(QStringLiteral("Parent")).isNull())
                         KIG_FILTER_PARSE_ERROR;
-                    QString tmp = e.attribute(QStringLiteral("type"));
                     QString error;
-                    ObjectImp *imp = ObjectImpFactory::instance()->deserialize(tmp, e, error);
+                    ObjectImp *imp = ObjectImpFactory::instance()->deserialize(e.attribute(QStringLiteral("type")), e, error);
                     if ((!imp) && !error.isEmpty()) {
                         parseError(error);
                         return nullptr;
                     }
                     o = new ObjectConstCalcer(imp);
-                } else if (e.tagName() == QLatin1String("Property")) {
-                    if (parents.size() != 1)
-                        KIG_FILTER_PARSE_ERROR;
-                    QByteArray propname = e.attribute(QStringLiteral("which")).toLatin1();
+                } else {
+                    const QString type = attrs.value(QLatin1String("type")).toString();
+                    const QByteArray propname = attrs.value(QLatin1String("which")).toLatin1();
 
-                    ObjectCalcer *parent = parents[0];
-                    int propid = parent->imp()->propertiesInternalNames().indexOf(propname);
-                    if (propid == -1)
-                        KIG_FILTER_PARSE_ERROR;
-
-                    o = new ObjectPropertyCalcer(parent, propname);
-                } else if (e.tagName() == QLatin1String("Object")) {
-                    QString tmp = e.attribute(QStringLiteral("type"));
-                    const ObjectType *type = ObjectTypeFactory::instance()->find(tmp.toLatin1());
-                    if (!type) {
-                        if (tmp == QLatin1String("MeasureTransport") && parents.size() == 3) {
-                            warning(i18n(obsoletemessage, tmp));
-                            type = ObjectTypeFactory::instance()->find("TransportOfMeasure");
-                            ObjectCalcer *circle = parents[0];
-                            ObjectCalcer *point = parents[1];
-                            ObjectCalcer *segment = parents[2];
-                            parents[0] = segment;
-                            parents[1] = circle;
-                            parents[2] = point;
-                        } else if (tmp == QLatin1String("LineCubicIntersection")) {
-                            warning(i18n(obsoletemessage, tmp));
-                            type = ObjectTypeFactory::instance()->find("CubicLineIntersection");
-                        } else if (tmp == QLatin1String("InvertLine")) {
-                            warning(i18n(obsoletemessage, tmp));
-                            type = ObjectTypeFactory::instance()->find("CircularInversion");
-                        } else if (tmp == QLatin1String("InvertSegment")) {
-                            warning(i18n(obsoletemessage, tmp));
-                            type = ObjectTypeFactory::instance()->find("CircularInversion");
-                        } else if (tmp == QLatin1String("InvertCircle")) {
-                            warning(i18n(obsoletemessage, tmp));
-                            type = ObjectTypeFactory::instance()->find("CircularInversion");
-                        } else if (tmp == QLatin1String("InvertArc")) {
-                            warning(i18n(obsoletemessage, tmp));
-                            type = ObjectTypeFactory::instance()->find("CircularInversion");
-                        } else if (tmp == QLatin1String("ConicArcBTPC")) {
-                            warning(i18n(obsoletemessage, tmp));
-                            type = ObjectTypeFactory::instance()->find("ConicArcBCTP");
-                            //
-                            // the only difference is in the order of parents
-                            // entering the center first seems more useful, and allows
-                            // for a better user interface
-                            //
-                            ObjectCalcer *point = parents[3];
-                            parents[3] = parents[2];
-                            parents[2] = parents[1];
-                            parents[1] = parents[0];
-                            parents[0] = point;
-                        } else {
-                            notSupported(
-                                i18n("This Kig file uses an object of type \"%1\", "
-                                     "which this Kig version does not support."
-                                     "Perhaps you have compiled Kig without support "
-                                     "for this object type,"
-                                     "or perhaps you are using an older Kig version.",
-                                     tmp));
-                            return nullptr;
+                    std::vector<ObjectCalcer *> parents;
+                    while (xml.readNextStartElement()) {
+                        if (xml.name() == QLatin1String("Parent")) {
+                            uint parentid = xml.attributes().value(QLatin1String("id")).toUInt(&ok);
+                            if (!ok)
+                                KIG_FILTER_PARSE_ERROR;
+                            if (parentid == 0 || parentid > calcers.size())
+                                KIG_FILTER_PARSE_ERROR;
+                            ObjectCalcer *parent = calcers[parentid - 1].get();
+                            if (!parent)
+                                KIG_FILTER_PARSE_ERROR;
+                            parents.push_back(parent);
                         }
+                        xml.skipCurrentElement();
                     }
 
-                    // mp: (I take the responsibility for this!) explanation: the usual ObjectTypeCalcer
-                    // constructor also "sortArgs" the parents.  I believe that this *must not* be done
-                    // when loading from a saved kig file for the following reasons:
-                    // 1. the arguments should already be in their intended order, since the file was
-                    // saved from a working hierarchy; furthermore we actually want to restore the original
-                    // hierarchy, not really to also fix possible problems with the original hierarchy;
-                    // 2. calling sortArgs could have undesirable side effects in particular situations,
-                    // since kig actually allow an ObjectType to produce different type of ObjectImp's
-                    // it may happen that the parents of an object do not satisfy the requirements
-                    // enforced by sortArgs (while moving around the free objects) but still be
-                    // perfectly valid
-                    o = new ObjectTypeCalcer(type, parents, false);
-                } else
-                    KIG_FILTER_PARSE_ERROR;
+                    if (tag == QLatin1String("Property")) {
+                        if (parents.size() != 1)
+                            KIG_FILTER_PARSE_ERROR;
+
+                        ObjectCalcer *parent = parents[0];
+                        int propid = parent->imp()->propertiesInternalNames().indexOf(propname);
+                        if (propid == -1)
+                            KIG_FILTER_PARSE_ERROR;
+
+                        o = new ObjectPropertyCalcer(parent, propname);
+                    } else if (tag == QLatin1String("Object")) {
+                        const ObjectType *t = findType(type, parents);
+                        if (!t)
+                            return nullptr;
+
+                        // mp: (I take the responsibility for this!) explanation: the usual ObjectTypeCalcer
+                        // constructor also "sortArgs" the parents.  I believe that this *must not* be done
+                        // when loading from a saved kig file for the following reasons:
+                        // 1. the arguments should already be in their intended order, since the file was
+                        // saved from a working hierarchy; furthermore we actually want to restore the original
+                        // hierarchy, not really to also fix possible problems with the original hierarchy;
+                        // 2. calling sortArgs could have undesirable side effects in particular situations,
+                        // since kig actually allow an ObjectType to produce different type of ObjectImp's
+                        // it may happen that the parents of an object do not satisfy the requirements
+                        // enforced by sortArgs (while moving around the free objects) but still be
+                        // perfectly valid
+                        o = new ObjectTypeCalcer(t, parents, false);
+                    } else
+                        KIG_FILTER_PARSE_ERROR;
+                }
 
                 o->calc(*ret);
                 calcers.resize(id, nullptr);
                 calcers[id - 1] = o;
             }
-        } else if (subsectionelement.tagName() == QLatin1String("View")) {
-            for (QDomElement e = subsectionelement.firstChild().toElement(); !e.isNull(); e = e.nextSibling().toElement()) {
-                if (e.tagName() != QLatin1String("Draw"))
+        } else if (xml.name() == QLatin1String("View")) {
+            while (xml.readNextStartElement()) {
+                if (xml.name() != QLatin1String("Draw"))
                     KIG_FILTER_PARSE_ERROR;
 
-                QString tmp = e.attribute(QStringLiteral("object"));
-                uint id = tmp.toInt(&ok);
+                const QXmlStreamAttributes attrs = xml.attributes();
+                xml.skipCurrentElement();
+
+                uint id = attrs.value(QLatin1String("object")).toUInt(&ok);
                 if (!ok)
                     KIG_FILTER_PARSE_ERROR;
                 if (id <= 0 || id > calcers.size())
                     KIG_FILTER_PARSE_ERROR;
                 ObjectCalcer *calcer = calcers[id - 1].get();
 
-                tmp = e.attribute(QStringLiteral("color"));
-                QColor color(tmp);
+                QColor color(attrs.value(QLatin1String("color")).toString());
                 if (!color.isValid())
                     KIG_FILTER_PARSE_ERROR;
 
-                tmp = e.attribute(QStringLiteral("shown"));
+                QStringView tmp = attrs.value(QLatin1String("shown"));
                 bool shown = !(tmp == QLatin1String("false") || tmp == QLatin1String("no"));
 
-                tmp = e.attribute(QStringLiteral("width"));
-                int width = tmp.toInt(&ok);
+                int width = attrs.value(QLatin1String("width")).toInt(&ok);
                 if (!ok)
                     width = -1;
 
-                tmp = e.attribute(QStringLiteral("style"));
-                Qt::PenStyle style = ObjectDrawer::styleFromString(tmp);
-
-                tmp = e.attribute(QStringLiteral("point-style"));
-                Kig::PointStyle pointstyle = Kig::pointStyleFromString(tmp);
+                Qt::PenStyle style = ObjectDrawer::styleFromString(attrs.value(QLatin1String("style")).toString());
+                Kig::PointStyle pointstyle = Kig::pointStyleFromString(attrs.value(QLatin1String("point-style")).toString());
 
-                tmp = e.attribute(QStringLiteral("font"));
+                tmp = attrs.value(QLatin1String("font"));
                 QFont f;
                 if (!tmp.isEmpty())
-                    f.fromString(tmp);
+                    f.fromString(tmp.toString());
 
                 ObjectConstCalcer *namecalcer = nullptr;
-                tmp = e.attribute(QStringLiteral("namecalcer"));
+                tmp = attrs.value(QLatin1String("namecalcer"));
                 if (tmp != QLatin1String("none") && !tmp.isEmpty()) {
                     int ncid = tmp.toInt(&ok);
                     if (!ok)
@@ -566,56 +659,91 @@ KigDocument *KigFilterNative::load07(const QDomElement &docelem)
                 ObjectDrawer *drawer = new ObjectDrawer(color, width, shown, style, pointstyle, f);
                 holders.push_back(new ObjectHolder(calcer, drawer, namecalcer));
             }
-        }
+        } else
+            xml.skipCurrentElement(); // be forward-compatible..
     }
+    if (xml.hasError())
+        KIG_FILTER_PARSE_ERROR;
 
     ret->addObjects(holders);
     return ret;
 }
 
-bool KigFilterNative::save07(const KigDocument &kdoc, QTextStream &stream)
+/**
+ * writes the attributes and the children of \p e, which
+ * ObjectImpFactory::serialize filled in, to \p xml, inside the element
+ * that is currently open there..
+ */
+static void writeDomContents(QXmlStreamWriter &xml, const QDomElement &e)
 {
-    QDomDocument doc(QStringLiteral("KigDocument"));
+    const QDomNamedNodeMap attrs = e.attributes();
+    for (int i = 0; i < attrs.count(); ++i) {
+        const QDomAttr a = attrs.item(i).toAttr();
+        xml.writeAttribute(a.name(), a.value());
+    }
+    for (QDomNode n = e.firstChild(); !n.isNull(); n = n.nextSibling()) {
+        if (n.isElement()) {
+            xml.writeStartElement(n.toElement().tagName());
+            writeDomContents(xml, n.toElement());
+            xml.writeEndElement();
+        } else if (n.isText())
+            xml.writeCharacters(n.toText().data());
+    }
+}
+
+bool KigFilterNative::save07(const KigDocument &kdoc, QIODevice &dev)
+{
+    // the file is written while we walk the hierarchy, so we never hold
+    // more than one object's worth of XML in memory..
+    QXmlStreamWriter xml(&dev);
+    xml.setAutoFormatting(true);
+    xml.setAutoFormattingIndent(1);
 
-    QDomProcessingInstruction xmlpi = doc.createProcessingInstruction(QStringLiteral("xml"), QStringLiteral("version=\"1.0\" encoding=\"utf-8\""));
-    doc.appendChild(xmlpi);
+    xml.writeStartDocument();
+    xml.writeDTD(QStringLiteral("<!DOCTYPE KigDocument>"));
 
-    QDomElement docelem = doc.createElement(QStringLiteral("KigDocument"));
-    docelem.setAttribute(QStringLiteral("Version"), KIG_VERSION_STRING);
-    docelem.setAttribute(QStringLiteral("CompatibilityVersion"), QStringLiteral("0.7.0"));
-    docelem.setAttribute(QStringLiteral("grid"), kdoc.grid());
-    docelem.setAttribute(QStringLiteral("axes"), kdoc.axes());
+    xml.writeStartElement(QStringLiteral("KigDocument"));
+    xml.writeAttribute(QStringLiteral("Version"), QString::fromLatin1(KIG_VERSION_STRING));
+    xml.writeAttribute(QStringLiteral("CompatibilityVersion"), QStringLiteral("0.7.0"));
+    xml.writeAttribute(QStringLiteral("grid"), QString::number(kdoc.grid()));
+    xml.writeAttribute(QStringLiteral("axes"), QString::number(kdoc.axes()));
 
-    QDomElement cselem = doc.createElement(QStringLiteral("CoordinateSystem"));
-    cselem.appendChild(doc.createTextNode(kdoc.coordinateSystem().type()));
-    docelem.appendChild(cselem);
+    xml.writeTextElement(QStringLiteral("CoordinateSystem"), QString::fromLatin1(kdoc.coordinateSystem().type()));
 
     std::vector<ObjectHolder *> holders = kdoc.objects();
     std::vector<ObjectCalcer *> calcers = getAllParents(getAllCalcers(holders));
     calcers = calcPath(calcers);
 
-    QDomElement hierelem = doc.createElement(QStringLiteral("Hierarchy"));
     std::map<const ObjectCalcer *, int> idmap;
     for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i)
         idmap[*i] = (i - calcers.begin()) + 1;
     int id = 1;
 
+    xml.writeStartElement(QStringLiteral("Hierarchy"));
     for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i) {
-        QDomElement objectelem;
         if (dynamic_cast<ObjectConstCalcer *>(*i)) {
-            objectelem = doc.createElement(QStringLiteral("Data"));
+            // ObjectImpFactory only knows about DOM elements, so the
+            // imp gets a small document of its own..
+            QDomDocument doc;
+            QDomElement objectelem = doc.createElement(QStringLiteral("Data"));
             QString ser = ObjectImpFactory::instance()->serialize(*(*i)->imp(), objectelem, doc);
             objectelem.setAttribute(QStringLiteral("type"), ser);
+            objectelem.setAttribute(QStringLiteral("id"), id++);
+
+            xml.writeStartElement(QStringLiteral("Data"));
+            writeDomContents(xml, objectelem);
         } else if (dynamic_cast<const ObjectPropertyCalcer *>(*i)) {
             const ObjectPropertyCalcer *o = static_cast<const ObjectPropertyCalcer *>(*i);
-            objectelem = doc.createElement(QStringLiteral("Property"));
+            xml.writeStartElement(QStringLiteral("Property"));
 
             QByteArray propname = o->parent()->imp()->getPropName(o->propGid());
-            objectelem.setAttribute(QStringLiteral("which"), QString(propname));
+            xml.writeAttribute(QStringLiteral("which"), QString::fromLatin1(propname));
+            xml.writeAttribute(QStringLiteral("id"), QString::number(id++));
         } else if (dynamic_cast<const ObjectTypeCalcer *>(*i)) {
             const ObjectTypeCalcer *o = static_cast<const ObjectTypeCalcer *>(*i);
-            objectelem = doc.createElement(QStringLiteral("Object"));
-            objectelem.setAttribute(QStringLiteral("type"), o->type()->fullName());
+            xml.writeStartElement(QStringLiteral("Object"));
+            xml.writeAttribute(QStringLiteral("type"), QString::fromLatin1(o->type()->fullName()));
+            xml.writeAttribute(QStringLiteral("id"), QString::number(id++));
         } else
             assert(false);
 
@@ -624,49 +752,45 @@ bool KigFilterNative::save07(const KigDocument &kdoc, QTextStream &stream)
             std::map<const ObjectCalcer *, int>::const_iterator idp = idmap.find(*i);
             assert(idp != idmap.end());
             int pid = idp->second;
-            QDomElement pel = doc.createElement(QStringLiteral("Parent"));
-            pel.setAttribute(QStringLiteral("id"), pid);
-            objectelem.appendChild(pel);
+            xml.writeEmptyElement(QStringLiteral("Parent"));
+            xml.writeAttribute(QStringLiteral("id"), QString::number(pid));
         }
 
-        objectelem.setAttribute(QStringLiteral("id"), id++);
-        hierelem.appendChild(objectelem);
+        xml.writeEndElement();
     }
-    docelem.appendChild(hierelem);
+    xml.writeEndElement();
 
-    QDomElement windowelem = doc.createElement(QStringLiteral("View"));
+    xml.writeStartElement(QStringLiteral("View"));
     for (std::vector<ObjectHolder *>::iterator i = holders.begin(); i != holders.end(); ++i) {
         std::map<const ObjectCalcer *, int>::const_iterator idp = idmap.find((*i)->calcer());
         assert(idp != idmap.end());
         int id = idp->second;
 
         const ObjectDrawer *d = (*i)->drawer();
-        QDomElement drawelem = doc.createElement(QStringLiteral("Draw"));
-        drawelem.setAttribute(QStringLiteral("object"), id);
-        drawelem.setAttribute(QStringLiteral("color"), d->color().name());
-        drawelem.setAttribute(QStringLiteral("shown"), QLatin1String(d->shown() ? "true" : "false"));
-        drawelem.setAttribute(QStringLiteral("width"), QString::number(d->width()));
-        drawelem.setAttribute(QStringLiteral("style"), d->styleToString());
-        drawelem.setAttribute(QStringLiteral("point-style"), Kig::pointStyleToString(d->pointStyle()));
-        drawelem.setAttribute(QStringLiteral("font"), d->font().toString());
+        xml.writeEmptyElement(QStringLiteral("Draw"));
+        xml.writeAttribute(QStringLiteral("object"), QString::number(id));
+        xml.writeAttribute(QStringLiteral("color"), d->color().name());
+        xml.writeAttribute(QStringLiteral("shown"), QLatin1String(d->shown() ? "true" : "false"));
+        xml.writeAttribute(QStringLiteral("width"), QString::number(d->width()));
+        xml.writeAttribute(QStringLiteral("style"), d->styleToString());
+        xml.writeAttribute(QStringLiteral("point-style"), Kig::pointStyleToString(d->pointStyle()));
+        xml.writeAttribute(QStringLiteral("font"), d->font().toString());
 
         ObjectCalcer *namecalcer = (*i)->nameCalcer();
         if (namecalcer) {
             std::map<const ObjectCalcer *, int>::const_iterator ncp = idmap.find(namecalcer);
             assert(ncp != idmap.end());
             int ncid = ncp->second;
-            drawelem.setAttribute(QStringLiteral("namecalcer"), ncid);
+            xml.writeAttribute(QStringLiteral("namecalcer"), QString::number(ncid));
         } else {
-            drawelem.setAttribute(QStringLiteral("namecalcer"), QStringLiteral("none"));
+            xml.writeAttribute(QStringLiteral("namecalcer"), QStringLiteral("none"));
         }
-
-        windowelem.appendChild(drawelem);
     };
-    docelem.appendChild(windowelem);
+    xml.writeEndElement();
 
-    doc.appendChild(docelem);
-    stream << doc.toString();
-    return true;
+    xml.writeEndElement();
+    xml.writeEndDocument();
+    return !xml.hasError();
 }
 
 bool KigFilterNative::save(const KigDocument &data, const QString &file)
@@ -678,55 +802,60 @@ bool KigFilterNative::save07(const KigDocument &data, const QString &outfile)
 {
     // we have an empty outfile, so we have to print all to stdout
     if (outfile.isEmpty()) {
-        QTextStream stdoutstream(stdout, QIODevice::WriteOnly);
-        stream.setEncoding(QStringConverter::Utf8);
-        return save07(data, stdoutstream);
+        QFile stdoutfile;
+        if (!stdoutfile.open(stdout, QIODevice::WriteOnly))
+            return false;
+        return save07(data, stdoutfile);
     }
     if (!outfile.endsWith(QLatin1String(".kig"), Qt::CaseInsensitive)) {
-        // the user wants to save a compressed file, so we have to save our kig
-        // file to a temp file and then compress it...
-
-        QString tempdir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-        if (tempdir.isEmpty())
-            return false;
-
+        // the user wants to save a compressed file, so we write our kig
+        // file to memory and put that in the archive...
         QString tempname = outfile.section('/', -1);
         if (outfile.endsWith(QLatin1String(".kigz"), Qt::CaseInsensitive))
             tempname.remove(QRegularExpression("\\.[Kk][Ii][Gg][Zz]$"));
         else
             return false;
 
-        const QString tmpfile = tempdir + QLatin1Char('/') + tempname + ".kig";
-        QFile ftmpfile(tmpfile);
-        if (!ftmpfile.open(QIODevice::WriteOnly))
+        QByteArray kigdata;
+        QBuffer buf(&kigdata);
+        if (!buf.open(QIODevice::WriteOnly))
             return false;
-        QTextStream stream(&ftmpfile);
-        // stream.setEncoding();
-        if (!save07(data, stream))
+        if (!save07(data, buf))
+            return false;
+        buf.close();
+
+        // the tar header needs the size of the file up front, that's why
+        // we can't stream into the archive directly..
+        QByteArray tardata;
+        QBuffer tarbuf(&tardata);
+        KTar ark(&tarbuf);
+        if (!ark.open(QIODevice::WriteOnly))
+            return false;
+        if (!ark.writeFile(tempname + ".kig", kigdata))
+            return false;
+        if (!ark.close())
             return false;
-        ftmpfile.close();
-
-        qDebug() << "tmp saved file: " << tmpfile;
-
-        // creating the archive and adding our file
-        KTar ark(outfile, QStringLiteral("application/gzip"));
-        ark.open(QIODevice::WriteOnly);
-        ark.addLocalFile(tmpfile, tempname + ".kig");
-        ark.close();
-
-        // finally, removing temp file
-        QFile::remove(tmpfile);
 
-        return true;
+        KCompressionDevice gz(outfile, KCompressionDevice::GZip);
+        if (!gz.open(QIODevice::WriteOnly)) {
+            fileNotFound(outfile);
+            return false;
+        }
+        if (gz.write(tardata) != tardata.size())
+            return false;
+        gz.close();
+        return gz.error() == QFileDevice::NoError;
     } else {
         QFile file(outfile);
         if (!file.open(QIODevice::WriteOnly)) {
             fileNotFound(outfile);
             return false;
         }
-        QTextStream stream(&file);
-        stream.setEncoding(QStringConverter::Utf8);
-        return save07(data, stream);
+        // QFile buffers the writes for us, the stream writer hands it
+        // small chunks..
+        if (!save07(data, file))
+            return false;
+        return file.flush();
     }
 
     // we should never reach this point...
@@ -6,10 +6,15 @@
 
 #include "filter.h"
 
+#include <vector>
+
 class QDomElement;
 class QDomDocument;
+class QIODevice;
+class QXmlStreamReader;
 class KigDocument;
-class QTextStream;
+class ObjectCalcer;
+class ObjectType;
 class QString;
 
 /**
@@ -27,15 +32,33 @@ private:
     KigDocument *load04(const QDomElement &doc);
     /**
      * this is the load function for the Kig format that is used
-     * starting at Kig 0.7
+     * starting at Kig 0.7.  It reads the file in one pass, building
+     * the calcers as it goes, \p xml should be positioned on the
+     * KigDocument element.
+     */
+    KigDocument *load07(QXmlStreamReader &xml);
+    /**
+     * load a document from an open device, in any format we support..
+     */
+    KigDocument *load(QIODevice &dev);
+
+    /**
+     * shows an error and returns false if we can't read files written
+     * with Kig version \p major.\p minor
+     */
+    bool supportedVersion(int major, int minor, const QString &version);
+    /**
+     * find the ObjectType called \p name, mapping obsolete types to
+     * their replacement, which might need to reorder \p parents.
+     * Shows an error and returns 0 if the type is unknown.
      */
-    KigDocument *load07(const QDomElement &doc);
+    const ObjectType *findType(const QString &name, std::vector<ObjectCalcer *> &parents);
 
     /**
      * save in the Kig format that is used starting at Kig 0.7
      */
     bool save07(const KigDocument &data, const QString &outfile);
-    bool save07(const KigDocument &data, QTextStream &file);
+    bool save07(const KigDocument &data, QIODevice &file);
 
     KigFilterNative();
     ~KigFilterNative();
@@ -46,6 +69,7 @@ public:
     bool supportMime(const QString &mime) override;
     KigDocument *load(const QString &file) override;
     KigDocument *load(const QDomDocument &doc);
+    bool isReentrant() const override;
 
     bool save(const KigDocument &data, const QString &file);
     //  bool save( const KigDocument& data, QTextStream& stream );
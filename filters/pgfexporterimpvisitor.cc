@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "pgfexporterimpvisitor.h"
+#include "filters-common.h"
 
 #include "../misc/goniometry.h"
 #include "../objects/bezier_imp.h"
@@ -107,34 +108,7 @@ void PGFExporterImpVisitor::emitLine(const Coordinate &a, const Coordinate &b, c
 
 void PGFExporterImpVisitor::plotGenericCurve(const CurveImp *imp)
 {
-    std::vector<std::vector<Coordinate>> coordlist;
-    coordlist.push_back(std::vector<Coordinate>());
-    uint curid = 0;
-
-    Coordinate c;
-    Coordinate prev = Coordinate::invalidCoord();
-    for (double i = 0.0; i <= 1.0; i += 0.0001) {
-        c = imp->getPoint(i, mw.document());
-        if (!c.valid()) {
-            if (coordlist[curid].size() > 0) {
-                coordlist.push_back(std::vector<Coordinate>());
-                ++curid;
-                prev = Coordinate::invalidCoord();
-            }
-            continue;
-        }
-        if (!((fabs(c.x) <= 10000) && (fabs(c.y) <= 10000)))
-            continue;
-        // if there's too much distance between this coordinate and the previous
-        // one, then it's another piece of curve not joined with the rest
-        if (prev.valid() && (c.distance(prev) > 50.0)) {
-            coordlist.push_back(std::vector<Coordinate>());
-            ++curid;
-        }
-        coordlist[curid].push_back(c);
-        prev = c;
-    }
-
+    const std::vector<std::vector<Coordinate>> coordlist = filtersTessellateCurve(imp, mdoc, msr, msi.pixelWidth() / 4);
     for (uint i = 0; i < coordlist.size(); ++i) {
         uint s = coordlist[i].size();
         // there's no point in draw curves empty or with only one point
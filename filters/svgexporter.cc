@@ -4,20 +4,17 @@
 
 #include "svgexporter.h"
 
+#include "svgexporterimpvisitor.h"
 #include "svgexporteroptions.h"
 
 #include "../kig/kig_document.h"
 #include "../kig/kig_part.h"
 #include "../kig/kig_view.h"
-#include "../misc/common.h"
 #include "../misc/kigfiledialog.h"
-#include "../misc/kigpainter.h"
-
-#include <map>
 
 #include <QFile>
 #include <QStandardPaths>
-#include <QSvgGenerator>
+#include <QTextStream>
 
 #include <KMessageBox>
 
@@ -61,37 +58,28 @@ void SVGExporter::run(const KigPart &part, KigWidget &w)
     delete opts;
     delete kfd;
 
-    QFile file(file_name);
-    if (!file.open(QIODevice::WriteOnly)) {
+    if (!write(part.document(), w.screenInfo(), file_name, showgrid, showaxes)) {
         KMessageBox::error(&w,
                            i18n("The file \"%1\" could not be opened. Please "
                                 "check if the file permissions are set correctly.",
                                 file_name));
-        return;
-    };
-
-    QRect viewrect(w.screenInfo().viewRect());
-    QRect r(0, 0, viewrect.width(), viewrect.height());
-
-    // workaround for QSvgGenerator bug not checking for already open device
-    file.close();
-    QSvgGenerator pic;
-    pic.setOutputDevice(&file);
-    pic.setSize(r.size());
-    KigPainter *p = new KigPainter(ScreenInfo(w.screenInfo().shownRect(), viewrect), &pic, part.document());
-    //  p->setWholeWinOverlay();
-    //  p->setBrushColor( Qt::white );
-    //  p->setBrushStyle( Qt::SolidPattern );
-    //  p->drawRect( r );
-    //  p->setBrushStyle( Qt::NoBrush );
-    //  p->setWholeWinOverlay();
-    p->drawGrid(part.document().coordinateSystem(), showgrid, showaxes);
-    p->drawObjects(part.document().objects(), false);
-
-    delete p;
-
-    if (!file.flush()) {
-        KMessageBox::error(&w, i18n("Sorry, something went wrong while saving to SVG file \"%1\"", file_name));
     }
-    file.close();
+}
+
+bool SVGExporter::write(const KigDocument &doc, const ScreenInfo &si, const QString &file_name, bool showgrid, bool showaxes)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    SVGExporterImpVisitor visitor(doc, si);
+    visitor.drawGrid(doc.coordinateSystem(), showgrid, showaxes);
+    std::vector<ObjectHolder *> os = doc.objects();
+    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
+        visitor.visit(*i);
+
+    QTextStream stream(&file);
+    visitor.write(stream);
+    stream.flush();
+    return stream.status() == QTextStream::Ok && file.flush();
 }
@@ -21,4 +21,10 @@ public:
     QString menuEntryName() const override;
     QString menuIcon() const override;
     void run(const KigPart &part, KigWidget &w) override;
+
+    /**
+     * Write the part \p si of \p doc to the SVG file \p file, without
+     * asking the user anything.  Returns false on failure.
+     */
+    static bool write(const KigDocument &doc, const ScreenInfo &si, const QString &file, bool showgrid, bool showaxes);
 };
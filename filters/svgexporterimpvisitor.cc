@@ -0,0 +1,717 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "svgexporterimpvisitor.h"
+#include "filters-common.h"
+
+#include "../misc/common.h"
+#include "../misc/coordinate_system.h"
+#include "../objects/bezier_imp.h"
+#include "../objects/circle_imp.h"
+#include "../objects/conic_imp.h"
+#include "../objects/cubic_imp.h"
+#include "../objects/curve_imp.h"
+#include "../objects/line_imp.h"
+#include "../objects/locus_imp.h"
+#include "../objects/object_drawer.h"
+#include "../objects/object_holder.h"
+#include "../objects/other_imp.h"
+#include "../objects/point_imp.h"
+#include "../objects/polygon_imp.h"
+#include "../objects/text_imp.h"
+
+#include <cmath>
+
+#include <QFontMetricsF>
+#include <QLocale>
+#include <QStringList>
+#include <QTextStream>
+
+// the error of a curve adds up: the tessellation may be off by
+// curvetolerance, the simplification of the polyline by another
+// polylinetolerance, and rounding to tenths of pixels by up to 0.05 *
+// sqrt(2), so it stays below half a pixel..
+static const double curvetolerance = 0.2;
+static const double polylinetolerance = 0.2;
+
+static qint64 tenths(double v)
+{
+    return qRound64(v * 10);
+}
+
+/**
+ * \p n tenths in the shortest form svg understands: no trailing zeros
+ * and no leading zero..
+ */
+static QString formatNumber(qint64 n)
+{
+    QString ret;
+    if (n < 0) {
+        ret += QLatin1Char('-');
+        n = -n;
+    }
+    if (n >= 10 || n == 0)
+        ret += QString::number(n / 10);
+    if (n % 10 != 0)
+        ret += QLatin1Char('.') + QString::number(n % 10);
+    return ret;
+}
+
+static QString formatColor(const QColor &c)
+{
+    const QString name = c.name();
+    // #rrggbb -> #rgb if possible..
+    if (name[1] != name[2] || name[3] != name[4] || name[5] != name[6])
+        return name;
+    QString ret(QLatin1Char('#'));
+    ret += name[1];
+    ret += name[3];
+    ret += name[5];
+    return ret;
+}
+
+SVGExporterImpVisitor::SVGExporterImpVisitor(const KigDocument &doc, const ScreenInfo &si)
+    : mdoc(doc)
+    , msi(si)
+    , msr(si.shownRect())
+    , mcurobj(nullptr)
+    , mcurstyle(-1)
+    , mpenvalid(false)
+    , mpenx(0)
+    , mpeny(0)
+    , msubpathx(0)
+    , msubpathy(0)
+{
+}
+
+int SVGExporterImpVisitor::styleId(const QString &css)
+{
+    std::map<QString, int>::const_iterator i = mstyleids.find(css);
+    if (i != mstyleids.end())
+        return i->second;
+    const int id = mstyles.size();
+    mstyles.push_back(css);
+    mstyleids[css] = id;
+    return id;
+}
+
+QString SVGExporterImpVisitor::strokeStyle(const QColor &c, int width, Qt::PenStyle style) const
+{
+    if (width < 1)
+        width = 1;
+    QString ret = QStringLiteral("fill:none;stroke:") + formatColor(c);
+    if (width != 1)
+        ret += QStringLiteral(";stroke-width:") + QString::number(width);
+    // the dash patterns of Qt, they are relative to the width of the
+    // pen..
+    QList<int> dashes;
+    if (style == Qt::DashLine)
+        dashes << 4 << 2;
+    else if (style == Qt::DotLine)
+        dashes << 1 << 2;
+    else if (style == Qt::DashDotLine)
+        dashes << 4 << 2 << 1 << 2;
+    else if (style == Qt::DashDotDotLine)
+        dashes << 4 << 2 << 1 << 2 << 1 << 2;
+    if (!dashes.isEmpty()) {
+        ret += QStringLiteral(";stroke-dasharray:");
+        for (int i = 0; i < dashes.size(); ++i) {
+            if (i > 0)
+                ret += QLatin1Char(',');
+            ret += QString::number(dashes[i] * width);
+        }
+    }
+    return ret;
+}
+
+QString SVGExporterImpVisitor::fillStyle(const QColor &c, bool border) const
+{
+    QString ret = QStringLiteral("fill:") + formatColor(c);
+    if (c.alpha() != 255)
+        ret += QStringLiteral(";fill-opacity:") + QString::number(c.alphaF(), 'g', 2);
+    if (border)
+        ret += QStringLiteral(";stroke:") + formatColor(c);
+    return ret;
+}
+
+QString SVGExporterImpVisitor::textStyle(const QColor &c, const QFont &f) const
+{
+    QString ret = QStringLiteral("fill:") + formatColor(c) + QStringLiteral(";stroke:none;white-space:pre;font-family:'") + f.family() + QLatin1Char('\'');
+    if (f.pointSizeF() > 0)
+        ret += QStringLiteral(";font-size:") + QString::number(f.pointSizeF()) + QStringLiteral("pt");
+    else
+        ret += QStringLiteral(";font-size:") + QString::number(f.pixelSize()) + QStringLiteral("px");
+    if (f.bold())
+        ret += QStringLiteral(";font-weight:bold");
+    if (f.italic())
+        ret += QStringLiteral(";font-style:italic");
+    return ret;
+}
+
+void SVGExporterImpVisitor::beginPath(int style)
+{
+    if (style == mcurstyle && mstyles[style].startsWith(QLatin1String("fill:none")))
+        return;
+    flushPath();
+    mcurstyle = style;
+}
+
+void SVGExporterImpVisitor::flushPath()
+{
+    if (!mcurpath.isEmpty())
+        mbody += QStringLiteral("<path class=\"s%1\" d=\"%2\"/>\n").arg(mcurstyle).arg(mcurpath);
+    mcurpath.clear();
+    mcurstyle = -1;
+    mlastcmd = QChar();
+    mpenvalid = false;
+}
+
+void SVGExporterImpVisitor::appendCommand(QChar cmd)
+{
+    // a repeated command can be left out, except after a moveto, which
+    // would turn the next pair into a lineto..
+    if (cmd == mlastcmd && cmd != QLatin1Char('m') && cmd != QLatin1Char('M') && cmd != QLatin1Char('z'))
+        return;
+    mcurpath += cmd;
+    mlastcmd = cmd;
+}
+
+void SVGExporterImpVisitor::appendNumber(qint64 n)
+{
+    // the minus sign separates the numbers by itself..
+    if (n >= 0 && !mcurpath.isEmpty() && !mcurpath.at(mcurpath.size() - 1).isLetter())
+        mcurpath += QLatin1Char(' ');
+    mcurpath += formatNumber(n);
+}
+
+void SVGExporterImpVisitor::moveTo(const Coordinate &p)
+{
+    const qint64 x = tenths(p.x);
+    const qint64 y = tenths(p.y);
+    // this is where the last primitive ended, so we just go on from
+    // here..
+    if (mpenvalid && x == mpenx && y == mpeny)
+        return;
+    if (mpenvalid) {
+        appendCommand(QLatin1Char('m'));
+        appendNumber(x - mpenx);
+        appendNumber(y - mpeny);
+    } else {
+        appendCommand(QLatin1Char('M'));
+        appendNumber(x);
+        appendNumber(y);
+    }
+    mpenvalid = true;
+    mpenx = msubpathx = x;
+    mpeny = msubpathy = y;
+}
+
+void SVGExporterImpVisitor::lineTo(const Coordinate &p)
+{
+    const qint64 x = tenths(p.x);
+    const qint64 y = tenths(p.y);
+    if (x == mpenx && y == mpeny)
+        return;
+    appendCommand(QLatin1Char('l'));
+    appendNumber(x - mpenx);
+    appendNumber(y - mpeny);
+    mpenx = x;
+    mpeny = y;
+}
+
+void SVGExporterImpVisitor::closePath()
+{
+    appendCommand(QLatin1Char('z'));
+    mpenx = msubpathx;
+    mpeny = msubpathy;
+}
+
+void SVGExporterImpVisitor::bezierTo(const std::vector<Coordinate> &pts)
+{
+    // the control points are relative to the start of the curve, not to
+    // each other..
+    appendCommand(pts.size() == 2 ? QLatin1Char('q') : QLatin1Char('c'));
+    const qint64 startx = mpenx;
+    const qint64 starty = mpeny;
+    for (std::vector<Coordinate>::const_iterator i = pts.begin(); i != pts.end(); ++i) {
+        appendNumber(tenths(i->x) - startx);
+        appendNumber(tenths(i->y) - starty);
+    }
+    mpenx = tenths(pts.back().x);
+    mpeny = tenths(pts.back().y);
+}
+
+Coordinate SVGExporterImpVisitor::toScreen(const Coordinate &c) const
+{
+    const QPointF p = msi.toScreenF(c);
+    return Coordinate(p.x(), p.y());
+}
+
+void SVGExporterImpVisitor::emitPolyline(const std::vector<Coordinate> &pts, int style, bool closed)
+{
+    std::vector<Coordinate> line(pts);
+    if (!closed)
+        filtersSimplifyPolyline(line, polylinetolerance);
+    if (line.size() < 2)
+        return;
+    beginPath(style);
+    moveTo(line[0]);
+    for (uint i = 1; i < line.size(); ++i)
+        lineTo(line[i]);
+    if (closed)
+        closePath();
+}
+
+void SVGExporterImpVisitor::emitSegment(const Coordinate &a, const Coordinate &b, int style)
+{
+    beginPath(style);
+    moveTo(a);
+    lineTo(b);
+}
+
+void SVGExporterImpVisitor::emitArc(const Coordinate &center, double radius, double startangle, double angle, int style)
+{
+    // the y axis points down on the screen, so the angles go the other
+    // way round..
+    if (angle > 2 * M_PI)
+        angle = 2 * M_PI;
+    else if (angle < -2 * M_PI)
+        angle = -2 * M_PI;
+    beginPath(style);
+    moveTo(center + radius * Coordinate(cos(startangle), -sin(startangle)));
+    // an arc of more than half a circle is written in two parts, so
+    // that the large-arc flag is never needed, and a full circle still
+    // has two distinct end points..
+    const int n = fabs(angle) > M_PI ? 2 : 1;
+    const qint64 r = tenths(radius);
+    for (int i = 1; i <= n; ++i) {
+        const double a = startangle + angle * i / n;
+        const Coordinate end = center + radius * Coordinate(cos(a), -sin(a));
+        const qint64 x = tenths(end.x);
+        const qint64 y = tenths(end.y);
+        appendCommand(QLatin1Char('a'));
+        appendNumber(r);
+        appendNumber(r);
+        appendNumber(0);
+        appendNumber(0);
+        appendNumber(angle > 0 ? 0 : 10);
+        appendNumber(x - mpenx);
+        appendNumber(y - mpeny);
+        mpenx = x;
+        mpeny = y;
+    }
+}
+
+void SVGExporterImpVisitor::emitCircle(const Coordinate &center, double radius, int style)
+{
+    emitArc(center, radius, 0, 2 * M_PI, style);
+    closePath();
+}
+
+void SVGExporterImpVisitor::emitRect(const Coordinate &topleft, double width, double height, int style)
+{
+    beginPath(style);
+    moveTo(topleft);
+    const qint64 w = tenths(topleft.x + width) - mpenx;
+    const qint64 h = tenths(topleft.y + height) - mpeny;
+    appendCommand(QLatin1Char('h'));
+    appendNumber(w);
+    appendCommand(QLatin1Char('v'));
+    appendNumber(h);
+    appendCommand(QLatin1Char('h'));
+    appendNumber(-w);
+    closePath();
+}
+
+void SVGExporterImpVisitor::emitText(const Coordinate &topleft, const QString &text, int style, const QFont &f)
+{
+    flushPath();
+    const QFontMetricsF fm(f);
+    const QStringList lines = text.split(QLatin1Char('\n'));
+    const QString x = formatNumber(tenths(topleft.x));
+    mbody += QStringLiteral("<text class=\"s%1\" x=\"%2\" y=\"%3\">").arg(style).arg(x, formatNumber(tenths(topleft.y + fm.ascent())));
+    if (lines.size() == 1)
+        mbody += text.toHtmlEscaped();
+    else {
+        const QString dy = formatNumber(tenths(fm.lineSpacing()));
+        for (int i = 0; i < lines.size(); ++i)
+            mbody += QStringLiteral("<tspan x=\"%1\" dy=\"%2\">%3</tspan>").arg(x, i == 0 ? QStringLiteral("0") : dy, lines[i].toHtmlEscaped());
+    }
+    mbody += QStringLiteral("</text>\n");
+}
+
+void SVGExporterImpVisitor::plotGenericCurve(const CurveImp *imp)
+{
+    const int style = styleId(strokeStyle(mcurobj->drawer()->color(), mcurobj->drawer()->width(), mcurobj->drawer()->style()));
+    const std::vector<std::vector<Coordinate>> coordlist = filtersTessellateCurve(imp, mdoc, msr, msi.pixelWidth() * curvetolerance);
+    for (std::vector<std::vector<Coordinate>>::const_iterator i = coordlist.begin(); i != coordlist.end(); ++i) {
+        std::vector<Coordinate> pts;
+        pts.reserve(i->size());
+        for (std::vector<Coordinate>::const_iterator j = i->begin(); j != i->end(); ++j)
+            pts.push_back(toScreen(*j));
+        emitPolyline(pts, style);
+    }
+}
+
+void SVGExporterImpVisitor::drawGrid(const CoordinateSystem &cs, bool showgrid, bool showaxes)
+{
+    if (!showgrid && !showaxes)
+        return;
+
+    // this follows EuclideanCoords::drawGridLayer() and
+    // PolarCoords::drawGridLayer(), for a painter whose window is the
+    // shown rect..
+    const bool polar = cs.id() == CoordinateSystemFactory::Polar;
+    const double u = msi.pixelWidth();
+    const Coordinate interval = cs.gridInterval(msr, u);
+    const double hd = interval.x;
+    const double vd = interval.y;
+
+    double hmax, hmin, vmax, vmin;
+    if (polar) {
+        hmax = M_SQRT2 * msr.right();
+        hmin = M_SQRT2 * msr.left();
+        vmax = M_SQRT2 * msr.top();
+        vmin = M_SQRT2 * msr.bottom();
+    } else {
+        hmax = ceil(msr.right());
+        hmin = floor(msr.left());
+        vmax = ceil(msr.top());
+        vmin = floor(msr.bottom());
+    }
+
+    double hgraphmin, hgraphmax, vgraphmin, vgraphmax;
+    if (polar) {
+        hgraphmin = floor(hmin / hd) * hd;
+        hgraphmax = ceil(hmax / hd) * hd;
+        vgraphmin = floor(vmin / vd) * vd;
+        vgraphmax = ceil(vmax / vd) * vd;
+    } else {
+        hgraphmin = ceil(hmin / hd) * hd;
+        hgraphmax = floor(hmax / hd) * hd;
+        vgraphmin = ceil(vmin / vd) * vd;
+        vgraphmax = floor(vmax / vd) * vd;
+    }
+
+    int hnfrac = kigMax((int)-floor(log10(hd)), 0);
+    int vnfrac = kigMax((int)-floor(log10(vd)), 0);
+    if (polar)
+        hnfrac = vnfrac = kigMax(hnfrac, vnfrac);
+
+    /****** the grid lines ******/
+    if (showgrid) {
+        const int style = styleId(strokeStyle(Qt::lightGray, 1, Qt::DotLine));
+        if (polar) {
+            const double d = kigMax(kigMin(hd, vd), 10 * u);
+            const double dx = msr.left() > 0 ? msr.left() : (msr.right() < 0 ? -msr.right() : 0);
+            const double dy = msr.bottom() > 0 ? msr.bottom() : (msr.top() < 0 ? -msr.top() : 0);
+            const double rmin = sqrt(dx * dx + dy * dy);
+            const double rmax = kigMax(kigMax(msr.topLeft().length(), msr.topRight().length()), kigMax(msr.bottomLeft().length(), msr.bottomRight().length()));
+            const Coordinate origin(0, 0);
+            const Coordinate center = toScreen(origin);
+            const Coordinate mid = msr.center() - origin;
+            const double midangle = atan2(mid.y, mid.x);
+            const Coordinate corners[] = {msr.topLeft(), msr.topRight(), msr.bottomLeft(), msr.bottomRight()};
+            for (double i = kigMax(ceil(rmin / d), 1.) * d; i <= rmax + d / 2; i += d) {
+                if (i < msr.width() + msr.height()) {
+                    emitCircle(center, i / u, style);
+                    continue;
+                }
+                // only the part of a huge circle that goes through the
+                // window..
+                double minangle = 0;
+                double maxangle = 0;
+                for (int j = 0; j < 4; ++j) {
+                    const Coordinate v = corners[j] - origin;
+                    const double a = remainder(atan2(v.y, v.x) - midangle, 2 * M_PI);
+                    minangle = kigMin(minangle, a);
+                    maxangle = kigMax(maxangle, a);
+                }
+                emitArc(center, i / u, midangle + minangle, maxangle - minangle, style);
+            }
+        } else {
+            // vertical lines...
+            for (double i = hgraphmin; i <= hgraphmax + hd / 2; i += hd)
+                emitSegment(toScreen(Coordinate(i, vgraphmin)), toScreen(Coordinate(i, vgraphmax)), style);
+            // horizontal lines...
+            for (double i = vgraphmin; i <= vgraphmax + vd / 2; i += vd)
+                emitSegment(toScreen(Coordinate(hgraphmin, i)), toScreen(Coordinate(hgraphmax, i)), style);
+        }
+    }
+
+    /****** the axes ******/
+    if (showaxes) {
+        const int style = styleId(strokeStyle(Qt::gray, 1, Qt::SolidLine));
+        emitSegment(toScreen(Coordinate(hmin, 0)), toScreen(Coordinate(hmax, 0)), style);
+        emitSegment(toScreen(Coordinate(0, vmin)), toScreen(Coordinate(0, vmax)), style);
+
+        // the arrows, see drawAxesArrows()..
+        const int arrowstyle = styleId(fillStyle(Qt::gray, true));
+        const double ahmax = polar ? hmax : ceil(msr.right());
+        const double avmax = polar ? vmax : ceil(msr.top());
+        std::vector<Coordinate> a;
+        a.push_back(toScreen(Coordinate(ahmax - 6 * u, -3 * u)));
+        a.push_back(toScreen(Coordinate(ahmax, 0)));
+        a.push_back(toScreen(Coordinate(ahmax - 6 * u, 3 * u)));
+        emitPolyline(a, arrowstyle, true);
+        a.clear();
+        a.push_back(toScreen(Coordinate(3 * u, avmax - 6 * u)));
+        a.push_back(toScreen(Coordinate(0, avmax)));
+        a.push_back(toScreen(Coordinate(-3 * u, avmax - 6 * u)));
+        emitPolyline(a, arrowstyle, true);
+
+        /****** the numbers ******/
+        const QLocale currentLocale;
+        const QFont font;
+        const QFontMetricsF fm(font);
+        const int textstyle = styleId(textStyle(Qt::gray, font));
+        // x axis, below the axis..
+        for (double i = hgraphmin; i <= hgraphmax + hd / 2; i += hd) {
+            // we skip 0 since that would look stupid... (the axes going
+            // through the 0 etc. )
+            if (fabs(i) < 1e-8)
+                continue;
+            emitText(toScreen(Coordinate(i, 0)), currentLocale.toString(polar ? fabs(i) : i, 'f', hnfrac), textstyle, font);
+        }
+        // y axis, above the grid line..
+        for (double i = vgraphmin; i <= vgraphmax + vd / 2; i += vd) {
+            if (fabs(i) < 1e-8)
+                continue;
+            emitText(toScreen(Coordinate(0, i)) - Coordinate(0, fm.height()), currentLocale.toString(polar ? fabs(i) : i, 'f', vnfrac), textstyle, font);
+        }
+    }
+}
+
+void SVGExporterImpVisitor::write(QTextStream &s)
+{
+    flushPath();
+    const QRect r = msi.viewRect();
+    s << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    s << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << r.width() << "\" height=\"" << r.height() << "\" viewBox=\"0 0 " << r.width() << " "
+      << r.height() << "\">\n";
+    s << "<style>\n";
+    // the defaults of QPen..
+    s << "path{stroke-linecap:square;stroke-linejoin:bevel}\n";
+    for (uint i = 0; i < mstyles.size(); ++i)
+        s << ".s" << i << "{" << mstyles[i] << "}\n";
+    s << "</style>\n";
+    s << mbody;
+    s << "</svg>\n";
+}
+
+void SVGExporterImpVisitor::visit(ObjectHolder *obj)
+{
+    if (!obj->drawer()->shown())
+        return;
+    mcurobj = obj;
+    obj->imp()->visit(this);
+}
+
+void SVGExporterImpVisitor::visit(const LineImp *imp)
+{
+    Coordinate a = imp->data().a;
+    Coordinate b = imp->data().b;
+    calcBorderPoints(a, b, msr);
+    emitSegment(toScreen(a), toScreen(b), styleId(strokeStyle(mcurobj->drawer()->color(), mcurobj->drawer()->width(), mcurobj->drawer()->style())));
+}
+
+void SVGExporterImpVisitor::visit(const PointImp *imp)
+{
+    const ObjectDrawer *d = mcurobj->drawer();
+    const Coordinate c = toScreen(imp->coordinate());
+    const double width = d->width() == -1 ? 5 : d->width();
+    const double r = width / 2;
+    switch (d->pointStyle()) {
+    case Kig::Round:
+        emitCircle(c, r, styleId(fillStyle(d->color(), true)));
+        break;
+    case Kig::RoundEmpty:
+        emitCircle(c, r, styleId(strokeStyle(d->color(), 1, d->style())));
+        break;
+    case Kig::Rectangular:
+        emitRect(c - Coordinate(r, r), width, width, styleId(fillStyle(d->color(), true)));
+        break;
+    case Kig::RectangularEmpty:
+        emitRect(c - Coordinate(r, r), width, width, styleId(strokeStyle(d->color(), 1, d->style())));
+        break;
+    case Kig::Cross: {
+        const int style = styleId(strokeStyle(d->color(), 2, Qt::SolidLine));
+        emitSegment(c - Coordinate(r, r), c + Coordinate(r, r), style);
+        emitSegment(c + Coordinate(r, -r), c + Coordinate(-r, r), style);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void SVGExporterImpVisitor::visit(const TextImp *imp)
+{
+    const QFont font = mcurobj->drawer()->font();
+    const Coordinate tl = toScreen(imp->coordinate());
+    if (imp->hasFrame()) {
+        // see KigPainter::drawTextFrame()..
+        const QFontMetricsF fm(font);
+        const QStringList lines = imp->text().split(QLatin1Char('\n'));
+        double w = 0;
+        for (int i = 0; i < lines.size(); ++i)
+            w = kigMax(w, fm.horizontalAdvance(lines[i]));
+        w = ceil(w) + 4;
+        const double h = ceil(lines.size() * fm.lineSpacing()) + 4;
+        emitRect(tl, w, h, styleId(QStringLiteral("fill:#ffffde;stroke:#000")));
+        const int shadow = styleId(strokeStyle(QColor(197, 194, 197), 1, Qt::SolidLine));
+        emitSegment(tl + Coordinate(w, 0), tl, shadow);
+        emitSegment(tl, tl + Coordinate(0, h), shadow);
+    }
+    emitText(tl + Coordinate(2, 2), imp->text(), styleId(textStyle(mcurobj->drawer()->color(), font)), font);
+}
+
+void SVGExporterImpVisitor::visit(const AngleImp *imp)
+{
+    const ObjectDrawer *d = mcurobj->drawer();
+    const Coordinate c = toScreen(imp->point());
+    const double radius = AngleImp::radius;
+    const double start = imp->startAngle();
+    const double angle = imp->angle();
+    const int style = styleId(strokeStyle(d->color(), d->width(), d->style()));
+
+    if (angle == M_PI / 2 && imp->markRightAngle()) {
+        // see KigPainter::drawRightAngle()..
+        const double h = static_cast<int>(radius * sin(M_PI / 4));
+        const Coordinate x = h * Coordinate(cos(start), -sin(start));
+        const Coordinate y = h * Coordinate(-sin(start), -cos(start));
+        std::vector<Coordinate> pts;
+        pts.push_back(c + x);
+        pts.push_back(c + x + y);
+        pts.push_back(c + y);
+        emitPolyline(pts, style);
+        return;
+    }
+
+    emitArc(c, radius, start, angle, style);
+
+    // now for the arrow...
+    const Coordinate end = c + radius * Coordinate(cos(start + angle), -sin(start + angle));
+    const Coordinate vect = (end - c).normalize(6);
+    const Coordinate orthvect(-vect.y, vect.x);
+    std::vector<Coordinate> arrow;
+    arrow.push_back(end);
+    arrow.push_back(end + orthvect + vect);
+    arrow.push_back(end + orthvect - vect);
+    emitPolyline(arrow, styleId(fillStyle(d->color(), true)), true);
+}
+
+void SVGExporterImpVisitor::visit(const VectorImp *imp)
+{
+    const ObjectDrawer *d = mcurobj->drawer();
+    const Coordinate a = toScreen(imp->data().a);
+    const Coordinate b = toScreen(imp->data().b);
+    if (a == b)
+        return;
+    emitSegment(a, b, styleId(strokeStyle(d->color(), d->width(), d->style())));
+
+    // the arrow lines always have a normal style..
+    const Coordinate dir = (b - a).normalize(10);
+    const Coordinate perp(dir.y, -dir.x);
+    const int style = styleId(strokeStyle(d->color(), d->width(), Qt::SolidLine));
+    emitSegment(b - dir + perp, b, style);
+    emitSegment(b, b - dir - perp, style);
+}
+
+void SVGExporterImpVisitor::visit(const LocusImp *imp)
+{
+    plotGenericCurve(imp);
+}
+
+void SVGExporterImpVisitor::visit(const CircleImp *imp)
+{
+    emitCircle(toScreen(imp->center()),
+               imp->radius() / msi.pixelWidth(),
+               styleId(strokeStyle(mcurobj->drawer()->color(), mcurobj->drawer()->width(), mcurobj->drawer()->style())));
+}
+
+void SVGExporterImpVisitor::visit(const ConicImp *imp)
+{
+    plotGenericCurve(imp);
+}
+
+void SVGExporterImpVisitor::visit(const CubicImp *imp)
+{
+    plotGenericCurve(imp);
+}
+
+void SVGExporterImpVisitor::visit(const SegmentImp *imp)
+{
+    emitSegment(toScreen(imp->data().a),
+                toScreen(imp->data().b),
+                styleId(strokeStyle(mcurobj->drawer()->color(), mcurobj->drawer()->width(), mcurobj->drawer()->style())));
+}
+
+void SVGExporterImpVisitor::visit(const RayImp *imp)
+{
+    Coordinate a = imp->data().a;
+    Coordinate b = imp->data().b;
+    calcRayBorderPoints(a, b, msr);
+    emitSegment(toScreen(a), toScreen(b), styleId(strokeStyle(mcurobj->drawer()->color(), mcurobj->drawer()->width(), mcurobj->drawer()->style())));
+}
+
+void SVGExporterImpVisitor::visit(const ArcImp *imp)
+{
+    emitArc(toScreen(imp->center()),
+            imp->radius() / msi.pixelWidth(),
+            imp->startAngle(),
+            imp->angle(),
+            styleId(strokeStyle(mcurobj->drawer()->color(), mcurobj->drawer()->width(), mcurobj->drawer()->style())));
+}
+
+void SVGExporterImpVisitor::visit(const FilledPolygonImp *imp)
+{
+    // see KigPainter::drawPolygon()..
+    QColor color = mcurobj->drawer()->color();
+    color.setAlpha(100);
+    const std::vector<Coordinate> pts = imp->points();
+    std::vector<Coordinate> spts;
+    for (std::vector<Coordinate>::const_iterator i = pts.begin(); i != pts.end(); ++i)
+        spts.push_back(toScreen(*i));
+    emitPolyline(spts, styleId(fillStyle(color)), true);
+}
+
+void SVGExporterImpVisitor::visit(const ClosedPolygonalImp *imp)
+{
+    const std::vector<Coordinate> pts = imp->points();
+    std::vector<Coordinate> spts;
+    for (std::vector<Coordinate>::const_iterator i = pts.begin(); i != pts.end(); ++i)
+        spts.push_back(toScreen(*i));
+    emitPolyline(spts, styleId(strokeStyle(mcurobj->drawer()->color(), mcurobj->drawer()->width(), mcurobj->drawer()->style())), true);
+}
+
+void SVGExporterImpVisitor::visit(const OpenPolygonalImp *imp)
+{
+    const std::vector<Coordinate> pts = imp->points();
+    std::vector<Coordinate> spts;
+    for (std::vector<Coordinate>::const_iterator i = pts.begin(); i != pts.end(); ++i)
+        spts.push_back(toScreen(*i));
+    emitPolyline(spts, styleId(strokeStyle(mcurobj->drawer()->color(), mcurobj->drawer()->width(), mcurobj->drawer()->style())));
+}
+
+void SVGExporterImpVisitor::visit(const BezierImp *imp)
+{
+    const std::vector<Coordinate> pts = imp->points();
+    // quadratic and cubic curves are native in svg..
+    if (pts.size() != 3 && pts.size() != 4) {
+        plotGenericCurve(imp);
+        return;
+    }
+    std::vector<Coordinate> spts;
+    for (std::vector<Coordinate>::const_iterator i = pts.begin(); i != pts.end(); ++i)
+        spts.push_back(toScreen(*i));
+    beginPath(styleId(strokeStyle(mcurobj->drawer()->color(), mcurobj->drawer()->width(), mcurobj->drawer()->style())));
+    moveTo(spts[0]);
+    bezierTo(std::vector<Coordinate>(spts.begin() + 1, spts.end()));
+}
+
+void SVGExporterImpVisitor::visit(const RationalBezierImp *imp)
+{
+    plotGenericCurve(imp);
+}
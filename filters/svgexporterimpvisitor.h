@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <QColor>
+#include <QFont>
+#include <QString>
+
+#include "../misc/coordinate.h"
+#include "../misc/rect.h"
+#include "../misc/screeninfo.h"
+#include "../objects/object_imp.h"
+
+class CoordinateSystem;
+class CurveImp;
+class KigDocument;
+class ObjectHolder;
+class QTextStream;
+
+/**
+ * Writes the objects of a document as SVG, without going through a
+ * QPainter.  Everything is drawn in the pixel coordinates of the view,
+ * just like KigPainter would do it on the screen.
+ *
+ * The styles are written once, as css classes, and consecutive
+ * primitives with the same style are merged into a single path element
+ * with relative coordinates, rounded to a tenth of a pixel.  Curves are
+ * tessellated and simplified so that they are off by less than half a
+ * pixel in all.
+ */
+class SVGExporterImpVisitor : public ObjectImpVisitor
+{
+    const KigDocument &mdoc;
+    const ScreenInfo msi;
+    Rect msr;
+    ObjectHolder *mcurobj;
+
+    /**
+     * the distinct styles, the index of a style is the number of its
+     * css class..
+     */
+    std::vector<QString> mstyles;
+    std::map<QString, int> mstyleids;
+
+    /**
+     * the elements written so far..
+     */
+    QString mbody;
+
+    /**
+     * the path element we are adding to, with its style, or -1 if there
+     * is none.  mpen is the current point of the path, and msubpath the
+     * start of the current subpath, both in tenths of pixels..
+     */
+    int mcurstyle;
+    QString mcurpath;
+    QChar mlastcmd;
+    bool mpenvalid;
+    qint64 mpenx, mpeny;
+    qint64 msubpathx, msubpathy;
+
+    int styleId(const QString &css);
+    QString strokeStyle(const QColor &c, int width, Qt::PenStyle style) const;
+    QString fillStyle(const QColor &c, bool border = false) const;
+    QString textStyle(const QColor &c, const QFont &f) const;
+
+    /**
+     * make the following path commands go to a path element with style
+     * \p style.  Only outlines are added to the path before, a filled
+     * shape always starts a path of its own, or overlapping shapes would
+     * punch holes in each other or not blend..
+     */
+    void beginPath(int style);
+    void flushPath();
+
+    void appendCommand(QChar cmd);
+    void appendNumber(qint64 tenths);
+    void moveTo(const Coordinate &p);
+    void lineTo(const Coordinate &p);
+    void closePath();
+    /**
+     * a quadratic or cubic bezier curve from the current point, through
+     * the control points \p pts..
+     */
+    void bezierTo(const std::vector<Coordinate> &pts);
+
+    /**
+     * the pixel position of \p c..
+     */
+    Coordinate toScreen(const Coordinate &c) const;
+
+    /**
+     * the drawing primitives, all of them take pixel coordinates..
+     */
+    void emitPolyline(const std::vector<Coordinate> &pts, int style, bool closed = false);
+    void emitSegment(const Coordinate &a, const Coordinate &b, int style);
+    void emitCircle(const Coordinate &center, double radius, int style);
+    void emitArc(const Coordinate &center, double radius, double startangle, double angle, int style);
+    void emitRect(const Coordinate &topleft, double width, double height, int style);
+    void emitText(const Coordinate &topleft, const QString &text, int style, const QFont &f);
+
+    /**
+     * Plots a generic curve through its tessellation.
+     */
+    void plotGenericCurve(const CurveImp *imp);
+
+public:
+    SVGExporterImpVisitor(const KigDocument &doc, const ScreenInfo &si);
+
+    /**
+     * draw the grid and the axes of \p cs, like
+     * CoordinateSystem::drawGrid()..
+     */
+    void drawGrid(const CoordinateSystem &cs, bool showgrid, bool showaxes);
+
+    void visit(ObjectHolder *obj);
+
+    /**
+     * write the complete SVG document to \p s..
+     */
+    void write(QTextStream &s);
+
+    using ObjectImpVisitor::visit;
+    void visit(const LineImp *imp) override;
+    void visit(const PointImp *imp) override;
+    void visit(const TextImp *imp) override;
+    void visit(const AngleImp *imp) override;
+    void visit(const VectorImp *imp) override;
+    void visit(const LocusImp *imp) override;
+    void visit(const CircleImp *imp) override;
+    void visit(const ConicImp *imp) override;
+    void visit(const CubicImp *imp) override;
+    void visit(const SegmentImp *imp) override;
+    void visit(const RayImp *imp) override;
+    void visit(const ArcImp *imp) override;
+    void visit(const FilledPolygonImp *imp) override;
+    void visit(const ClosedPolygonalImp *imp) override;
+    void visit(const OpenPolygonalImp *imp) override;
+    void visit(const BezierImp *imp) override;
+    void visit(const RationalBezierImp *imp) override;
+};
@@ -60,7 +60,6 @@ class XFigExportImpVisitor : public ObjectImpVisitor
 {
     QTextStream &mstream;
     ObjectHolder *mcurobj;
-    const KigWidget &mw;
     Rect msr;
     std::map<QColor, int> mcolormap;
     int mnextcolorid;
@@ -81,10 +80,9 @@ public:
     void visit(ObjectHolder *obj);
     void mapColor(const ObjectDrawer *obj);
 
-    XFigExportImpVisitor(QTextStream &s, const KigWidget &w)
+    XFigExportImpVisitor(QTextStream &s, const ScreenInfo &si)
         : mstream(s)
-        , mw(w)
-        , msr(mw.showingRect())
+        , msr(si.shownRect())
         , mnextcolorid(32)
     {
         // predefined colors in XFig..
@@ -562,14 +560,19 @@ void XFigExporter::run(const KigPart &doc, KigWidget &w)
 
     delete kfd;
 
-    QFile file(file_name);
-    if (!file.open(QIODevice::WriteOnly)) {
+    if (!write(doc.document(), w.screenInfo(), file_name)) {
         KMessageBox::error(&w,
                            i18n("The file \"%1\" could not be opened. Please "
                                 "check if the file permissions are set correctly.",
                                 file_name));
-        return;
-    };
+    }
+}
+
+bool XFigExporter::write(const KigDocument &doc, const ScreenInfo &si, const QString &file_name)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
     QTextStream stream(&file);
     stream << "#FIG 3.2  Produced by Kig\n";
     stream << "Landscape\n";
@@ -581,8 +584,8 @@ void XFigExporter::run(const KigPart &doc, KigWidget &w)
     stream << "-2\n";
     stream << "1200 2\n";
 
-    std::vector<ObjectHolder *> os = doc.document().objects();
-    XFigExportImpVisitor visitor(stream, w);
+    std::vector<ObjectHolder *> os = doc.objects();
+    XFigExportImpVisitor visitor(stream, si);
 
     for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i) {
         visitor.mapColor((*i)->drawer());
@@ -591,4 +594,5 @@ void XFigExporter::run(const KigPart &doc, KigWidget &w)
     for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i) {
         visitor.visit(*i);
     };
+    return true;
 }
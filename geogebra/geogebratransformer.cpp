@@ -12,250 +12,373 @@
 #include <objects/bogus_imp.h>
 #include <objects/object_calcer.h>
 #include <objects/object_drawer.h>
-#include <objects/object_factory.h>
-#include <objects/object_holder.h>
 #include <objects/object_type_factory.h>
 
 #include <QDebug>
 
 #include <QColor>
-#include <QXmlName>
-
-void GeogebraTransformer::atomicValue(const QVariant &)
+#include <QXmlStreamReader>
+
+/* Read all the attribute values of the current element, in the order in which
+ * they appear, and skip to its end.  This is what GeoGebra uses for the
+ * arguments of a command ( <input a0="A" a1="B"/> ) and for the inputs and
+ * outputs of a macro.
+ */
+static void readAttributeValues(QXmlStreamReader &xml, std::vector<QString> &ret)
 {
-    // I wish I could use this...
+    const QXmlStreamAttributes attrs = xml.attributes();
+    for (const QXmlStreamAttribute &a : attrs)
+        ret.push_back(a.value().toString());
+    xml.skipCurrentElement();
 }
 
-void GeogebraTransformer::attribute(const QXmlName &name, const QStringRef &value)
+bool GeogebraTransformer::transform(QIODevice *device)
 {
-    if (name.localName(m_np) == QLatin1String("label")) {
-        const QByteArray objectLabel = value.toLatin1();
-        bool isDoubleValue;
-        const double dblval = value.toString().toDouble(&isDoubleValue);
-
-        switch (m_currentState) {
-        case GeogebraTransformer::ReadingObject:
-            m_currentObjectLabel = value.toLatin1();
-            // There must be a better place for this
-            m_currentState = GeogebraTransformer::ReadingArguments;
-
-            break;
-        case GeogebraTransformer::ReadingArguments:
-            if (isDoubleValue) {
-                /* This is to handle the circle-point-radius, dilate (and similar) type of Geogebra objects.
-                 * <command name="Circle">
-                 * <input a0="A" a1="3"/>
-                 * <output a0="c"/>
-                 *
-                 * Notice the attribute 'a1' of the 'input' element. The value - '3' is the radius of the circle.
-                 * First, we try to convert that value to Double. If the conversion suceeds, we stack a DoubleImp (Calcer)
-                 * in the m_currentArgStack and break. Otherwise, we check the m_objectMap for that label entry.
-                 */
-                DoubleImp *doubleImp = new DoubleImp(dblval);
-                m_currentArgStack.push_back(new ObjectConstCalcer(doubleImp));
-            } else if (m_objectMap.contains(objectLabel)) {
-                m_currentArgStack.push_back(m_objectMap[objectLabel]);
-            } else {
-                // TODO Figure out error reporting
-            }
-
-            break;
-        default:
-            break;
-        }
-    } else if (name.localName(m_np) == QLatin1String("value")) {
-        Q_ASSERT(m_currentState == ReadingDouble);
-        DoubleImp *doubleImp = new DoubleImp(value.toString().toDouble());
-
-        m_currentArgStack.push_back(new ObjectConstCalcer(doubleImp));
-    } else if (name.localName(m_np) == QLatin1String("Name")) {
-        m_sections[m_nsections - 1].setName(value.toString());
-    } else if (name.localName(m_np) == QLatin1String("Description")) {
-        m_sections[m_nsections - 1].setDescription(value.toString());
-    } else if (name.localName(m_np) == QLatin1String("Input")) {
-        m_inputObjectLabels.insert(value.toLatin1());
-    } else if (name.localName(m_np) == QLatin1String("Output")) {
-        m_outputObjectLabels.insert(value.toLatin1());
-    } else if (name.localName(m_np) == QLatin1String("show")) {
-        m_show = ((value.toString() == QLatin1String("true")) ? true : false);
-    } else if (name.localName(m_np) == QLatin1String("thickness")) {
-        m_thickness = value.toString().toInt();
-    } else if (name.localName(m_np) == QLatin1String("thickness_point")) {
-        m_thickness = value.toString().toInt();
-        m_thickness += 6;
-    } else if (name.localName(m_np) == QLatin1String("type")) {
-        int penType = value.toString().toInt();
-        switch (penType) {
-        case SOLIDLINE:
-            m_type = Qt::SolidLine;
-            break;
-        case DASHDOTDOTLINE:
-            m_type = Qt::DashDotDotLine;
-            break;
-        case DASHLINE:
-            m_type = Qt::DashLine;
-            break;
-        case DOTLINE:
-            m_type = Qt::DotLine;
-            break;
-        case DASHDOTLINE:
-            m_type = Qt::DashDotLine;
-            break;
-        default:
-            m_type = Qt::SolidLine;
-        };
-    } else if (name.localName(m_np) == QLatin1String("pointType")) {
-        int pt = value.toString().toInt();
-        if (pt == SOLIDCIRCLEPOINT)
-            m_pointType = Kig::pointStyleFromString(QStringLiteral("Round"));
-        else if (pt == SOLIDDIAMONDPOINT || pt == UPARROWPOINT || pt == DOWNARROWPOINT || pt == RIGHTARROWPOINT || pt == LEFTARROWPOINT)
-            m_pointType = Kig::pointStyleFromString(QStringLiteral("Rectangular"));
-        else if (pt == HOLLOWCIRCLEPOINT)
-            m_pointType = Kig::pointStyleFromString(
-                QStringLiteral("Round")); // TODO should be mapped to RoundEmpty ( i.e. 1) but for some reason it is not drawing in KIG
-        else if (pt == HOLLOWDIAMONDPOINT)
-            m_pointType = Kig::pointStyleFromString(
-                QStringLiteral("Rectangular")); // TODO should be mapped to RectangularEmpty ( i.e. 3) but for some reason it is not drawing in KIG
-        else if (pt == CROSSPOINT || pt == PLUSPOINT)
-            m_pointType = Kig::pointStyleFromString(QStringLiteral("Cross"));
+    QXmlStreamReader xml(device);
+    if (!xml.readNextStartElement() || xml.name() != QLatin1String("geogebra"))
+        return false;
+
+    QString axes, grid;
+    bool view = false;
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("construction")) {
+            m_sections.push_back(GeogebraSection());
+            readConstruction(xml, m_sections.back(), QSet<QString>(), QSet<QString>());
+        } else if (xml.name() == QLatin1String("macro"))
+            readMacro(xml);
+        else if (xml.name() == QLatin1String("euclidianView") && !view)
+            view = readEuclidianView(xml, axes, grid);
         else
-            m_pointType = Kig::Round;
-    } else if (name.localName(m_np) == QLatin1String("r")) {
-        m_r = value.toString().toInt();
-    } else if (name.localName(m_np) == QLatin1String("g")) {
-        m_g = value.toString().toInt();
-    } else if (name.localName(m_np) == QLatin1String("b")) {
-        m_b = value.toString().toInt();
-    } else if (name.localName(m_np) == QLatin1String("alpha")) {
-        m_alpha = value.toString().toInt();
-    } else if (name.localName(m_np) == QLatin1String("axes")) {
-        bool showAxes = value.toString() == QLatin1String("true") ? true : false;
-        m_document->setAxes(showAxes);
-    } else if (name.localName(m_np) == QLatin1String("grid")) {
-        bool showGrid = value.toString() == QLatin1String("true") ? true : false;
-        m_document->setGrid(showGrid);
+            xml.skipCurrentElement();
     }
-}
 
-void GeogebraTransformer::characters(const QStringRef &)
-{
+    // a missing setting means false, just like it always did..
+    m_document->setAxes(axes == QLatin1String("true"));
+    m_document->setGrid(grid == QLatin1String("true"));
+
+    if (xml.hasError()) {
+        qWarning() << "Error reading GeoGebra file:" << xml.errorString();
+        return false;
+    }
+    return true;
 }
 
-void GeogebraTransformer::comment(const QString &)
+bool GeogebraTransformer::readEuclidianView(QXmlStreamReader &xml, QString &axes, QString &grid)
 {
+    bool found = false;
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("evSettings") && !found) {
+            axes = xml.attributes().value(QLatin1String("axes")).toString();
+            grid = xml.attributes().value(QLatin1String("grid")).toString();
+            found = true;
+        }
+        xml.skipCurrentElement();
+    }
+    return found;
 }
 
-void GeogebraTransformer::endDocument()
+void GeogebraTransformer::readMacro(QXmlStreamReader &xml)
 {
+    m_sections.push_back(GeogebraSection());
+    GeogebraSection &section = m_sections.back();
+    section.setName(xml.attributes().value(QLatin1String("toolName")).toString());
+
+    // GeoGebra writes the inputs and outputs of a macro before its construction
+    QSet<QString> inputs, outputs;
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("toolHelp"))
+            section.setDescription(xml.readElementText(QXmlStreamReader::IncludeChildElements));
+        else if (xml.name() == QLatin1String("macroInput") || xml.name() == QLatin1String("macroOutput")) {
+            std::vector<QString> labels;
+            const bool input = xml.name() == QLatin1String("macroInput");
+            readAttributeValues(xml, labels);
+            for (std::vector<QString>::const_iterator i = labels.begin(); i != labels.end(); ++i)
+                (input ? inputs : outputs).insert(*i);
+        } else if (xml.name() == QLatin1String("construction"))
+            readConstruction(xml, section, inputs, outputs);
+        else
+            xml.skipCurrentElement();
+    }
 }
 
-void GeogebraTransformer::endElement()
+void GeogebraTransformer::readConstruction(QXmlStreamReader &xml, GeogebraSection &section, const QSet<QString> &inputs, const QSet<QString> &outputs)
 {
-    switch (m_currentState) {
-    case GeogebraTransformer::ReadingObject:
-        if (m_currentObject) {
-            if (!m_objectMap.contains(m_currentObjectLabel)) {
-                ObjectTypeCalcer *oc = new ObjectTypeCalcer(m_currentObject, m_currentArgStack);
-
-                oc->calc(*m_document);
-                m_objectMap.insert(m_currentObjectLabel, oc);
-
-                // Decide where to put this object
-                if (m_inputObjectLabels.empty()) {
-                    // Not handling input/output objects, put everything in second
-                    ObjectDrawer *od = new ObjectDrawer(QColor(m_r, m_g, m_b), m_thickness, m_show, m_type, m_pointType);
-
-                    m_sections[m_nsections - 1].addOutputObject(oc);
-                    m_sections[m_nsections - 1].addDrawer(od);
-                } else {
-                    if (m_inputObjectLabels.contains(m_currentObjectLabel)) {
-                        m_sections[m_nsections - 1].addInputObject(oc);
-                    } else if (m_outputObjectLabels.contains(m_currentObjectLabel)) {
-                        m_sections[m_nsections - 1].addOutputObject(oc);
-                    }
+    std::vector<Command> commands;
+    std::vector<Element> elements;
+    // the commands and elements in document order, an index into
+    // elements is stored as -( index + 1 )..
+    std::vector<int> order;
+
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("command")) {
+            Command c;
+            c.name = xml.attributes().value(QLatin1String("name")).toString();
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("input"))
+                    readAttributeValues(xml, c.inputs);
+                else if (xml.name() == QLatin1String("output"))
+                    readAttributeValues(xml, c.outputs);
+                else
+                    xml.skipCurrentElement();
+            }
+            order.push_back(commands.size());
+            commands.push_back(c);
+        } else if (xml.name() == QLatin1String("element")) {
+            Element e;
+            e.type = xml.attributes().value(QLatin1String("type")).toString();
+            e.label = xml.attributes().value(QLatin1String("label")).toString();
+            while (xml.readNextStartElement()) {
+                const QXmlStreamAttributes attrs = xml.attributes();
+                if (xml.name() == QLatin1String("show"))
+                    e.show = attrs.value(QLatin1String("object")).toString();
+                else if (xml.name() == QLatin1String("objColor")) {
+                    e.r = attrs.value(QLatin1String("r")).toString();
+                    e.g = attrs.value(QLatin1String("g")).toString();
+                    e.b = attrs.value(QLatin1String("b")).toString();
+                } else if (xml.name() == QLatin1String("lineStyle")) {
+                    e.thickness = attrs.value(QLatin1String("thickness")).toString();
+                    e.lineType = attrs.value(QLatin1String("type")).toString();
+                } else if (xml.name() == QLatin1String("pointSize"))
+                    e.pointSize = attrs.value(QLatin1String("val")).toString();
+                else if (xml.name() == QLatin1String("pointStyle"))
+                    e.pointStyle = attrs.value(QLatin1String("val")).toString();
+                else if (xml.name() == QLatin1String("coords")) {
+                    e.x = attrs.value(QLatin1String("x")).toString();
+                    e.y = attrs.value(QLatin1String("y")).toString();
                 }
+                xml.skipCurrentElement();
             }
-
-            m_currentArgStack.clear();
-            m_currentObject = nullptr;
-        }
-
-        break;
-    case GeogebraTransformer::ReadingArguments:
-    case GeogebraTransformer::ReadingDouble:
-        /* We do this because every argument may be the
-         * last argument of the stack. If it is not, then
-         * startElement() will reset this to ReadingArguments
-         */
-        m_currentState = GeogebraTransformer::ReadingObject;
-
-        break;
-    default:
-        break;
+            order.push_back(-static_cast<int>(elements.size()) - 1);
+            elements.push_back(e);
+        } else
+            xml.skipCurrentElement();
     }
-}
-
-void GeogebraTransformer::endOfSequence()
-{
-}
 
-void GeogebraTransformer::namespaceBinding(const QXmlName &)
-{
-}
+    // the commands and elements refer to each other by label, in both
+    // directions, so we can only look them up now that we have read them
+    // all.  The first one with a label wins..
+    QHash<QString, const Element *> elementByLabel;
+    for (std::vector<Element>::const_iterator i = elements.begin(); i != elements.end(); ++i)
+        if (!elementByLabel.contains(i->label))
+            elementByLabel.insert(i->label, &*i);
+    QHash<QString, const Command *> commandByFirstOutput;
+    QHash<QString, const Command *> commandByOutput;
+    for (std::vector<Command>::const_iterator i = commands.begin(); i != commands.end(); ++i) {
+        for (std::vector<QString>::const_iterator j = i->outputs.begin(); j != i->outputs.end(); ++j)
+            if (!commandByOutput.contains(*j))
+                commandByOutput.insert(*j, &*i);
+        if (!i->outputs.empty() && !commandByFirstOutput.contains(i->outputs[0]))
+            commandByFirstOutput.insert(i->outputs[0], &*i);
+    }
 
-void GeogebraTransformer::processingInstruction(const QXmlName &, const QString &)
-{
+    QHash<QString, ObjectCalcer *> objectMap;
+    for (std::vector<int>::const_iterator i = order.begin(); i != order.end(); ++i) {
+        Object o;
+        if (*i < 0) {
+            const Element &e = elements[-*i - 1];
+            if (e.type != QLatin1String("point"))
+                continue;
+            // points that are the result of an intersection or that are
+            // constrained to a curve are not fixed..
+            const Command *c = commandByOutput.value(e.label);
+            if (c && (c->name == QLatin1String("Intersect") || c->name == QLatin1String("Point")))
+                continue;
+            o.type = "FixedPoint";
+            o.label = e.label;
+            o.coords.push_back(e.x.toDouble());
+            o.coords.push_back(e.y.toDouble());
+            o.style = &e;
+            o.point = true;
+        } else {
+            const Command &c = commands[*i];
+            o.type = commandType(c, commandByFirstOutput, elementByLabel);
+            if (o.type.isEmpty())
+                continue;
+            o.label = c.outputs.empty() ? QString() : c.outputs[0];
+            o.parents = c.inputs;
+            o.style = elementByLabel.value(o.label);
+            o.point = false;
+        }
+        buildObject(o, objectMap, section, inputs, outputs);
+    }
 }
 
-void GeogebraTransformer::startDocument()
+/* The name of the Kig ObjectType for the GeoGebra command \p c, or an empty
+ * string if Kig can't construct it.  It *must* be the 'fullTypeName' of some
+ * valid Kig ObjectType.
+ */
+QByteArray GeogebraTransformer::commandType(const Command &c,
+                                            const QHash<QString, const Command *> &commandByOutput,
+                                            const QHash<QString, const Element *> &elements)
 {
+    const QString input1 = c.inputs.size() > 0 ? c.inputs[0] : QString();
+    const QString input2 = c.inputs.size() > 1 ? c.inputs[1] : QString();
+    const Command *command1 = commandByOutput.value(input1);
+    const Command *command2 = commandByOutput.value(input2);
+    const QString commandType1 = command1 ? command1->name : QString();
+    const QString commandType2 = command2 ? command2->name : QString();
+
+    if (c.name == QLatin1String("Segment"))
+        return "SegmentAB";
+    else if (c.name == QLatin1String("Line")) {
+        if (commandType1 == QLatin1String("Line") || commandType2 == QLatin1String("Line"))
+            return "LineParallel";
+        return "LineAB";
+    } else if (c.name == QLatin1String("Ray"))
+        return "RayAB";
+    else if (c.name == QLatin1String("Midpoint"))
+        return "MidPoint";
+    else if (c.name == QLatin1String("OrthogonalLine"))
+        return "LinePerpend";
+    else if (c.name == QLatin1String("PolyLine"))
+        return "OpenPolygon";
+    else if (c.name == QLatin1String("Vector"))
+        return "Vector";
+    else if (c.name == QLatin1String("Polygon"))
+        return "PolygonBNP";
+    else if (c.name == QLatin1String("Circle")) {
+        if (c.inputs.size() == 2) {
+            /* This separates geogebra's circle-center-point type from compass and circle-center-radius types.
+             * If both the inputs are of point type then the circle is of circle-center-point type (CircleBCPType),
+             * otherwise (CircleBPRType).
+             */
+            const Element *element1 = elements.value(input1);
+            const Element *element2 = elements.value(input2);
+            if (element1 && element2 && element1->type == QLatin1String("point") && element2->type == QLatin1String("point"))
+                return "CircleBCP";
+            return "CircleBPR";
+        } else if (c.inputs.size() == 3)
+            return "CircleBTP";
+    } else if (c.name == QLatin1String("CircumcircleArc"))
+        return "ArcBTP";
+    else if (c.name == QLatin1String("Parabola"))
+        return "ParabolaBDP";
+    else if (c.name == QLatin1String("Ellipse"))
+        return "EllipseBFFP";
+    else if (c.name == QLatin1String("Hyperbola"))
+        return "HyperbolaBFFP";
+    else if (c.name == QLatin1String("Conic"))
+        return "ConicB5P";
+    else if (c.name == QLatin1String("Mirror")) {
+        // TODO It cannot open reflection of Polygons.
+        if (commandType2 == QLatin1String("Line"))
+            return "LineReflection";
+        else if (commandType2 == QLatin1String("Circle"))
+            return "CircularInversion";
+        return "PointReflection";
+    } else if (c.name == QLatin1String("Translate"))
+        return "Translation";
+    else if (c.name == QLatin1String("Dilate"))
+        return "ScalingOverCenter";
+    else if (c.name == QLatin1String("Polar"))
+        return "ConicPolarLine";
+    else if (c.name == QLatin1String("Intersect")) {
+        if (commandType1 == QLatin1String("Line") && commandType2 == QLatin1String("Line"))
+            return "LineLineIntersection";
+    }
+    // Kig can't draw diameters of conics ( ?? ), and everything else we
+    // don't know about..
+    return QByteArray();
 }
 
-void GeogebraTransformer::startElement(const QXmlName &name)
+void GeogebraTransformer::buildObject(const Object &o,
+                                      QHash<QString, ObjectCalcer *> &objectMap,
+                                      GeogebraSection &section,
+                                      const QSet<QString> &inputs,
+                                      const QSet<QString> &outputs)
 {
-    if (name.localName(m_np) == QLatin1String("Section")) {
-        m_nsections++;
-        m_sections.push_back(GeogebraSection());
-
-        // Clear stacks
-        m_inputObjectLabels.clear();
-        m_outputObjectLabels.clear();
-        m_currentArgStack.clear();
-        m_objectMap.clear();
+    const ObjectType *type = ObjectTypeFactory::instance()->find(o.type.constData());
+    if (!type) {
+        qWarning() << o.type << " object not found!";
         return;
     }
+    if (objectMap.contains(o.label))
+        return;
 
-    switch (m_currentState) {
-    case GeogebraTransformer::ReadingObject:
-        if (m_currentObject) {
-            // We are already building an object
-            m_currentState = GeogebraTransformer::ReadingArguments;
-            startElement(name);
-            return;
-        }
-
-        {
-            resetDrawerVars();
-            const QByteArray nameData = name.localName(m_np).toLatin1();
-            m_currentObject = ObjectTypeFactory::instance()->find(nameData);
-
-            if (!m_currentObject) {
-                qWarning() << name.localName(m_np) << " object not found!";
-            }
+    std::vector<ObjectCalcer *> args;
+    for (std::vector<double>::const_iterator i = o.coords.begin(); i != o.coords.end(); ++i)
+        args.push_back(new ObjectConstCalcer(new DoubleImp(*i)));
+    for (std::vector<QString>::const_iterator i = o.parents.begin(); i != o.parents.end(); ++i) {
+        bool isDoubleValue;
+        const double dblval = i->toDouble(&isDoubleValue);
+        if (isDoubleValue) {
+            /* This is to handle the circle-point-radius, dilate (and similar) type of Geogebra objects.
+             * <command name="Circle">
+             * <input a0="A" a1="3"/>
+             * <output a0="c"/>
+             *
+             * Notice the attribute 'a1' of the 'input' element. The value - '3' is the radius of the circle.
+             * First, we try to convert that value to Double. If the conversion suceeds, we stack a DoubleImp (Calcer)
+             * as the argument. Otherwise, we check the objectMap for that label entry.
+             */
+            args.push_back(new ObjectConstCalcer(new DoubleImp(dblval)));
+        } else if (objectMap.contains(*i)) {
+            args.push_back(objectMap.value(*i));
+        } else {
+            // TODO Figure out error reporting
         }
+    }
 
-        break;
-    case GeogebraTransformer::ReadingArguments:
-        if (name.localName(m_np) == QLatin1String("Double")) {
-            m_currentState = GeogebraTransformer::ReadingDouble;
+    ObjectTypeCalcer *oc = new ObjectTypeCalcer(type, args);
+    oc->calc(*m_document);
+    objectMap.insert(o.label, oc);
+
+    // Decide where to put this object
+    if (inputs.isEmpty()) {
+        // Not handling input/output objects, put everything in second
+        const Element none;
+        const Element &style = o.style ? *o.style : none;
+        // m_alpha is causing trouble at the moment as Geogebra somehow generates decimal values for it
+        const QColor color(style.r.toInt(), style.g.toInt(), style.b.toInt());
+        const bool show = style.show == QLatin1String("true");
+        ObjectDrawer *od;
+        if (o.point)
+            od = new ObjectDrawer(color, style.pointSize.toInt() + 6, show, Qt::SolidLine, pointStyle(style.pointStyle.toInt()));
+        else
+            od = new ObjectDrawer(color, style.thickness.toInt(), show, penStyle(style.lineType.toInt()), Kig::Round);
+
+        section.addOutputObject(oc);
+        section.addDrawer(od);
+    } else {
+        if (inputs.contains(o.label)) {
+            section.addInputObject(oc);
+        } else if (outputs.contains(o.label)) {
+            section.addOutputObject(oc);
         }
+    }
+}
 
-        break;
+Qt::PenStyle GeogebraTransformer::penStyle(int type)
+{
+    switch (type) {
+    case SOLIDLINE:
+        return Qt::SolidLine;
+    case DASHDOTDOTLINE:
+        return Qt::DashDotDotLine;
+    case DASHLINE:
+        return Qt::DashLine;
+    case DOTLINE:
+        return Qt::DotLine;
+    case DASHDOTLINE:
+        return Qt::DashDotLine;
     default:
-        break;
-    }
+        return Qt::SolidLine;
+    };
 }
 
-void GeogebraTransformer::startOfSequence()
+Kig::PointStyle GeogebraTransformer::pointStyle(int pt)
 {
+    if (pt == SOLIDCIRCLEPOINT)
+        return Kig::pointStyleFromString(QStringLiteral("Round"));
+    else if (pt == SOLIDDIAMONDPOINT || pt == UPARROWPOINT || pt == DOWNARROWPOINT || pt == RIGHTARROWPOINT || pt == LEFTARROWPOINT)
+        return Kig::pointStyleFromString(QStringLiteral("Rectangular"));
+    else if (pt == HOLLOWCIRCLEPOINT)
+        return Kig::pointStyleFromString(
+            QStringLiteral("Round")); // TODO should be mapped to RoundEmpty ( i.e. 1) but for some reason it is not drawing in KIG
+    else if (pt == HOLLOWDIAMONDPOINT)
+        return Kig::pointStyleFromString(
+            QStringLiteral("Rectangular")); // TODO should be mapped to RectangularEmpty ( i.e. 3) but for some reason it is not drawing in KIG
+    else if (pt == CROSSPOINT || pt == PLUSPOINT)
+        return Kig::pointStyleFromString(QStringLiteral("Cross"));
+    return Kig::Round;
 }
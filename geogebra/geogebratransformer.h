@@ -7,10 +7,9 @@
 
 #pragma once
 
-#include <QAbstractXmlReceiver>
-#include <QMap>
+#include <QHash>
 #include <QSet>
-#include <QXmlNamePool>
+#include <QString>
 
 #include <vector>
 
@@ -18,70 +17,94 @@
 #include "geogebrasection.h"
 
 class KigDocument;
-class ObjectHolder;
-class ObjectType;
+class QIODevice;
+class QXmlStreamReader;
 
 /* This class 'transforms' the XML representation of the GeoGebra file into Kig's
  * internal representation of objects ( with proper parent-child relationship ).
+ *
+ * The XML is read in a single pass with a QXmlStreamReader.  Since a GeoGebra
+ * command only refers to its output by label, and the style of that output is
+ * stored in an 'element' that comes after it, every 'construction' is first
+ * read into a list of commands and elements, and then translated into Kig
+ * objects in document order.  There is one GeogebraSection for every
+ * construction in a worksheet, and one for every macro in a tool file.
  */
-class GeogebraTransformer : public QAbstractXmlReceiver
+class GeogebraTransformer
 {
 public:
-    GeogebraTransformer(KigDocument *document, const QXmlNamePool &np)
+    explicit GeogebraTransformer(KigDocument *document)
         : m_document(document)
-        , m_currentState(GeogebraTransformer::ReadingObject)
-        , m_currentObject(nullptr)
-        , m_nsections(0)
-        , m_np(np)
     {
     }
     ~GeogebraTransformer()
     {
     }
 
+    /* Read the GeoGebra XML from \p device.  Returns false if it is not
+     * well-formed, the sections read up to the error are kept.
+     */
+    bool transform(QIODevice *device);
+
     size_t getNumberOfSections() const
     {
-        return m_nsections;
+        return m_sections.size();
     };
     const GeogebraSection &getSection(size_t sectionIdx) const
     {
         return m_sections[sectionIdx];
     };
 
-    // QAbstractXmlReceiver implementation
-    void atomicValue(const QVariant &) override;
-    void attribute(const QXmlName &name, const QStringRef &value) override;
-    void characters(const QStringRef &) override;
-    void comment(const QString &) override;
-    void endDocument() override;
-    void endElement() override;
-    void endOfSequence() override;
-    void namespaceBinding(const QXmlName &) override;
-    void processingInstruction(const QXmlName &, const QString &) override;
-    void startDocument() override;
-    void startElement(const QXmlName &name) override;
-    void startOfSequence() override;
-
 private:
-    void resetDrawerVars()
-    {
-        m_show = true;
-        m_thickness = -1;
-        m_pointType = Kig::Round;
-        m_type = Qt::SolidLine;
-        m_r = 0;
-        m_g = 0;
-        m_b = 0;
-        m_alpha = 0;
+    /* a GeoGebra '<command>', e.g.
+     * <command name="Circle">
+     * <input a0="A" a1="3"/>
+     * <output a0="c"/>
+     * </command>
+     */
+    struct Command {
+        QString name;
+        std::vector<QString> inputs;
+        std::vector<QString> outputs;
     };
 
-private:
-    enum State {
-        ReadingDouble,
-        ReadingObject,
-        ReadingArguments,
+    /* a GeoGebra '<element>', we only keep what is needed for points and for
+     * the drawers.  Attributes that are missing in the file are empty, and
+     * read as 0 or false..
+     */
+    struct Element {
+        QString type;
+        QString label;
+        QString x, y;
+        QString show;
+        QString pointSize;
+        QString pointStyle;
+        QString thickness;
+        QString lineType;
+        QString r, g, b;
     };
 
+    /* one Kig object to build, in the order in which they appear in the file */
+    struct Object {
+        QByteArray type;
+        QString label;
+        std::vector<QString> parents;
+        std::vector<double> coords;
+        const Element *style;
+        bool point;
+    };
+
+    void readMacro(QXmlStreamReader &xml);
+    void readConstruction(QXmlStreamReader &xml, GeogebraSection &section, const QSet<QString> &inputs, const QSet<QString> &outputs);
+    static bool readEuclidianView(QXmlStreamReader &xml, QString &axes, QString &grid);
+
+    static QByteArray commandType(const Command &c, const QHash<QString, const Command *> &commandByOutput, const QHash<QString, const Element *> &elements);
+    void buildObject(const Object &o,
+                     QHash<QString, ObjectCalcer *> &objectMap,
+                     GeogebraSection &section,
+                     const QSet<QString> &inputs,
+                     const QSet<QString> &outputs);
+
     // Enumerations of the Line Styles used by Geogebra
     // The values 0, 10, 15, 20 are the values used by Geogebra to represent the corresponding styles.
     enum {
@@ -106,21 +129,9 @@ private:
         LEFTARROWPOINT
     };
 
+    static Qt::PenStyle penStyle(int type);
+    static Kig::PointStyle pointStyle(int type);
+
     KigDocument *m_document;
-    State m_currentState;
-    QMap<QByteArray, ObjectCalcer *> m_objectMap;
-    std::vector<ObjectCalcer *> m_currentArgStack;
-    const ObjectType *m_currentObject;
-    QSet<QByteArray> m_inputObjectLabels;
-    QSet<QByteArray> m_outputObjectLabels;
-    QByteArray m_currentObjectLabel;
     std::vector<GeogebraSection> m_sections;
-    size_t m_nsections;
-    QXmlNamePool m_np;
-    /* members required for constructing the object-drawers*/
-    bool m_show;
-    int m_thickness;
-    Kig::PointStyle m_pointType;
-    Qt::PenStyle m_type;
-    int m_r, m_g, m_b, m_alpha; // m_alpha is causing trouble at the moment as Geogebra somehow generates decimal values for it
 };
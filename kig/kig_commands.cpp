@@ -8,18 +8,26 @@
 #include "kig_commands.h"
 
 #include "kig_document.h"
+#include "kig_journal.h"
 #include "kig_part.h"
 #include "kig_view.h"
 
 #include "../misc/calcpaths.h"
 #include "../misc/coordinate_system.h"
 #include "../modes/mode.h"
+#include "../objects/bezier_imp.h"
+#include "../objects/bogus_imp.h"
 #include "../objects/object_drawer.h"
 #include "../objects/object_imp.h"
+#include "../objects/point_imp.h"
+#include "../objects/polygon_imp.h"
+#include "../objects/text_imp.h"
 
 #include <iterator>
 #include <vector>
 
+#include <QUndoStack>
+
 using std::max;
 using std::min;
 using std::vector;
@@ -29,10 +37,28 @@ class KigCommand::Private
 public:
     Private(KigPart &d)
         : doc(d)
+        , skip(false)
+        , counted(false)
+        , usage(0)
     {
     }
     KigPart &doc;
     vector<KigCommandTask *> tasks;
+    /**
+     * the tasks are already in the state the next redo() or undo()
+     * would put them in, so it should do nothing.  trimHistory() needs
+     * this to put commands back in the history..
+     */
+    bool skip;
+    /**
+     * whether usage has been added to KigPart::historyMemory(), which
+     * happens when the command is first done, i.e. when it is pushed
+     * on the history.  We keep the amount, so that the same is taken
+     * out again when we are deleted, even if trimHistory() has moved
+     * our tasks elsewhere..
+     */
+    bool counted;
+    size_t usage;
 };
 
 KigCommand::KigCommand(KigPart &doc, const QString &name)
@@ -43,6 +69,8 @@ KigCommand::KigCommand(KigPart &doc, const QString &name)
 
 KigCommand::~KigCommand()
 {
+    if (d->counted)
+        d->doc.historyMemory() -= d->usage;
     for (uint i = 0; i < d->tasks.size(); ++i)
         delete d->tasks[i];
     delete d;
@@ -50,15 +78,46 @@ KigCommand::~KigCommand()
 
 void KigCommand::redo()
 {
-    for (uint i = 0; i < d->tasks.size(); ++i)
+    if (!d->counted) {
+        d->usage = memoryUsage();
+        d->doc.historyMemory() += d->usage;
+        d->counted = true;
+    }
+    if (d->skip) {
+        d->skip = false;
+        return;
+    }
+    KigJournal &j = *d->doc.journal();
+    j.beginCommand();
+    // all the objects added and removed by the tasks go into the
+    // document at once..
+    d->doc.document().beginTransaction();
+    for (uint i = 0; i < d->tasks.size(); ++i) {
         d->tasks[i]->execute(d->doc);
+        d->tasks[i]->journal(j);
+    }
+    d->doc.document().commitTransaction();
+    j.endCommand();
     d->doc.redrawScreen();
 }
 
 void KigCommand::undo()
 {
-    for (uint i = 0; i < d->tasks.size(); ++i)
+    if (d->skip) {
+        d->skip = false;
+        return;
+    }
+    KigJournal &j = *d->doc.journal();
+    j.beginCommand();
+    // all the objects added and removed by the tasks go into the
+    // document at once..
+    d->doc.document().beginTransaction();
+    for (uint i = 0; i < d->tasks.size(); ++i) {
         d->tasks[i]->unexecute(d->doc);
+        d->tasks[i]->journal(j);
+    }
+    d->doc.document().commitTransaction();
+    j.endCommand();
     d->doc.redrawScreen();
 }
 
@@ -67,6 +126,71 @@ void KigCommand::addTask(KigCommandTask *t)
     d->tasks.push_back(t);
 }
 
+size_t KigCommand::memoryUsage() const
+{
+    size_t ret = sizeof(KigCommand) + sizeof(Private) + text().size() * sizeof(QChar);
+    for (uint i = 0; i < d->tasks.size(); ++i)
+        ret += d->tasks[i]->memoryUsage();
+    return ret;
+}
+
+size_t KigCommand::memoryUsage(const QUndoStack &history)
+{
+    size_t ret = 0;
+    for (int i = 0; i < history.count(); ++i) {
+        const KigCommand *c = static_cast<const KigCommand *>(history.command(i));
+        ret += c->d->counted ? c->d->usage : c->memoryUsage();
+    }
+    return ret;
+}
+
+int KigCommand::trimHistory(QUndoStack &history, size_t usage, size_t limit)
+{
+    if (limit == 0 || usage <= limit)
+        return 0;
+    const int count = history.count();
+    const int index = history.index();
+    const int cleanindex = history.cleanIndex();
+
+    // go a bit below the limit, so that we don't have to do this again
+    // on the next command..
+    const size_t target = limit / 4 * 3;
+    int evict = 0;
+    while (evict < index - 1 && usage > target)
+        usage -= static_cast<const KigCommand *>(history.command(evict++))->d->usage;
+    if (evict == 0)
+        return 0;
+
+    // QUndoStack can't remove its oldest commands, so we move the tasks
+    // of the ones we keep into new commands, and build the history
+    // again from those..
+    std::vector<KigCommand *> kept;
+    for (int i = evict; i < count; ++i) {
+        KigCommand *old = const_cast<KigCommand *>(static_cast<const KigCommand *>(history.command(i)));
+        KigCommand *c = new KigCommand(old->d->doc, old->text());
+        c->d->tasks.swap(old->d->tasks);
+        c->d->skip = true;
+        kept.push_back(c);
+    }
+    // this deletes the evicted commands along with their tasks, and
+    // leaves the history clean at its start..
+    history.clear();
+    // the document was saved after the command that is now at
+    // cleanindex - evict, if it was saved after one that is left..
+    const int newclean = cleanindex - evict;
+    for (uint i = 0; i < kept.size(); ++i) {
+        history.push(kept[i]);
+        if (static_cast<int>(i) + 1 == newclean)
+            history.setClean();
+    }
+    if (newclean < 0)
+        history.resetClean();
+    for (uint i = index - evict; i < kept.size(); ++i)
+        kept[i]->d->skip = true;
+    history.setIndex(index - evict);
+    return evict;
+}
+
 KigCommand *KigCommand::removeCommand(KigPart &doc, ObjectHolder *o)
 {
     std::vector<ObjectHolder *> os;
@@ -122,6 +246,35 @@ KigCommandTask::~KigCommandTask()
 {
 }
 
+void KigCommandTask::journal(KigJournal &) const
+{
+}
+
+size_t KigCommandTask::memoryUsage() const
+{
+    return 0;
+}
+
+/**
+ * an estimate of the memory used by \p imp, this only needs to be
+ * right for the imps that can get big..
+ */
+static size_t impMemoryUsage(const ObjectImp *imp)
+{
+    size_t ret = 64;
+    if (imp->inherits(AbstractPolygonImp::stype()))
+        ret += static_cast<const AbstractPolygonImp *>(imp)->npoints() * sizeof(Coordinate);
+    else if (imp->inherits(BezierImp::stype()))
+        ret += static_cast<const BezierImp *>(imp)->npoints() * sizeof(Coordinate);
+    else if (imp->inherits(RationalBezierImp::stype()))
+        ret += static_cast<const RationalBezierImp *>(imp)->npoints() * (sizeof(Coordinate) + sizeof(double));
+    else if (imp->inherits(TextImp::stype()))
+        ret += static_cast<const TextImp *>(imp)->text().size() * sizeof(QChar);
+    else if (imp->inherits(StringImp::stype()))
+        ret += static_cast<const StringImp *>(imp)->data().size() * sizeof(QChar);
+    return ret;
+}
+
 AddObjectsTask::AddObjectsTask(const std::vector<ObjectHolder *> &os)
     : KigCommandTask()
     , undone(true)
@@ -141,6 +294,24 @@ void AddObjectsTask::unexecute(KigPart &doc)
     undone = true;
 }
 
+void AddObjectsTask::journal(KigJournal &j) const
+{
+    if (undone)
+        j.recordRemoveObjects(mobjs);
+    else
+        j.recordAddObjects(mobjs);
+}
+
+size_t AddObjectsTask::memoryUsage() const
+{
+    size_t ret = sizeof(AddObjectsTask) + mobjs.capacity() * sizeof(ObjectHolder *);
+    // the objects are only ours while they are not in the document..
+    if (undone)
+        for (std::vector<ObjectHolder *>::const_iterator i = mobjs.begin(); i != mobjs.end(); ++i)
+            ret += sizeof(ObjectHolder) + sizeof(ObjectDrawer) + impMemoryUsage((*i)->imp());
+    return ret;
+}
+
 AddObjectsTask::~AddObjectsTask()
 {
     if (undone)
@@ -168,12 +339,43 @@ ChangeObjectConstCalcerTask::ChangeObjectConstCalcerTask(ObjectConstCalcer *calc
     : KigCommandTask()
     , mcalcer(calcer)
     , mnewimp(newimp)
+    , mpoint(false)
+{
+}
+
+ChangeObjectConstCalcerTask::ChangeObjectConstCalcerTask(ObjectConstCalcer *calcer, const Coordinate &newcoord)
+    : KigCommandTask()
+    , mcalcer(calcer)
+    , mnewimp(nullptr)
+    , mnewcoord(newcoord)
+    , mpoint(true)
+{
+    assert(calcer->imp()->type() == PointImp::stype());
+}
+
+ChangeObjectConstCalcerTask::ChangeObjectConstCalcerTask(ObjectConstCalcer *calcer, double newvalue)
+    : KigCommandTask()
+    , mcalcer(calcer)
+    , mnewimp(nullptr)
+    , mnewcoord(newvalue, 0)
+    , mpoint(false)
 {
+    assert(calcer->imp()->type() == DoubleImp::stype());
 }
 
 void ChangeObjectConstCalcerTask::execute(KigPart &doc)
 {
-    mnewimp = mcalcer->switchImp(mnewimp);
+    if (mnewimp)
+        mnewimp = mcalcer->switchImp(mnewimp);
+    else if (mpoint) {
+        const Coordinate old = static_cast<const PointImp *>(mcalcer->imp())->coordinate();
+        delete mcalcer->switchImp(new PointImp(mnewcoord));
+        mnewcoord = old;
+    } else {
+        const double old = static_cast<const DoubleImp *>(mcalcer->imp())->data();
+        delete mcalcer->switchImp(new DoubleImp(mnewcoord.x));
+        mnewcoord = Coordinate(old, 0);
+    }
 
     std::set<ObjectCalcer *> allchildren = getAllChildren(mcalcer.get());
     std::vector<ObjectCalcer *> allchildrenvect(allchildren.begin(), allchildren.end());
@@ -187,13 +389,38 @@ void ChangeObjectConstCalcerTask::unexecute(KigPart &doc)
     execute(doc);
 }
 
+void ChangeObjectConstCalcerTask::journal(KigJournal &j) const
+{
+    j.recordImp(mcalcer.get());
+}
+
+size_t ChangeObjectConstCalcerTask::memoryUsage() const
+{
+    return sizeof(ChangeObjectConstCalcerTask) + (mnewimp ? impMemoryUsage(mnewimp) : 0);
+}
+
+/**
+ * the state of a monitored calcer before the change.  For points and
+ * doubles, we only keep the coordinate or the value in oldcoord, and
+ * oldimp is 0..
+ */
 struct MoveDataStruct {
     ObjectConstCalcer *o;
     ObjectImp *oldimp;
-    MoveDataStruct(ObjectConstCalcer *io, ObjectImp *oi)
+    const ObjectImpType *oldtype;
+    Coordinate oldcoord;
+    explicit MoveDataStruct(ObjectConstCalcer *io)
         : o(io)
-        , oldimp(oi)
+        , oldimp(nullptr)
+        , oldtype(io->imp()->type())
     {
+        const ObjectImp *imp = io->imp();
+        if (imp->type() == PointImp::stype())
+            oldcoord = static_cast<const PointImp *>(imp)->coordinate();
+        else if (imp->type() == DoubleImp::stype())
+            oldcoord = Coordinate(static_cast<const DoubleImp *>(imp)->data(), 0);
+        else
+            oldimp = imp->copy();
     }
 };
 
@@ -213,8 +440,7 @@ void MonitorDataObjects::monitor(const std::vector<ObjectCalcer *> &objs)
 {
     for (std::vector<ObjectCalcer *>::const_iterator i = objs.begin(); i != objs.end(); ++i)
         if (dynamic_cast<ObjectConstCalcer *>(*i)) {
-            MoveDataStruct n(static_cast<ObjectConstCalcer *>(*i), (*i)->imp()->copy());
-            d->movedata.push_back(n);
+            d->movedata.push_back(MoveDataStruct(static_cast<ObjectConstCalcer *>(*i)));
         };
 }
 
@@ -222,11 +448,30 @@ void MonitorDataObjects::finish(KigCommand *comm)
 {
     for (uint i = 0; i < d->movedata.size(); ++i) {
         ObjectConstCalcer *o = d->movedata[i].o;
-        if (!d->movedata[i].oldimp->equals(*o->imp())) {
-            ObjectImp *newimp = o->switchImp(d->movedata[i].oldimp);
-            comm->addTask(new ChangeObjectConstCalcerTask(o, newimp));
-        } else
-            delete d->movedata[i].oldimp;
+        const Coordinate &oldcoord = d->movedata[i].oldcoord;
+        if (d->movedata[i].oldimp) {
+            if (!d->movedata[i].oldimp->equals(*o->imp())) {
+                ObjectImp *newimp = o->switchImp(d->movedata[i].oldimp);
+                comm->addTask(new ChangeObjectConstCalcerTask(o, newimp));
+            } else
+                delete d->movedata[i].oldimp;
+        } else if (o->imp()->type() != d->movedata[i].oldtype) {
+            // it is something else than a point or a double now..
+            ObjectImp *oldimp = d->movedata[i].oldtype == PointImp::stype() ? static_cast<ObjectImp *>(new PointImp(oldcoord)) : new DoubleImp(oldcoord.x);
+            comm->addTask(new ChangeObjectConstCalcerTask(o, o->switchImp(oldimp)));
+        } else if (d->movedata[i].oldtype == PointImp::stype()) {
+            const Coordinate newcoord = static_cast<const PointImp *>(o->imp())->coordinate();
+            if (newcoord != oldcoord) {
+                delete o->switchImp(new PointImp(oldcoord));
+                comm->addTask(new ChangeObjectConstCalcerTask(o, newcoord));
+            }
+        } else {
+            const double newvalue = static_cast<const DoubleImp *>(o->imp())->data();
+            if (newvalue != oldcoord.x) {
+                delete o->switchImp(new DoubleImp(oldcoord.x));
+                comm->addTask(new ChangeObjectConstCalcerTask(o, newvalue));
+            }
+        }
     };
     d->movedata.clear();
 }
@@ -257,6 +502,16 @@ void ChangeCoordSystemTask::unexecute(KigPart &doc)
     execute(doc);
 }
 
+void ChangeCoordSystemTask::journal(KigJournal &j) const
+{
+    j.recordCoordinateSystem();
+}
+
+size_t ChangeCoordSystemTask::memoryUsage() const
+{
+    return sizeof(ChangeCoordSystemTask) + 64;
+}
+
 ChangeCoordSystemTask::~ChangeCoordSystemTask()
 {
     delete mcs;
@@ -313,6 +568,16 @@ void ChangeParentsAndTypeTask::unexecute(KigPart &doc)
     execute(doc);
 }
 
+void ChangeParentsAndTypeTask::journal(KigJournal &j) const
+{
+    j.recordParentsAndType(d->o);
+}
+
+size_t ChangeParentsAndTypeTask::memoryUsage() const
+{
+    return sizeof(ChangeParentsAndTypeTask) + sizeof(Private) + d->newparents.capacity() * sizeof(ObjectCalcer::shared_ptr);
+}
+
 class KigViewShownRectChangeTask::Private
 {
 public:
@@ -372,12 +637,52 @@ void ChangeObjectDrawerTask::unexecute(KigPart &doc)
     execute(doc);
 }
 
+void ChangeObjectDrawerTask::journal(KigJournal &j) const
+{
+    j.recordDrawer(mholder);
+}
+
+size_t ChangeObjectDrawerTask::memoryUsage() const
+{
+    return sizeof(ChangeObjectDrawerTask) + sizeof(ObjectDrawer);
+}
+
+ChangeObjectNameTask::ChangeObjectNameTask(ObjectHolder *holder, ObjectConstCalcer *newname)
+    : KigCommandTask()
+    , mholder(holder)
+    , mnewname(newname)
+{
+}
+
+ChangeObjectNameTask::~ChangeObjectNameTask()
+{
+}
+
+void ChangeObjectNameTask::execute(KigPart &)
+{
+    mnewname = mholder->switchNameCalcer(mnewname.get());
+}
+
+void ChangeObjectNameTask::unexecute(KigPart &doc)
+{
+    execute(doc);
+}
+
+void ChangeObjectNameTask::journal(KigJournal &j) const
+{
+    j.recordName(mholder);
+}
+
+size_t ChangeObjectNameTask::memoryUsage() const
+{
+    return sizeof(ChangeObjectNameTask) + (mnewname ? impMemoryUsage(mnewname->imp()) : 0);
+}
+
 MonitorDataObjects::MonitorDataObjects(ObjectCalcer *c)
     : d(new Private)
 {
     if (dynamic_cast<ObjectConstCalcer *>(c)) {
-        MoveDataStruct n(static_cast<ObjectConstCalcer *>(c), c->imp()->copy());
-        d->movedata.push_back(n);
+        d->movedata.push_back(MoveDataStruct(static_cast<ObjectConstCalcer *>(c)));
     };
 }
 
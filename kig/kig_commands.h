@@ -9,6 +9,7 @@
 
 #include <QUndoCommand>
 
+#include "../misc/coordinate.h"
 #include "../objects/object_holder.h"
 
 class KigDocument;
@@ -16,7 +17,9 @@ class KigPart;
 class CoordinateSystem;
 
 class KigCommandTask;
+class KigJournal;
 class KigWidget;
+class QUndoStack;
 class Rect;
 
 /**
@@ -64,6 +67,29 @@ public:
     void redo() override;
     void undo() override;
 
+    /**
+     * an estimate of the memory this command keeps alive while it is in
+     * the history, in bytes..
+     */
+    size_t memoryUsage() const;
+    /**
+     * an estimate of the memory used by all of \p history, in bytes.
+     * This adds up the commands, KigPart::historyMemory() is the same
+     * without walking the history..
+     */
+    static size_t memoryUsage(const QUndoStack &history);
+
+    /**
+     * Move the oldest commands of \p history out of it, until it uses
+     * less than \p limit bytes, if the \p usage of it is over that.
+     * Only commands that are done can go, the document then simply
+     * starts after them.  The current command is always kept, and the
+     * point where the document was saved stays where it was, if it is
+     * not removed with the old commands.  Returns the number of
+     * commands removed..
+     */
+    static int trimHistory(QUndoStack &history, size_t usage, size_t limit);
+
 private:
     Q_DISABLE_COPY(KigCommand)
 };
@@ -79,6 +105,16 @@ public:
 
     virtual void execute(KigPart &doc) = 0;
     virtual void unexecute(KigPart &doc) = 0;
+    /**
+     * tell \p j what the last execute() or unexecute() changed in the
+     * document.  Tasks that only change the view don't need to..
+     */
+    virtual void journal(KigJournal &j) const;
+    /**
+     * an estimate of the memory this task keeps alive while it is in
+     * the history, in bytes..
+     */
+    virtual size_t memoryUsage() const;
 };
 
 class AddObjectsTask : public KigCommandTask
@@ -88,6 +124,8 @@ public:
     ~AddObjectsTask();
     void execute(KigPart &doc) override;
     void unexecute(KigPart &doc) override;
+    void journal(KigJournal &j) const override;
+    size_t memoryUsage() const override;
 
 protected:
     bool undone;
@@ -107,14 +145,33 @@ class ChangeObjectConstCalcerTask : public KigCommandTask
 {
 public:
     ChangeObjectConstCalcerTask(ObjectConstCalcer *calcer, ObjectImp *newimp);
+    /**
+     * the imp of \p calcer is a PointImp, and should be changed to
+     * one at \p newcoord.  Only the coordinate is kept in the history,
+     * instead of a whole imp..
+     */
+    ChangeObjectConstCalcerTask(ObjectConstCalcer *calcer, const Coordinate &newcoord);
+    /**
+     * the imp of \p calcer is a DoubleImp, and should be changed to
+     * one with value \p newvalue..
+     */
+    ChangeObjectConstCalcerTask(ObjectConstCalcer *calcer, double newvalue);
     ~ChangeObjectConstCalcerTask();
 
     void execute(KigPart &) override;
     void unexecute(KigPart &) override;
+    void journal(KigJournal &j) const override;
+    size_t memoryUsage() const override;
 
 protected:
     ObjectConstCalcer::shared_ptr mcalcer;
+    /**
+     * the imp to switch to, or 0 if it is a point or a double, and we
+     * only keep mnewcoord..
+     */
     ObjectImp *mnewimp;
+    Coordinate mnewcoord;
+    bool mpoint;
 };
 
 /**
@@ -174,6 +231,8 @@ public:
 
     void execute(KigPart &doc) override;
     void unexecute(KigPart &doc) override;
+    void journal(KigJournal &j) const override;
+    size_t memoryUsage() const override;
 };
 
 class ChangeParentsAndTypeTask : public KigCommandTask
@@ -187,6 +246,8 @@ public:
 
     void execute(KigPart &doc) override;
     void unexecute(KigPart &doc) override;
+    void journal(KigJournal &j) const override;
+    size_t memoryUsage() const override;
 };
 
 class KigViewShownRectChangeTask : public KigCommandTask
@@ -213,4 +274,25 @@ public:
 
     void execute(KigPart &doc) override;
     void unexecute(KigPart &doc) override;
+    void journal(KigJournal &j) const override;
+    size_t memoryUsage() const override;
+};
+
+/**
+ * gives \p holder the name calcer \p newname, which may be zero to
+ * remove its name..
+ */
+class ChangeObjectNameTask : public KigCommandTask
+{
+    ObjectHolder *mholder;
+    ObjectConstCalcer::shared_ptr mnewname;
+
+public:
+    ChangeObjectNameTask(ObjectHolder *holder, ObjectConstCalcer *newname);
+    ~ChangeObjectNameTask();
+
+    void execute(KigPart &doc) override;
+    void unexecute(KigPart &doc) override;
+    void journal(KigJournal &j) const override;
+    size_t memoryUsage() const override;
 };
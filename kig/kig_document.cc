@@ -7,15 +7,18 @@
 #include "../misc/calcpaths.h"
 #include "../misc/common.h"
 #include "../misc/coordinate_system.h"
+#include "../misc/kigtracer.h"
 #include "../misc/rect.h"
 #include "../objects/object_calcer.h"
 #include "../objects/object_holder.h"
 #include "../objects/point_imp.h"
 #include "../objects/polygon_imp.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <iterator>
+#include <map>
 
 KigDocument::KigDocument(const std::set<ObjectHolder *> &objects, CoordinateSystem *coordsystem, bool showgrid, bool showaxes, bool nv)
     : mobjects(objects)
@@ -24,6 +27,8 @@ KigDocument::KigDocument(const std::set<ObjectHolder *> &objects, CoordinateSyst
     , mshowaxes(showaxes)
     , mnightvision(nv)
     , mcoordinatePrecision(-1)
+    , mcachedCoordinatePrecision(-1)
+    , mtransactiondepth(0)
     , mcachedparam(0.0)
 {
 }
@@ -124,27 +129,74 @@ Rect KigDocument::suggestedRect() const
     return r;
 }
 
+void KigDocument::beginTransaction()
+{
+    ++mtransactiondepth;
+}
+
+void KigDocument::commitTransaction()
+{
+    assert(mtransactiondepth > 0);
+    if (--mtransactiondepth > 0)
+        return;
+
+    std::vector<ObjectHolder *> added;
+    for (std::vector<ObjectHolder *>::const_iterator i = maddedobjects.begin(); i != maddedobjects.end(); ++i)
+        if (maddedset.erase(*i))
+            added.push_back(*i);
+    maddedobjects.clear();
+    assert(maddedset.empty());
+
+    for (std::set<ObjectHolder *>::const_iterator i = mremovedobjects.begin(); i != mremovedobjects.end(); ++i)
+        mobjects.erase(*i);
+    mremovedobjects.clear();
+    mobjects.insert(added.begin(), added.end());
+
+    KigTracer::Span span("recompute", "calc");
+    std::vector<ObjectCalcer *> calcers = calcPath(getAllCalcers(added));
+    for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i)
+        (*i)->calc(*this);
+
+    invalidateCoordinatePrecision();
+}
+
 void KigDocument::addObject(ObjectHolder *o)
 {
+    if (mtransactiondepth > 0) {
+        mremovedobjects.erase(o);
+        if (maddedset.insert(o).second)
+            maddedobjects.push_back(o);
+        return;
+    }
     mobjects.insert(o);
+    invalidateCoordinatePrecision();
 }
 
 void KigDocument::addObjects(const std::vector<ObjectHolder *> &os)
 {
+    beginTransaction();
     for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
-        (*i)->calc(*this);
-    std::copy(os.begin(), os.end(), std::inserter(mobjects, mobjects.begin()));
+        addObject(*i);
+    commitTransaction();
 }
 
 void KigDocument::delObject(ObjectHolder *o)
 {
+    if (mtransactiondepth > 0) {
+        if (!maddedset.erase(o))
+            mremovedobjects.insert(o);
+        return;
+    }
     mobjects.erase(o);
+    invalidateCoordinatePrecision();
 }
 
 void KigDocument::delObjects(const std::vector<ObjectHolder *> &os)
 {
+    beginTransaction();
     for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
-        mobjects.erase(*i);
+        delObject(*i);
+    commitTransaction();
 }
 
 KigDocument::KigDocument()
@@ -154,14 +206,27 @@ KigDocument::KigDocument()
     mshowaxes = true;
     mnightvision = false;
     mcoordinatePrecision = -1;
+    mcachedCoordinatePrecision = -1;
+    mtransactiondepth = 0;
 }
 
 KigDocument::~KigDocument()
 {
-    typedef std::set<ObjectHolder *> s;
-    for (s::iterator i = mobjects.begin(); i != mobjects.end(); ++i) {
-        delete *i;
-    }
+    // the objects are deleted children first.  A calcer is deleted
+    // along with the last reference to it, so deleting the last object
+    // of a long chain first would delete the whole chain recursively,
+    // one calcer inside the destructor of the other..
+    const std::vector<ObjectHolder *> os(mobjects.begin(), mobjects.end());
+    const std::vector<ObjectCalcer *> path = calcPath(getAllCalcers(os));
+    std::map<const ObjectCalcer *, std::vector<ObjectCalcer *>::size_type> order;
+    for (std::vector<ObjectCalcer *>::size_type i = 0; i < path.size(); ++i)
+        order[path[i]] = i;
+    std::vector<std::pair<std::vector<ObjectCalcer *>::size_type, ObjectHolder *>> sorted;
+    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
+        sorted.push_back(std::make_pair(order[(*i)->calcer()], *i));
+    std::sort(sorted.begin(), sorted.end());
+    for (std::vector<std::pair<std::vector<ObjectCalcer *>::size_type, ObjectHolder *>>::reverse_iterator i = sorted.rbegin(); i != sorted.rend(); ++i)
+        delete i->second;
     delete mcoordsystem;
 }
 
@@ -190,6 +255,11 @@ void KigDocument::setCoordinatePrecision(int precision)
     mcoordinatePrecision = precision;
 }
 
+void KigDocument::invalidateCoordinatePrecision()
+{
+    mcachedCoordinatePrecision = -1;
+}
+
 bool KigDocument::axes() const
 {
     return mshowaxes;
@@ -209,10 +279,13 @@ int KigDocument::getCoordinatePrecision() const
 {
     if (mcoordinatePrecision == -1) {
         // we use default coordinate precision calculation
-        Rect sr = suggestedRect();
-        double m = kigMax(sr.width(), sr.height());
+        if (mcachedCoordinatePrecision == -1) {
+            Rect sr = suggestedRect();
+            double m = kigMax(sr.width(), sr.height());
 
-        return kigMax(0, (int)(3 - log10(m)));
+            mcachedCoordinatePrecision = kigMax(0, (int)(3 - log10(m)));
+        }
+        return mcachedCoordinatePrecision;
     }
 
     return mcoordinatePrecision;
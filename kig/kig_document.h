@@ -54,6 +54,27 @@ class KigDocument
      */
     int mcoordinatePrecision;
 
+    /**
+     * The automatic coordinate precision is derived from
+     * suggestedRect(), which needs to look at all the objects, so we
+     * keep it here until invalidateCoordinatePrecision() is called.
+     * -1 means that it needs to be computed again.
+     */
+    mutable int mcachedCoordinatePrecision;
+
+    /**
+     * The objects added and removed since beginTransaction(), and how
+     * many transactions are open.  maddedobjects keeps the order in
+     * which the objects were added, maddedset the ones that are still
+     * added, so that removing one again doesn't have to search the
+     * vector.  An object removed and added again may be in the vector
+     * more than once..
+     */
+    int mtransactiondepth;
+    std::vector<ObjectHolder *> maddedobjects;
+    std::set<ObjectHolder *> maddedset;
+    std::set<ObjectHolder *> mremovedobjects;
+
 public:
     mutable double mcachedparam;
 
@@ -100,6 +121,11 @@ public:
     void setNightVision(bool nv);
 
     void setCoordinatePrecision(int precision);
+    /**
+     * Forget the automatic coordinate precision, because the objects
+     * may have moved...
+     */
+    void invalidateCoordinatePrecision();
 
     /**
      * Return a vector of objects that contain the given point.
@@ -117,6 +143,20 @@ public:
      */
     Rect suggestedRect() const;
 
+    /**
+     * Start adding and removing many objects at once.  Until the
+     * matching commitTransaction(), addObject() and friends only
+     * collect the objects, and objects() doesn't see them yet.
+     * Transactions can be nested..
+     */
+    void beginTransaction();
+    /**
+     * Update the set of objects once with everything collected since
+     * beginTransaction(), and calc the added objects in a single pass,
+     * parents first..
+     */
+    void commitTransaction();
+
     /**
      * Add the objects \p o to the document.
      */
@@ -0,0 +1,576 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "kig_journal.h"
+
+#include "kig_document.h"
+#include "kig_part.h"
+
+#include "../misc/calcpaths.h"
+#include "../misc/coordinate_system.h"
+#include "../objects/object_drawer.h"
+#include "../objects/object_holder.h"
+#include "../objects/object_imp.h"
+#include "../objects/object_imp_factory.h"
+#include "../objects/object_type.h"
+#include "../objects/object_type_factory.h"
+
+#include <QColor>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QFont>
+#include <QStandardPaths>
+
+// "KIGJ"
+static const quint32 journalmagic = 0x4a47494b;
+// bump this when the layout of the records changes..
+static const quint32 journalversion = 2;
+
+/**
+ * the kinds of records.  Every record describes the state of something
+ * after a change, not the change itself, so replaying one twice does
+ * no harm..
+ */
+enum {
+    CoordinateSystemRecord = 0,
+    GridAxesRecord,
+    DataRecord,
+    PropertyRecord,
+    TypeRecord,
+    ImpRecord,
+    ParentsAndTypeRecord,
+    AddHolderRecord,
+    RemoveHolderRecord,
+    DrawerRecord,
+    NameRecord
+};
+
+static QByteArray serializeImp(const ObjectImp &imp, QString &type)
+{
+    QDomDocument doc;
+    QDomElement e = doc.createElement(QStringLiteral("Data"));
+    type = ObjectImpFactory::instance()->serialize(imp, e, doc);
+    doc.appendChild(e);
+    return doc.toByteArray(-1);
+}
+
+static ObjectImp *deserializeImp(const QString &type, const QByteArray &xml)
+{
+    QDomDocument doc;
+    if (!doc.setContent(xml))
+        return nullptr;
+    QString error;
+    return ObjectImpFactory::instance()->deserialize(type, doc.documentElement(), error);
+}
+
+static void writeIds(QDataStream &s, const std::vector<quint32> &ids)
+{
+    s << static_cast<quint32>(ids.size());
+    for (std::vector<quint32>::const_iterator i = ids.begin(); i != ids.end(); ++i)
+        s << *i;
+}
+
+KigJournal::KigJournal(KigPart &part)
+    : mpart(part)
+    , mstarted(false)
+    , mdepth(0)
+{
+    mbuffer.open(QIODevice::WriteOnly);
+    mstream.setDevice(&mbuffer);
+    mstream.setVersion(QDataStream::Qt_6_0);
+}
+
+KigJournal::~KigJournal()
+{
+}
+
+QString KigJournal::journalFile(const QString &file)
+{
+    const QByteArray path = QFileInfo(file).absoluteFilePath().toUtf8();
+    const QByteArray hash = QCryptographicHash::hash(path, QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/journal/") + QString::fromLatin1(hash)
+        + QStringLiteral(".kigj");
+}
+
+bool KigJournal::exists(const QString &file)
+{
+    return !file.isEmpty() && QFile::exists(journalFile(file));
+}
+
+void KigJournal::reset(const QString &file)
+{
+    discard();
+    mfile = file;
+    mjournal = file.isEmpty() ? QString() : journalFile(file);
+}
+
+void KigJournal::discard()
+{
+    if (!mjournal.isEmpty())
+        QFile::remove(mjournal);
+    mstarted = false;
+    mids.clear();
+    mcalcers.clear();
+    mbuffer.buffer().clear();
+    mbuffer.seek(0);
+}
+
+void KigJournal::checkpoint()
+{
+    if (!mjournal.isEmpty() && !mstarted)
+        writeSnapshot();
+}
+
+void KigJournal::beginCommand()
+{
+    if (mjournal.isEmpty())
+        return;
+    if (mdepth++ == 0 && !mstarted)
+        writeSnapshot();
+}
+
+void KigJournal::endCommand()
+{
+    if (mjournal.isEmpty() || mdepth == 0)
+        return;
+    if (--mdepth == 0)
+        appendRecord();
+}
+
+quint32 KigJournal::calcerId(ObjectCalcer *o)
+{
+    std::map<const ObjectCalcer *, quint32>::const_iterator i = mids.find(o);
+    if (i != mids.end())
+        return i->second;
+
+    const std::vector<ObjectCalcer *> parents = o->parents();
+    std::vector<quint32> parentids;
+    for (std::vector<ObjectCalcer *>::const_iterator j = parents.begin(); j != parents.end(); ++j)
+        parentids.push_back(calcerId(*j));
+
+    const quint32 id = mcalcers.size() + 1;
+    if (dynamic_cast<const ObjectConstCalcer *>(o)) {
+        QString type;
+        const QByteArray xml = serializeImp(*o->imp(), type);
+        mstream << static_cast<quint8>(DataRecord) << id << type << xml;
+    } else if (dynamic_cast<const ObjectPropertyCalcer *>(o)) {
+        const ObjectPropertyCalcer *p = static_cast<const ObjectPropertyCalcer *>(o);
+        mstream << static_cast<quint8>(PropertyRecord) << id << parentids[0] << QByteArray(p->parent()->imp()->getPropName(p->propGid()));
+    } else if (dynamic_cast<const ObjectTypeCalcer *>(o)) {
+        const ObjectTypeCalcer *t = static_cast<const ObjectTypeCalcer *>(o);
+        mstream << static_cast<quint8>(TypeRecord) << id << QByteArray(t->type()->fullName());
+        writeIds(mstream, parentids);
+    } else
+        assert(false);
+    mids[o] = id;
+    mcalcers.push_back(o);
+    return id;
+}
+
+void KigJournal::writeDrawer(const ObjectHolder *o)
+{
+    const ObjectDrawer *d = o->drawer();
+    mstream << d->color() << static_cast<qint32>(d->width()) << d->shown() << static_cast<qint32>(d->style()) << static_cast<qint32>(d->pointStyle())
+            << d->font();
+}
+
+void KigJournal::writeSnapshot()
+{
+    QDir().mkpath(QFileInfo(mjournal).absolutePath());
+    QFile file(mjournal);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+    QDataStream s(&file);
+    s.setVersion(QDataStream::Qt_6_0);
+    s << journalmagic << journalversion << QFileInfo(mfile).absoluteFilePath();
+    file.close();
+    mstarted = true;
+
+    // the snapshot goes before whatever the current command already
+    // recorded..
+    const QByteArray pending = mbuffer.buffer();
+    mbuffer.buffer().clear();
+    mbuffer.seek(0);
+
+    const KigDocument &doc = mpart.document();
+    mstream << static_cast<quint8>(CoordinateSystemRecord) << QByteArray(doc.coordinateSystem().type());
+    mstream << static_cast<quint8>(GridAxesRecord) << doc.grid() << doc.axes();
+    // defining the calcers in calc order keeps calcerId() from
+    // recursing deeply..
+    std::vector<ObjectHolder *> holders = doc.objects();
+    std::vector<ObjectCalcer *> calcers = calcPath(getAllParents(getAllCalcers(holders)));
+    for (std::vector<ObjectCalcer *>::const_iterator i = calcers.begin(); i != calcers.end(); ++i)
+        calcerId(*i);
+    recordAddObjects(holders);
+    appendRecord();
+
+    mstream.writeRawData(pending.constData(), pending.size());
+}
+
+bool KigJournal::appendRecord()
+{
+    QByteArray &record = mbuffer.buffer();
+    if (record.isEmpty())
+        return true;
+    QFile file(mjournal);
+    bool ok = file.open(QIODevice::WriteOnly | QIODevice::Append);
+    if (ok) {
+        // a command whose record is cut off, or doesn't match its
+        // checksum, was being written when Kig crashed, so recover()
+        // stops before it..
+        QDataStream s(&file);
+        s.setVersion(QDataStream::Qt_6_0);
+        s << static_cast<quint32>(record.size());
+        s.writeRawData(record.constData(), record.size());
+        s << qChecksum(QByteArrayView(record));
+        ok = s.status() == QDataStream::Ok && file.flush();
+    }
+    record.clear();
+    mbuffer.seek(0);
+    return ok;
+}
+
+void KigJournal::recordAddObjects(const std::vector<ObjectHolder *> &os)
+{
+    if (!mstarted)
+        return;
+    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i) {
+        const quint32 id = calcerId((*i)->calcer());
+        const quint32 nameid = (*i)->nameCalcer() ? calcerId((*i)->nameCalcer()) : 0;
+        mstream << static_cast<quint8>(AddHolderRecord) << id << nameid;
+        writeDrawer(*i);
+    }
+}
+
+void KigJournal::recordRemoveObjects(const std::vector<ObjectHolder *> &os)
+{
+    if (!mstarted)
+        return;
+    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i) {
+        std::map<const ObjectCalcer *, quint32>::const_iterator id = mids.find((*i)->calcer());
+        // if we don't know it, it was never in the journaled document..
+        if (id != mids.end())
+            mstream << static_cast<quint8>(RemoveHolderRecord) << id->second;
+    }
+}
+
+void KigJournal::recordImp(ObjectConstCalcer *o)
+{
+    if (!mstarted)
+        return;
+    // a new calcer is defined with its current imp..
+    if (mids.find(o) == mids.end()) {
+        calcerId(o);
+        return;
+    }
+    QString type;
+    const QByteArray xml = serializeImp(*o->imp(), type);
+    mstream << static_cast<quint8>(ImpRecord) << mids[o] << type << xml;
+}
+
+void KigJournal::recordParentsAndType(ObjectTypeCalcer *o)
+{
+    if (!mstarted)
+        return;
+    if (mids.find(o) == mids.end()) {
+        calcerId(o);
+        return;
+    }
+    const std::vector<ObjectCalcer *> parents = o->parents();
+    std::vector<quint32> parentids;
+    for (std::vector<ObjectCalcer *>::const_iterator i = parents.begin(); i != parents.end(); ++i)
+        parentids.push_back(calcerId(*i));
+    mstream << static_cast<quint8>(ParentsAndTypeRecord) << mids[o] << QByteArray(o->type()->fullName());
+    writeIds(mstream, parentids);
+}
+
+void KigJournal::recordDrawer(const ObjectHolder *o)
+{
+    if (!mstarted)
+        return;
+    std::map<const ObjectCalcer *, quint32>::const_iterator id = mids.find(o->calcer());
+    if (id == mids.end())
+        return;
+    mstream << static_cast<quint8>(DrawerRecord) << id->second;
+    writeDrawer(o);
+}
+
+void KigJournal::recordName(ObjectHolder *o)
+{
+    if (!mstarted)
+        return;
+    std::map<const ObjectCalcer *, quint32>::const_iterator id = mids.find(o->calcer());
+    if (id == mids.end())
+        return;
+    const quint32 holderid = id->second;
+    // the name calcer is not always known yet, e.g. if the object was
+    // just named for the first time..
+    const quint32 nameid = o->nameCalcer() ? calcerId(o->nameCalcer()) : 0;
+    mstream << static_cast<quint8>(NameRecord) << holderid << nameid;
+}
+
+void KigJournal::recordCoordinateSystem()
+{
+    if (!mstarted)
+        return;
+    mstream << static_cast<quint8>(CoordinateSystemRecord) << QByteArray(mpart.document().coordinateSystem().type());
+}
+
+static ObjectDrawer *readDrawer(QDataStream &s)
+{
+    QColor color;
+    qint32 width, style, pointstyle;
+    bool shown;
+    QFont font;
+    s >> color >> width >> shown >> style >> pointstyle >> font;
+    return new ObjectDrawer(color, width, shown, static_cast<Qt::PenStyle>(style), static_cast<Kig::PointStyle>(pointstyle), font);
+}
+
+static bool readParents(QDataStream &s, const std::vector<ObjectCalcer::shared_ptr> &calcers, std::vector<ObjectCalcer *> &parents)
+{
+    quint32 n = 0;
+    s >> n;
+    for (quint32 i = 0; i < n && s.status() == QDataStream::Ok; ++i) {
+        quint32 id = 0;
+        s >> id;
+        if (id == 0 || id > calcers.size())
+            return false;
+        parents.push_back(calcers[id - 1].get());
+    }
+    return s.status() == QDataStream::Ok;
+}
+
+static ObjectCalcer *readCalcer(QDataStream &s, const std::vector<ObjectCalcer::shared_ptr> &calcers)
+{
+    quint32 id = 0;
+    s >> id;
+    if (id == 0 || id > calcers.size())
+        return nullptr;
+    return calcers[id - 1].get();
+}
+
+static void calcChildren(ObjectCalcer *o, const KigDocument &doc)
+{
+    std::set<ObjectCalcer *> allchildren = getAllChildren(o);
+    std::vector<ObjectCalcer *> allchildrenvect(allchildren.begin(), allchildren.end());
+    allchildrenvect = calcPath(allchildrenvect);
+    for (std::vector<ObjectCalcer *>::iterator i = allchildrenvect.begin(); i != allchildrenvect.end(); ++i)
+        (*i)->calc(doc);
+}
+
+/**
+ * apply the records of one command to \p doc..
+ */
+static bool replay(QDataStream &s,
+                   KigDocument &doc,
+                   std::vector<ObjectCalcer::shared_ptr> &calcers,
+                   std::map<const ObjectCalcer *, ObjectHolder *> &holders)
+{
+    while (!s.atEnd()) {
+        quint8 kind = 0;
+        s >> kind;
+        switch (kind) {
+        case CoordinateSystemRecord: {
+            QByteArray type;
+            s >> type;
+            CoordinateSystem *cs = CoordinateSystemFactory::build(type.constData());
+            if (!cs)
+                return false;
+            doc.setCoordinateSystem(cs);
+            break;
+        }
+        case GridAxesRecord: {
+            bool grid, axes;
+            s >> grid >> axes;
+            doc.setGrid(grid);
+            doc.setAxes(axes);
+            break;
+        }
+        case DataRecord:
+        case PropertyRecord:
+        case TypeRecord: {
+            quint32 id = 0;
+            s >> id;
+            if (id != calcers.size() + 1)
+                return false;
+            ObjectCalcer *o = nullptr;
+            if (kind == DataRecord) {
+                QString type;
+                QByteArray xml;
+                s >> type >> xml;
+                ObjectImp *imp = deserializeImp(type, xml);
+                if (!imp)
+                    return false;
+                o = new ObjectConstCalcer(imp);
+            } else if (kind == PropertyRecord) {
+                ObjectCalcer *parent = readCalcer(s, calcers);
+                QByteArray name;
+                s >> name;
+                if (!parent)
+                    return false;
+                o = new ObjectPropertyCalcer(parent, name.constData());
+            } else {
+                QByteArray type;
+                s >> type;
+                std::vector<ObjectCalcer *> parents;
+                const ObjectType *t = ObjectTypeFactory::instance()->find(type.constData());
+                if (!t || !readParents(s, calcers, parents))
+                    return false;
+                o = new ObjectTypeCalcer(t, parents, false);
+            }
+            o->calc(doc);
+            calcers.push_back(o);
+            break;
+        }
+        case ImpRecord: {
+            ObjectConstCalcer *o = dynamic_cast<ObjectConstCalcer *>(readCalcer(s, calcers));
+            QString type;
+            QByteArray xml;
+            s >> type >> xml;
+            ObjectImp *imp = o ? deserializeImp(type, xml) : nullptr;
+            if (!imp)
+                return false;
+            delete o->switchImp(imp);
+            calcChildren(o, doc);
+            break;
+        }
+        case ParentsAndTypeRecord: {
+            ObjectTypeCalcer *o = dynamic_cast<ObjectTypeCalcer *>(readCalcer(s, calcers));
+            QByteArray type;
+            s >> type;
+            std::vector<ObjectCalcer *> parents;
+            const ObjectType *t = ObjectTypeFactory::instance()->find(type.constData());
+            if (!o || !t || !readParents(s, calcers, parents))
+                return false;
+            o->setType(t);
+            o->setParents(parents);
+            o->calc(doc);
+            calcChildren(o, doc);
+            break;
+        }
+        case AddHolderRecord: {
+            ObjectCalcer *o = readCalcer(s, calcers);
+            quint32 nameid = 0;
+            s >> nameid;
+            ObjectDrawer *drawer = readDrawer(s);
+            ObjectConstCalcer *namecalcer = nullptr;
+            if (nameid != 0) {
+                if (nameid > calcers.size())
+                    o = nullptr;
+                else
+                    namecalcer = dynamic_cast<ObjectConstCalcer *>(calcers[nameid - 1].get());
+            }
+            if (!o || (nameid != 0 && !namecalcer)) {
+                delete drawer;
+                return false;
+            }
+            std::map<const ObjectCalcer *, ObjectHolder *>::iterator h = holders.find(o);
+            if (h != holders.end()) {
+                // the object was already added outside of a command..
+                delete h->second->switchDrawer(drawer);
+                h->second->switchNameCalcer(namecalcer);
+            } else {
+                ObjectHolder *holder = new ObjectHolder(o, drawer, namecalcer);
+                holders[o] = holder;
+                doc.addObject(holder);
+            }
+            break;
+        }
+        case RemoveHolderRecord: {
+            ObjectCalcer *o = readCalcer(s, calcers);
+            if (!o)
+                return false;
+            std::map<const ObjectCalcer *, ObjectHolder *>::iterator h = holders.find(o);
+            if (h != holders.end()) {
+                doc.delObject(h->second);
+                delete h->second;
+                holders.erase(h);
+            }
+            break;
+        }
+        case DrawerRecord: {
+            ObjectCalcer *o = readCalcer(s, calcers);
+            ObjectDrawer *drawer = readDrawer(s);
+            std::map<const ObjectCalcer *, ObjectHolder *>::iterator h = holders.find(o);
+            if (h == holders.end()) {
+                delete drawer;
+                return false;
+            }
+            delete h->second->switchDrawer(drawer);
+            break;
+        }
+        case NameRecord: {
+            ObjectCalcer *o = readCalcer(s, calcers);
+            quint32 nameid = 0;
+            s >> nameid;
+            std::map<const ObjectCalcer *, ObjectHolder *>::iterator h = holders.find(o);
+            if (h == holders.end() || nameid > calcers.size())
+                return false;
+            ObjectConstCalcer *namecalcer = nullptr;
+            if (nameid != 0) {
+                namecalcer = dynamic_cast<ObjectConstCalcer *>(calcers[nameid - 1].get());
+                if (!namecalcer)
+                    return false;
+            }
+            h->second->switchNameCalcer(namecalcer);
+            break;
+        }
+        default:
+            return false;
+        }
+        if (s.status() != QDataStream::Ok)
+            return false;
+    }
+    return true;
+}
+
+KigDocument *KigJournal::recover(const QString &file)
+{
+    QFile f(journalFile(file));
+    if (!f.open(QIODevice::ReadOnly))
+        return nullptr;
+    QDataStream s(&f);
+    s.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0;
+    QString path;
+    s >> magic >> version >> path;
+    if (s.status() != QDataStream::Ok || magic != journalmagic || version != journalversion)
+        return nullptr;
+
+    KigDocument *doc = new KigDocument();
+    std::vector<ObjectCalcer::shared_ptr> calcers;
+    std::map<const ObjectCalcer *, ObjectHolder *> holders;
+    bool gotsnapshot = false;
+    while (!s.atEnd()) {
+        quint32 size = 0;
+        s >> size;
+        if (s.status() != QDataStream::Ok || size > f.size())
+            break;
+        QByteArray record(size, Qt::Uninitialized);
+        if (s.readRawData(record.data(), size) != static_cast<int>(size))
+            break;
+        quint16 checksum = 0;
+        s >> checksum;
+        if (s.status() != QDataStream::Ok || checksum != qChecksum(QByteArrayView(record)))
+            break;
+
+        QDataStream rs(record);
+        rs.setVersion(QDataStream::Qt_6_0);
+        if (!replay(rs, *doc, calcers, holders))
+            break;
+        gotsnapshot = true;
+    }
+    if (!gotsnapshot) {
+        delete doc;
+        return nullptr;
+    }
+
+    std::vector<ObjectCalcer *> tmp = calcPath(getAllParents(getAllCalcers(doc->objects())));
+    for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
+        (*i)->calc(*doc);
+    return doc;
+}
@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QString>
+
+#include "../objects/object_calcer.h"
+
+class KigDocument;
+class KigPart;
+class ObjectHolder;
+
+/**
+ * The KigJournal protects the unsaved changes to a document against
+ * crashes.  Every KigCommand that is done or undone appends a small
+ * record of what it changed to a side file, instead of saving the
+ * whole document again.
+ *
+ * The calcers and holders in the records are referred to by an id that
+ * only the journal knows about, so the journal starts with a snapshot
+ * of the document as it was when it was last opened or saved, written
+ * in the same records on the first change after that.  Saving the
+ * document removes the journal, it starts again from a new snapshot on
+ * the next change.  When the document is closed normally, the journal
+ * is removed too, so if one is left over when the document is opened
+ * again, Kig did not exit cleanly, and recover() can rebuild the lost
+ * state by replaying it.
+ *
+ * Only documents that have a file are journaled..
+ */
+class KigJournal
+{
+public:
+    explicit KigJournal(KigPart &part);
+    ~KigJournal();
+
+    /**
+     * forget the current journal, and start journaling the document
+     * stored in \p file.  An empty \p file turns journaling off..
+     */
+    void reset(const QString &file);
+    /**
+     * remove the journal file, the changes are not worth protecting
+     * anymore..
+     */
+    void discard();
+    /**
+     * write the snapshot right away, instead of on the next change..
+     */
+    void checkpoint();
+
+    /**
+     * KigCommand calls these around doing or undoing its tasks, the
+     * tasks call the record functions below in between.  The records
+     * of one command are written to disk in one piece by
+     * endCommand()..
+     */
+    void beginCommand();
+    void endCommand();
+
+    /**
+     * \p os are in the document now..
+     */
+    void recordAddObjects(const std::vector<ObjectHolder *> &os);
+    /**
+     * \p os are no longer in the document..
+     */
+    void recordRemoveObjects(const std::vector<ObjectHolder *> &os);
+    /**
+     * the imp of \p o has changed..
+     */
+    void recordImp(ObjectConstCalcer *o);
+    /**
+     * the type or the parents of \p o have changed..
+     */
+    void recordParentsAndType(ObjectTypeCalcer *o);
+    /**
+     * the drawer of \p o has changed..
+     */
+    void recordDrawer(const ObjectHolder *o);
+    /**
+     * \p o has been given a name, or another name calcer..
+     */
+    void recordName(ObjectHolder *o);
+    /**
+     * the coordinate system of the document has changed..
+     */
+    void recordCoordinateSystem();
+
+    /**
+     * the journal of the document in \p file, whether it exists or
+     * not..
+     */
+    static QString journalFile(const QString &file);
+    /**
+     * whether the document in \p file has a journal left over from a
+     * session that did not end normally..
+     */
+    static bool exists(const QString &file);
+    /**
+     * rebuild the document in \p file from its journal.  Returns 0 if
+     * the journal can't be read at all, a journal that was cut off
+     * while writing is replayed up to the last complete command..
+     */
+    static KigDocument *recover(const QString &file);
+
+private:
+    KigPart &mpart;
+    QString mfile;
+    QString mjournal;
+    bool mstarted;
+    int mdepth;
+
+    /**
+     * the records of the current command..
+     */
+    QBuffer mbuffer;
+    QDataStream mstream;
+
+    /**
+     * every calcer we have written a definition for, with its id.  We
+     * keep a reference to them, so that the address of a calcer is
+     * never reused for another one while we use it as a key..
+     */
+    std::map<const ObjectCalcer *, quint32> mids;
+    std::vector<ObjectCalcer::shared_ptr> mcalcers;
+
+    /**
+     * the id of \p o, writing its definition first if needed..
+     */
+    quint32 calcerId(ObjectCalcer *o);
+    void writeSnapshot();
+    void writeDrawer(const ObjectHolder *o);
+    bool appendRecord();
+
+    Q_DISABLE_COPY(KigJournal)
+};
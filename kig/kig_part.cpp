@@ -12,8 +12,10 @@
 #include "aboutdata.h"
 #include "kig_commands.h"
 #include "kig_document.h"
+#include "kig_journal.h"
 #include "kig_view.h"
 
+#include "../filters/batchexporter.h"
 #include "../filters/exporter.h"
 #include "../filters/filter.h"
 #include "../misc/builtin_stuff.h"
@@ -22,14 +24,21 @@
 #include "../misc/guiaction.h"
 #include "../misc/kigcoordinateprecisiondialog.h"
 #include "../misc/kigpainter.h"
+#include "../misc/kigprofilerdialog.h"
+#include "../misc/kigtracer.h"
 #include "../misc/lists.h"
+#include "../misc/macro_index.h"
 #include "../misc/object_constructor.h"
 #include "../misc/screeninfo.h"
 #include "../modes/normal.h"
 #include "../objects/object_drawer.h"
 #include "../objects/point_imp.h"
+#ifdef KIG_ENABLE_PYTHON_SCRIPTING
+#include "../scripting/python_scripter.h"
+#endif
 
 #include <algorithm>
+#include <cstdio>
 #include <functional>
 #include <iterator>
 
@@ -45,11 +54,13 @@
 #include <QTimer>
 
 #include <KActionCollection>
+#include <KConfigGroup>
 #include <KIconEngine>
 #include <KIconLoader>
 #include <KMessageBox>
 #include <KParts/OpenUrlArguments>
 #include <KPluginFactory>
+#include <KSharedConfig>
 #include <KStandardAction>
 #include <KToggleAction>
 #include <KUndoActions>
@@ -180,6 +191,13 @@ KigPart::KigPart(QObject *parent, const KPluginMetaData &data)
     // notify the part that this is our internal widget
     setWidget(m_widget);
 
+    // the tracer can be turned on from the start, to see where the time
+    // goes while a document is loaded..
+    KConfigGroup tracecg = KSharedConfig::openConfig()->group(QStringLiteral("Tracing"));
+    KigTracer::setCapacity(tracecg.readEntry("BufferSize", KigTracer::capacity()));
+    if (!qEnvironmentVariableIsEmpty("KIG_TRACE"))
+        KigTracer::setEnabled(true);
+
     // create our actions...
     setupActions();
 
@@ -194,6 +212,13 @@ KigPart::KigPart(QObject *parent, const KPluginMetaData &data)
     KUndoActions::createUndoAction(mhistory, actionCollection());
     KUndoActions::createRedoAction(mhistory, actionCollection());
     connect(mhistory, &QUndoStack::cleanChanged, this, &KigPart::setHistoryClean);
+    // trimming pushes commands again, so it can't be done while the
+    // history is still busy with the last one..
+    connect(mhistory, &QUndoStack::indexChanged, this, &KigPart::trimHistory, Qt::QueuedConnection);
+    KConfigGroup cg = KSharedConfig::openConfig()->group(QStringLiteral("History"));
+    mhistorylimit = static_cast<size_t>(qMax(cg.readEntry("MemoryLimit", 32), 0)) * 1024 * 1024;
+    mhistorymemory = 0;
+    mjournal = new KigJournal(*this);
 
     // we are read-write by default
     setReadWrite(true);
@@ -263,6 +288,22 @@ void KigPart::setupActions()
     connect(aBrowseHistory, &QAction::triggered, this, &KigPart::browseHistory);
     aBrowseHistory->setToolTip(i18n("Browse the history of the current construction."));
 
+    QAction *profiler = new QAction(QIcon::fromTheme(QStringLiteral("speedometer")), i18n("&Profiler..."), this);
+    actionCollection()->addAction(QStringLiteral("tools_profiler"), profiler);
+    connect(profiler, &QAction::triggered, this, &KigPart::showProfiler);
+    profiler->setToolTip(i18n("Find out which objects take the most time to calculate and draw."));
+
+    aToggleTrace = new KToggleAction(i18n("&Record Trace"), this);
+    actionCollection()->addAction(QStringLiteral("tools_record_trace"), aToggleTrace);
+    aToggleTrace->setToolTip(i18n("Keep a timeline of what Kig does, to be saved when something is slow."));
+    aToggleTrace->setChecked(KigTracer::enabled());
+    connect(aToggleTrace, &QAction::triggered, this, &KigPart::toggleTrace);
+
+    QAction *savetrace = new QAction(QIcon::fromTheme(QStringLiteral("document-save")), i18n("&Save Trace..."), this);
+    actionCollection()->addAction(QStringLiteral("tools_save_trace"), savetrace);
+    connect(savetrace, &QAction::triggered, this, &KigPart::saveTrace);
+    savetrace->setToolTip(i18n("Save the recorded timeline, to be viewed in Perfetto or attached to a bug report."));
+
     KigExportManager::instance()->addMenuAction(this, m_widget->realWidget(), actionCollection());
 
     QAction *a = KStandardAction::zoomIn(m_widget, SLOT(slotZoomIn()), actionCollection());
@@ -365,6 +406,9 @@ KigPart::~KigPart()
     // cleanup
     delete mMode;
     delete mhistory;
+    // we are closing normally, so there is nothing to recover..
+    mjournal->discard();
+    delete mjournal;
 
     delete mdocument;
 }
@@ -401,7 +445,37 @@ bool KigPart::openFile()
         return false;
     };
 
-    KigDocument *newdoc = filter->load(localFilePath());
+    // a journal that was left behind means that Kig did not exit
+    // normally while the document had unsaved changes..
+    KigDocument *newdoc = nullptr;
+    bool recovered = false;
+    if (KigJournal::exists(localFilePath())) {
+#if KWIDGETSADDONS_VERSION >= QT_VERSION_CHECK(5, 100, 0)
+        if (KMessageBox::questionTwoActions(widget(),
+#else
+        if (KMessageBox::questionYesNo(widget(),
+#endif
+                                            i18n("Kig was not closed normally while the document \"%1\" had unsaved changes. "
+                                                 "Do you want to recover them?",
+                                                 localFilePath()),
+                                            i18n("Recover Unsaved Changes"),
+                                            KGuiItem(i18n("Recover")),
+                                            KGuiItem(i18n("Discard")))
+#if KWIDGETSADDONS_VERSION >= QT_VERSION_CHECK(5, 100, 0)
+            == KMessageBox::ButtonCode::PrimaryAction) {
+#else
+            == KMessageBox::Yes) {
+#endif
+            newdoc = KigJournal::recover(localFilePath());
+            recovered = newdoc != nullptr;
+            if (!recovered)
+                KMessageBox::error(widget(), i18n("The unsaved changes could not be recovered."), i18n("Recover Unsaved Changes"));
+        }
+    }
+    if (!newdoc) {
+        KigTracer::Span span("load", "file");
+        newdoc = filter->load(localFilePath());
+    }
     if (!newdoc) {
         closeUrl();
         setUrl(QUrl());
@@ -414,12 +488,17 @@ bool KigPart::openFile()
     aToggleAxes->setChecked(mdocument->axes());
     aToggleNightVision->setChecked(mdocument->getNightVision());
 
-    setModified(false);
+    setModified(recovered);
     mhistory->clear();
+    mjournal->reset(localFilePath());
 
     std::vector<ObjectCalcer *> tmp = calcPath(getAllParents(getAllCalcers(document().objects())));
     for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
         (*i)->calc(document());
+    // the recovered changes are not saved yet, keep them in the new
+    // journal..
+    if (recovered)
+        mjournal->checkpoint();
     Q_EMIT recenterScreen();
 
     redrawScreen();
@@ -434,7 +513,7 @@ bool KigPart::saveFile()
     // mimetype:
     const QMimeDatabase mimeDb;
     const QMimeType mimeType = mimeDb.mimeTypeForFile(localFilePath());
-    if (mimeType.name() != QLatin1String("application/x-kig")) {
+    if (mimeType.name() != QLatin1String("application/x-kig") && mimeType.name() != QLatin1String("application/x-kig-binary")) {
         // we don't support this mime type...
 #if KWIDGETSADDONS_VERSION >= QT_VERSION_CHECK(5, 100, 0)
         if (KMessageBox::warningTwoActions(widget(),
@@ -473,6 +552,7 @@ bool KigPart::saveFile()
     if (KigFilters::instance()->save(document(), localFilePath())) {
         setModified(false);
         mhistory->setClean();
+        mjournal->reset(localFilePath());
         return true;
     }
     return false;
@@ -610,11 +690,41 @@ void KigPart::browseHistory()
     mode()->browseHistory();
 }
 
+void KigPart::showProfiler()
+{
+    KigProfilerDialog *d = new KigProfilerDialog(m_widget->realWidget(), m_widget);
+    d->show();
+}
+
+void KigPart::toggleTrace()
+{
+    // there is only one tracer for all the documents, so the action
+    // of every open document is checked or unchecked..
+    KigTracer::setEnabled(!KigTracer::enabled());
+    const GUIActionList::dvectype &docs = GUIActionList::instance()->docs();
+    for (GUIActionList::dvectype::const_iterator i = docs.begin(); i != docs.end(); ++i)
+        (*i)->aToggleTrace->setChecked(KigTracer::enabled());
+}
+
+void KigPart::saveTrace()
+{
+    const QString file = QFileDialog::getSaveFileName(m_widget, i18nc("@title:window", "Save Trace"), QString(), i18n("Chrome trace files (*.json)"));
+    if (file.isEmpty())
+        return;
+    if (!KigTracer::write(file))
+        KMessageBox::error(m_widget, i18n("The file \"%1\" could not be opened for writing.", file));
+}
+
 void KigPart::setHistoryClean(bool clean)
 {
     setModified(!clean);
 }
 
+void KigPart::trimHistory()
+{
+    KigCommand::trimHistory(*mhistory, mhistorymemory, mhistorylimit);
+}
+
 void KigPart::setCoordinatePrecision()
 {
     KigCoordinatePrecisionDialog dlg(document().isUserSpecifiedCoordinatePrecision(), document().getCoordinatePrecision());
@@ -626,11 +736,21 @@ void KigPart::setCoordinatePrecision()
     }
 }
 
+KigJournal *KigPart::journal()
+{
+    return mjournal;
+}
+
 QUndoStack *KigPart::history()
 {
     return mhistory;
 }
 
+size_t &KigPart::historyMemory()
+{
+    return mhistorymemory;
+}
+
 void KigPart::delObjects(const std::vector<ObjectHolder *> &os)
 {
     if (os.size() < 1)
@@ -702,7 +822,7 @@ void KigPart::fileSave()
 bool KigPart::internalSaveAs()
 {
     // this slot is connected to the KStandardAction::saveAs action...
-    QString formats = i18n("Kig Documents (*.kig);;Compressed Kig Documents (*.kigz)");
+    QString formats = i18n("Kig Documents (*.kig);;Compressed Kig Documents (*.kigz);;Binary Kig Documents (*.kigb)");
     QString currentDir = url().toLocalFile();
 
     if (currentDir.isNull()) {
@@ -805,6 +925,8 @@ void KigPart::setupMacroTypes()
             copy(nmacros.begin(), nmacros.end(), back_inserter(macros));
         }
         MacroList::instance()->add(macros);
+        // the builtin macros are indexed by now too..
+        MacroIndex::instance()->save();
     };
     // hack: we need to plug the action lists _after_ the gui is
     // built. I can't find a better solution than this.
@@ -960,6 +1082,9 @@ void KigPart::redrawScreen(KigWidget *w)
 
 void KigPart::redrawScreen()
 {
+    // this is called whenever the document changed, so the objects may
+    // have moved..
+    document().invalidateCoordinatePrecision();
     for (std::vector<KigWidget *>::iterator i = mwidgets.begin(); i != mwidgets.end(); ++i) {
         mode()->redrawScreen(*i);
     }
@@ -1011,8 +1136,6 @@ extern "C" KIGPART_EXPORT int convertToNative(const QUrl &url, const QByteArray
     std::vector<ObjectCalcer *> tmp = calcPath(getAllParents(getAllCalcers(doc->objects())));
     for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
         (*i)->calc(*doc);
-    for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
-        (*i)->calc(*doc);
 
     QString out = (outfile == "-") ? QString() : outfile;
     bool success = KigFilters::instance()->save(*doc, out);
@@ -1026,6 +1149,52 @@ extern "C" KIGPART_EXPORT int convertToNative(const QUrl &url, const QByteArray
     return 0;
 }
 
+extern "C" KIGPART_EXPORT int batchExport(const QStringList &files, const QStringList &formats, const QString &outdir, int jobs, const QSize &size)
+{
+    const QStringList supported = KigBatchExporter::supportedFormats();
+    for (const QString &format : formats) {
+        if (!supported.contains(format)) {
+            qCritical().noquote() << "Unknown export format" << format << "- supported formats are:" << supported.join(QLatin1String(", "));
+            return -1;
+        }
+    }
+
+    KigBatchExporter exporter(formats, outdir, size);
+    return exporter.run(files, jobs) == 0 ? 0 : 1;
+}
+
+extern "C" KIGPART_EXPORT int runScript(const QString &file, const QStringList &args)
+{
+#ifdef KIG_ENABLE_PYTHON_SCRIPTING
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) {
+        qCritical() << "Could not open the script" << file;
+        return -1;
+    }
+    const QByteArray code = f.readAll();
+
+    std::vector<std::string> argv;
+    argv.push_back(file.toStdString());
+    for (const QString &arg : args)
+        argv.push_back(arg.toStdString());
+
+    // the script may load and save documents, nothing may show a
+    // message box..
+    KigFilter::setBatchMode(true);
+    PythonScripter *inst = PythonScripter::instance();
+    const int ret = inst->run(code.constData(), QFile::encodeName(file).constData(), argv);
+    if (inst->errorOccurred())
+        fputs(inst->lastErrorExceptionTraceback().c_str(), stderr);
+    KigFilter::setBatchMode(false);
+    return ret;
+#else
+    Q_UNUSED(file);
+    Q_UNUSED(args);
+    qCritical() << "This version of Kig was built without Python scripting support.";
+    return -1;
+#endif
+}
+
 void KigPart::toggleGrid()
 {
     bool toshow = !mdocument->grid();
@@ -1074,7 +1243,13 @@ void KigPart::saveTypes()
         QFile::remove(typesFileWithPath);
 
     MacroList *macrolist = MacroList::instance();
-    macrolist->save(macrolist->macros(), typesFileWithPath);
+    if (macrolist->save(macrolist->macros(), typesFileWithPath)) {
+        // index the new file now, so that the next start doesn't have
+        // to..
+        MacroIndex::vectype entries;
+        MacroIndex::instance()->lookup(typesFileWithPath, entries);
+        MacroIndex::instance()->save();
+    }
 }
 
 void KigPart::loadTypes()
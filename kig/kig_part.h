@@ -27,6 +27,7 @@ class QPrinter;
 class GUIAction;
 class KigGUIAction;
 class KigDocument;
+class KigJournal;
 class KigMode;
 class KigPart;
 class KigView;
@@ -114,12 +115,20 @@ public Q_SLOTS:
     void newMacro();
     void editTypes();
     void browseHistory();
+    void showProfiler();
+    void toggleTrace();
+    void saveTrace();
 
     void toggleGrid();
     void toggleAxes();
     void toggleNightVision();
 
     void setHistoryClean(bool);
+    /**
+     * drop the oldest commands from the history, if it uses more
+     * memory than the user allows..
+     */
+    void trimHistory();
 
     void setCoordinatePrecision();
 
@@ -204,6 +213,17 @@ protected:
      * the command history
      */
     QUndoStack *mhistory;
+    /**
+     * the most memory mhistory may use, in bytes, or 0 for no limit..
+     */
+    size_t mhistorylimit;
+    size_t mhistorymemory;
+
+    /**
+     * protects the changes in mhistory that are not saved yet against
+     * crashes..
+     */
+    KigJournal *mjournal;
 
 public:
     // actions: this is an annoying case, didn't really fit into my
@@ -237,6 +257,7 @@ public:
     KToggleAction *aToggleGrid;
     KToggleAction *aToggleAxes;
     KToggleAction *aToggleNightVision;
+    KToggleAction *aToggleTrace;
     std::vector<KigGUIAction *> aActions;
 
     /**
@@ -257,6 +278,13 @@ public:
     void endGUIActionUpdate(GUIUpdateToken &t);
 
     QUndoStack *history();
+    /**
+     * an estimate of the memory used by the commands in history(), in
+     * bytes.  The commands add themselves to it when they are first
+     * done, and take themselves out again when they are deleted..
+     */
+    size_t &historyMemory();
+    KigJournal *journal();
 
     void enableConstructActions(bool enabled);
 
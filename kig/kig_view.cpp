@@ -9,6 +9,7 @@
 
 #include "../misc/coordinate_system.h"
 #include "../misc/kiginputdialog.h"
+#include "../misc/kigtracer.h"
 #include "../misc/kigpainter.h"
 #include "../modes/dragrectmode.h"
 #include "../modes/mode.h"
@@ -16,18 +17,26 @@
 #include "kig_document.h"
 #include "kig_part.h"
 
+#include <KConfigGroup>
+#include <KSharedConfig>
+
 #include <QGridLayout>
+#include <QPaintEvent>
+#include <QRegion>
 #include <QScrollBar>
 #include <QWheelEvent>
 
 #include <algorithm>
 #include <cmath>
 #include <iterator>
+#include <numeric>
 
 KigWidget::KigWidget(KigPart *part, KigView *view, QWidget *parent, bool fullscreen)
     : QWidget(parent, fullscreen ? Qt::FramelessWindowHint : Qt::Widget)
     , mpart(part)
     , mview(view)
+    , mlastframemoved(false)
+    , mframemoved(false)
     , stillPix(size())
     , curPix(size())
     , msi(Rect(), rect())
@@ -37,6 +46,11 @@ KigWidget::KigWidget(KigPart *part, KigView *view, QWidget *parent, bool fullscr
 {
     part->addWidget(this);
 
+    mframetimer.setSingleShot(true);
+    connect(&mframetimer, &QTimer::timeout, this, &KigWidget::dispatchPendingMove);
+    KConfigGroup cg = KSharedConfig::openConfig()->group(QStringLiteral("Interaction"));
+    setTargetFrameRate(cg.readEntry("TargetFrameRate", 60));
+
     setFocusPolicy(Qt::ClickFocus);
     setAttribute(Qt::WA_OpaquePaintEvent, true);
     setMouseTracking(true);
@@ -54,12 +68,16 @@ void KigWidget::paintEvent(QPaintEvent *e)
 {
     mispainting = true;
     std::vector<QRect> overlay;
-    overlay.push_back(e->rect());
+    for (const QRect &r : e->region())
+        overlay.push_back(r);
     updateWidget(overlay);
 }
 
 void KigWidget::mousePressEvent(QMouseEvent *e)
 {
+    KigTracer::Span span("mousePress", "input");
+    // the modes must see the last move before the click..
+    dispatchPendingMove();
     if (e->button() & Qt::LeftButton)
         return mpart->mode()->leftClicked(e, this);
     if (e->button() & Qt::MiddleButton)
@@ -70,17 +88,48 @@ void KigWidget::mousePressEvent(QMouseEvent *e)
 
 void KigWidget::mouseMoveEvent(QMouseEvent *e)
 {
+    if (mframeinterval <= 0)
+        return dispatchMove(e);
+
+    // if we haven't handled a move for a frame, we do it right away,
+    // otherwise we keep this one, replacing the one that was waiting,
+    // until the frame is over..
+    if (!mframetimer.isActive() && (!mlastmove.isValid() || mlastmove.elapsed() >= mframeinterval))
+        return dispatchMove(e);
+
+    mpendingmove.reset(static_cast<QMouseEvent *>(e->clone()));
+    if (!mframetimer.isActive())
+        mframetimer.start(qMax<qint64>(0, mframeinterval - mlastmove.elapsed()));
+}
+
+void KigWidget::dispatchPendingMove()
+{
+    mframetimer.stop();
+    if (!mpendingmove)
+        return;
+    std::unique_ptr<QMouseEvent> e(std::move(mpendingmove));
+    dispatchMove(e.get());
+}
+
+void KigWidget::dispatchMove(QMouseEvent *e)
+{
+    KigTracer::Span span("mouseMove", "input");
+    mlastmove.start();
     if ((e->buttons() & Qt::LeftButton) == Qt::LeftButton)
-        return mpart->mode()->leftMouseMoved(e, this);
-    if ((e->buttons() & Qt::MiddleButton) == Qt::MiddleButton)
-        return mpart->mode()->midMouseMoved(e, this);
-    if ((e->buttons() & Qt::RightButton) == Qt::RightButton)
-        return mpart->mode()->rightMouseMoved(e, this);
-    return mpart->mode()->mouseMoved(e, this);
+        mpart->mode()->leftMouseMoved(e, this);
+    else if ((e->buttons() & Qt::MiddleButton) == Qt::MiddleButton)
+        mpart->mode()->midMouseMoved(e, this);
+    else if ((e->buttons() & Qt::RightButton) == Qt::RightButton)
+        mpart->mode()->rightMouseMoved(e, this);
+    else
+        mpart->mode()->mouseMoved(e, this);
+    mframemoved = true;
 }
 
 void KigWidget::mouseReleaseEvent(QMouseEvent *e)
 {
+    KigTracer::Span span("mouseRelease", "input");
+    dispatchPendingMove();
     if (e->button() & Qt::LeftButton)
         return mpart->mode()->leftReleased(e, this);
     if (e->button() & Qt::MiddleButton)
@@ -89,35 +138,109 @@ void KigWidget::mouseReleaseEvent(QMouseEvent *e)
         return mpart->mode()->rightReleased(e, this);
 }
 
+int KigWidget::targetFrameRate() const
+{
+    return mframeinterval > 0 ? 1000 / mframeinterval : 0;
+}
+
+void KigWidget::setTargetFrameRate(int fps)
+{
+    mframeinterval = fps > 0 ? qMax(1, 1000 / fps) : 0;
+    if (mframeinterval <= 0)
+        dispatchPendingMove();
+}
+
+const FrameTimeHistogram &KigWidget::frameTimes() const
+{
+    return mframetimes;
+}
+
+void KigWidget::clearFrameTimes()
+{
+    mframetimes.clear();
+}
+
+FrameTimeHistogram::FrameTimeHistogram()
+{
+    clear();
+}
+
+void FrameTimeHistogram::add(qint64 nsecs)
+{
+    qint64 ms = nsecs / 1000000;
+    int bucket = 0;
+    while (ms > 0 && bucket < NumberOfBuckets - 1) {
+        ms >>= 1;
+        ++bucket;
+    }
+    ++mbuckets[bucket];
+}
+
+void FrameTimeHistogram::clear()
+{
+    std::fill(mbuckets, mbuckets + NumberOfBuckets, 0);
+}
+
+int FrameTimeHistogram::count(int bucket) const
+{
+    return mbuckets[bucket];
+}
+
+int FrameTimeHistogram::total() const
+{
+    return std::accumulate(mbuckets, mbuckets + NumberOfBuckets, 0);
+}
+
+QString FrameTimeHistogram::toString() const
+{
+    QStringList ret;
+    for (int i = 0; i < NumberOfBuckets; ++i) {
+        const int from = i == 0 ? 0 : 1 << (i - 1);
+        if (i == NumberOfBuckets - 1)
+            ret << QStringLiteral("[%1,inf) ms: %2").arg(from).arg(mbuckets[i]);
+        else
+            ret << QStringLiteral("[%1,%2) ms: %3").arg(from).arg(1 << i).arg(mbuckets[i]);
+    }
+    return ret.join(QStringLiteral(", "));
+}
+
 void KigWidget::updateWidget(const std::vector<QRect> &overlay)
 {
     if (!mispainting) {
-        QRect r;
-        int rectinited = false;
+        // the overlay rects have already been merged by KigPainter, so
+        // we can simply ask Qt to repaint the region they cover..
+        QRegion r;
         for (std::vector<QRect>::const_iterator i = oldOverlay.begin(); i != oldOverlay.end(); ++i)
-            if (rectinited)
-                r |= *i;
-            else {
-                r = *i;
-                rectinited = true;
-            }
+            r += *i;
         for (std::vector<QRect>::const_iterator i = overlay.begin(); i != overlay.end(); ++i)
-            if (rectinited)
-                r |= *i;
-            else {
-                r = *i;
-                rectinited = true;
-            }
+            r += *i;
         repaint(r);
         return;
     }
 
     oldOverlay = overlay;
 
+    KigTracer::Span span("blitOverlay", "paint");
+    moverlaystats = OverlayStats();
     QPainter p(this);
-    p.drawPixmap(overlay.front().topLeft(), curPix, overlay.front());
+    for (std::vector<QRect>::const_iterator i = overlay.begin(); i != overlay.end(); ++i) {
+        p.drawPixmap(i->topLeft(), curPix, *i);
+        ++moverlaystats.rects;
+        moverlaystats.pixels += static_cast<qint64>(i->width()) * i->height();
+    }
     p.end();
     mispainting = false;
+
+    if (mframemoved && mlastframemoved && mlastframe.isValid())
+        mframetimes.add(mlastframe.nsecsElapsed());
+    mlastframe.start();
+    mlastframemoved = mframemoved;
+    mframemoved = false;
+}
+
+const KigWidget::OverlayStats &KigWidget::lastOverlayStats() const
+{
+    return moverlaystats;
 }
 
 void KigWidget::updateEntireWidget()
@@ -167,7 +290,8 @@ void KigWidget::updateCurPix(const std::vector<QRect> &ol)
 
     // we add ol to oldOverlay, so that part of the widget will be
     // updated too in updateWidget...
-    std::copy(ol.begin(), ol.end(), std::back_inserter(oldOverlay));
+    for (std::vector<QRect>::const_iterator i = ol.begin(); i != ol.end(); ++i)
+        KigPainter::mergeOverlay(oldOverlay, *i);
 }
 
 void KigWidget::recenterScreen()
@@ -211,13 +335,75 @@ void KigWidget::slotZoomOut()
 
 void KigWidget::clearStillPix()
 {
-    stillPix.fill(Qt::white);
+    stillPix.fill(KigPainter::backgroundColor(mpart->document().getNightVision()));
     oldOverlay.clear();
     oldOverlay.push_back(QRect(QPoint(0, 0), size()));
 }
 
+bool KigWidget::GridKey::operator==(const GridKey &rhs) const
+{
+    return viewsize == rhs.viewsize && pixelwidth == rhs.pixelwidth && interval == rhs.interval && coordsystem == rhs.coordsystem
+        && showgrid == rhs.showgrid && showaxes == rhs.showaxes && nightvision == rhs.nightvision;
+}
+
+void KigWidget::drawGrid()
+{
+    const KigDocument &doc = mpart->document();
+    const CoordinateSystem &cs = doc.coordinateSystem();
+    if (!(doc.grid() || doc.axes()))
+        return;
+
+    const Rect sr = msi.shownRect();
+    const double pw = msi.pixelWidth();
+
+    GridKey key;
+    key.viewsize = size();
+    key.pixelwidth = pw;
+    key.interval = cs.gridInterval(sr, pw);
+    key.coordsystem = cs.id();
+    key.showgrid = doc.grid();
+    key.showaxes = doc.axes();
+    key.nightvision = doc.getNightVision();
+
+    // where the shown rect starts in mgridpix, in pixels.  We can only
+    // reuse the layer if that is a whole number of pixels, which is the
+    // case when scrolling, since the scroll bars move in steps of one
+    // pixel.
+    double dx = (sr.left() - mgridrect.left()) / pw;
+    double dy = (mgridrect.top() - sr.top()) / pw;
+    bool reuse = !mgridpix.isNull() && key == mgridkey && dx >= 0 && dy >= 0 && dx + width() <= mgridpix.width() && dy + height() <= mgridpix.height()
+        && std::fabs(dx - qRound(dx)) < 1e-3 && std::fabs(dy - qRound(dy)) < 1e-3;
+
+    if (!reuse) {
+        // the margin is a quarter of the view on every side, which
+        // covers a few scroll steps without costing too much memory..
+        const int mx = width() / 4;
+        const int my = height() / 4;
+        mgridrect = Rect(sr.left() - mx * pw, sr.bottom() - my * pw, sr.width() + 2 * mx * pw, sr.height() + 2 * my * pw);
+        mgridpix = QPixmap(width() + 2 * mx, height() + 2 * my);
+        mgridpix.fill(KigPainter::backgroundColor(key.nightvision));
+        mgridkey = key;
+
+        KigPainter p(ScreenInfo(mgridrect, mgridpix.rect()), &mgridpix, doc, false);
+        cs.drawGridLayer(p, sr, doc.grid(), doc.axes());
+
+        dx = mx;
+        dy = my;
+    }
+
+    QPainter qp(&stillPix);
+    qp.drawPixmap(QPoint(0, 0), mgridpix, QRect(QPoint(qRound(dx), qRound(dy)), size()));
+    qp.end();
+
+    if (doc.axes()) {
+        KigPainter p(msi, &stillPix, doc, false);
+        cs.drawAxesArrows(p);
+    }
+}
+
 void KigWidget::redrawScreen(const std::vector<ObjectHolder *> &_selection, bool dos)
 {
+    KigTracer::Span span("redrawScreen", "paint");
     std::vector<ObjectHolder *> nonselection;
     std::vector<ObjectHolder *> selection = _selection;
     std::set<ObjectHolder *> objs = mpart->document().objectsSet();
@@ -226,8 +412,9 @@ void KigWidget::redrawScreen(const std::vector<ObjectHolder *> &_selection, bool
 
     // update the screen...
     clearStillPix();
+    drawGrid();
     KigPainter p(msi, &stillPix, mpart->document());
-    p.drawGrid(mpart->document().coordinateSystem(), mpart->document().grid(), mpart->document().axes());
+    p.setWholeWinOverlay();
     p.drawObjects(selection, true);
     p.drawObjects(nonselection, false);
     updateCurPix(p.overlay());
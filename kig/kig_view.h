@@ -7,11 +7,14 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QPixmap>
+#include <QTimer>
 #include <QWidget>
 
 #include <kparts/part.h>
 
+#include <memory>
 #include <vector>
 
 #include "../misc/rect.h"
@@ -24,6 +27,31 @@ class QScrollBar;
 class KigDocument;
 class KigView;
 
+/**
+ * a small histogram of the time between frames, with buckets of powers of two milliseconds: [0,1), [1,2), [2,4), ...
+ * [64,inf) ms.
+ */
+class FrameTimeHistogram
+{
+public:
+    enum { NumberOfBuckets = 8 };
+
+    FrameTimeHistogram();
+
+    void add(qint64 nsecs);
+    void clear();
+
+    int count(int bucket) const;
+    int total() const;
+    /**
+     * something like "[0,1) ms: 12, [1,2) ms: 3, ..."
+     */
+    QString toString() const;
+
+private:
+    int mbuckets[NumberOfBuckets];
+};
+
 /**
  * This class is the real widget showing the document.  The other is a
  * wrapper, that has the scrollbars...  I'm not using QScrollView
@@ -39,6 +67,29 @@ class KigWidget : public QWidget
     KigPart *mpart;
     KigView *mview;
 
+    /**
+     * mouse moves are not handled right away, we keep the last one in
+     * mpendingmove and handle it when mframetimer times out, so that
+     * modes do at most one recalc and redraw per frame...
+     */
+    std::unique_ptr<QMouseEvent> mpendingmove;
+    QTimer mframetimer;
+    QElapsedTimer mlastmove;
+    int mframeinterval;
+    /**
+     * when the last frame was presented, and whether it and the one
+     * being prepared show a mouse move.  Only the time between two
+     * such frames goes into mframetimes, so that the idle time between
+     * two drags doesn't..
+     */
+    QElapsedTimer mlastframe;
+    bool mlastframemoved;
+    bool mframemoved;
+    FrameTimeHistogram mframetimes;
+
+    void dispatchMove(QMouseEvent *e);
+    void dispatchPendingMove();
+
     // we reimplement these from QWidget to suit our needs
     void mousePressEvent(QMouseEvent *e) override;
     void mouseMoveEvent(QMouseEvent *e) override;
@@ -68,9 +119,20 @@ public:
      */
     QPixmap curPix;
 
+    /**
+     * statistics about the last time curPix was copied onto the
+     * widget: the number of rects, and the number of pixels in them.
+     */
+    struct OverlayStats {
+        int rects = 0;
+        qint64 pixels = 0;
+    };
+
 protected:
     std::vector<QRect> oldOverlay;
 
+    OverlayStats moverlaystats;
+
     /**
      * this is a class that maps from our widget coordinates to the
      * document's coordinates ( and back ).
@@ -86,6 +148,27 @@ protected:
 
     bool malreadyresized;
 
+    /**
+     * the grid and the axes are rendered into mgridpix, which shows
+     * mgridrect: the shown rect, enlarged by a margin on every side.
+     * It is reused as long as mgridkey doesn't change and the shown
+     * rect stays inside mgridrect, so that neither repaints nor
+     * scrolling need to draw the grid again.  \see drawGrid()
+     */
+    struct GridKey {
+        QSize viewsize;
+        double pixelwidth = 0.;
+        Coordinate interval;
+        int coordsystem = -1;
+        bool showgrid = false;
+        bool showaxes = false;
+        bool nightvision = false;
+        bool operator==(const GridKey &rhs) const;
+    };
+    GridKey mgridkey;
+    QPixmap mgridpix;
+    Rect mgridrect;
+
 public:
     /**
      * standard qwidget constructor.  if fullscreen is true, we're a
@@ -97,6 +180,22 @@ public:
     bool isFullScreen() const;
     void setFullScreen(bool f);
 
+    /**
+     * how many mouse moves per second we handle at most.  It is read
+     * from the "TargetFrameRate" entry of the "Interaction" group of
+     * the configuration, and defaults to 60.  0 means that every mouse
+     * move is handled right away.
+     */
+    int targetFrameRate() const;
+    void setTargetFrameRate(int fps);
+
+    /**
+     * the time between the frames that were presented while the mouse
+     * moved...
+     */
+    const FrameTimeHistogram &frameTimes() const;
+    void clearFrameTimes();
+
     const KigView *view() const
     {
         return mview;
@@ -136,6 +235,12 @@ public:
      * clear stillPix...
      */
     void clearStillPix();
+    /**
+     * draw the grid and the axes on stillPix, reusing the cached grid
+     * layer if possible.  This should be called right after
+     * clearStillPix()...
+     */
+    void drawGrid();
     /**
      * update curPix (bitBlt stillPix onto curPix.)
      */
@@ -146,6 +251,10 @@ public:
      */
     void updateWidget(const std::vector<QRect> & = std::vector<QRect>());
     void updateEntireWidget();
+    /**
+     * how much work the last updateWidget() did...
+     */
+    const OverlayStats &lastOverlayStats() const;
 
     /**
      * Mapping between Internal Coordinate Systems
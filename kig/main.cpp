@@ -12,6 +12,7 @@
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QSize>
 #include <QStandardPaths>
 
 #include <KAboutData>
@@ -34,6 +35,32 @@ static int convertToNative(const QUrl &file, const QByteArray &outfile)
     return (*converterfunction)(file, outfile);
 }
 
+static int batchExport(const QStringList &files, const QStringList &formats, const QString &outdir, int jobs, const QSize &size)
+{
+    QPluginLoader libraryLoader(QStringLiteral("kf" QT_STRINGIFY(QT_VERSION_MAJOR)) + QStringLiteral("/parts/kigpart"));
+    QLibrary library(libraryLoader.fileName());
+    int (*exportfunction)(const QStringList &, const QStringList &, const QString &, int, const QSize &);
+    exportfunction = (int (*)(const QStringList &, const QStringList &, const QString &, int, const QSize &))library.resolve("batchExport");
+    if (!exportfunction) {
+        qCritical() << "Error: broken Kig installation: different library and application version !";
+        return -1;
+    }
+    return (*exportfunction)(files, formats, outdir, jobs, size);
+}
+
+static int runScript(const QString &file, const QStringList &args)
+{
+    QPluginLoader libraryLoader(QStringLiteral("kf" QT_STRINGIFY(QT_VERSION_MAJOR)) + QStringLiteral("/parts/kigpart"));
+    QLibrary library(libraryLoader.fileName());
+    int (*runfunction)(const QString &, const QStringList &);
+    runfunction = (int (*)(const QString &, const QStringList &))library.resolve("runScript");
+    if (!runfunction) {
+        qCritical() << "Error: broken Kig installation: different library and application version !";
+        return -1;
+    }
+    return (*runfunction)(file, args);
+}
+
 int main(int argc, char **argv)
 {
     QApplication app(argc, argv);
@@ -47,6 +74,23 @@ int main(int argc, char **argv)
     QCommandLineOption outfileOption(QStringList() << QStringLiteral("o") << QStringLiteral("outfile"),
                                      i18n("File to output the created native file to. '-' means output to stdout. Default is stdout as well."),
                                      QStringLiteral("file"));
+    QCommandLineOption exportToOption(QStringList() << QStringLiteral("e") << QStringLiteral("export-to"),
+                                      i18n("Do not show a GUI. Convert or export all the specified files to FORMAT, which can be one of native, kigz, kigb, "
+                                           "svg, pstricks, tikz, asymptote, xfig or an image format like png. Can be given more than once."),
+                                      QStringLiteral("format"));
+    QCommandLineOption outputDirOption(QStringList() << QStringLiteral("output-dir"),
+                                       i18n("Directory to write the files created by --export-to to. Default is next to each input file."),
+                                       QStringLiteral("dir"));
+    QCommandLineOption jobsOption(QStringList() << QStringLiteral("j") << QStringLiteral("jobs"),
+                                  i18n("Number of files --export-to processes at the same time. Default is one per processor core."),
+                                  QStringLiteral("count"));
+    QCommandLineOption runScriptOption(QStringList() << QStringLiteral("run-script"),
+                                       i18n("Do not show a GUI. Run the Python program in FILE, which can build, load, save and export documents "
+                                            "with the Document class of the kig module. The other arguments are passed to it in sys.argv."),
+                                       QStringLiteral("file"));
+    QCommandLineOption sizeOption(QStringList() << QStringLiteral("size"),
+                                  i18n("Size in pixels of the view that --export-to exports, like 800x600, which is the default."),
+                                  QStringLiteral("size"));
 
     QCoreApplication::setApplicationName(QStringLiteral("kig"));
     QCoreApplication::setApplicationVersion(KIG_VERSION_STRING);
@@ -56,13 +100,20 @@ int main(int argc, char **argv)
     about.setupCommandLine(&parser);
     parser.addOption(convertToNativeOption);
     parser.addOption(outfileOption);
+    parser.addOption(exportToOption);
+    parser.addOption(outputDirOption);
+    parser.addOption(jobsOption);
+    parser.addOption(sizeOption);
+    parser.addOption(runScriptOption);
     parser.addPositionalArgument(QStringLiteral("URL"), i18n("Document to open"));
     parser.process(app);
     about.processCommandLine(&parser);
 
     QStringList urls = parser.positionalArguments();
 
-    if (parser.isSet(QStringLiteral("convert-to-native"))) {
+    if (parser.isSet(QStringLiteral("run-script"))) {
+        return runScript(parser.value(QStringLiteral("run-script")), urls);
+    } else if (parser.isSet(QStringLiteral("convert-to-native"))) {
         QString outfile = parser.value(QStringLiteral("outfile"));
         if (outfile.isNull())
             outfile = '-';
@@ -75,6 +126,33 @@ int main(int argc, char **argv)
             return -1;
         }
         return convertToNative(QUrl::fromLocalFile(urls[0]), outfile.toLocal8Bit());
+    } else if (parser.isSet(QStringLiteral("export-to"))) {
+        if (urls.isEmpty()) {
+            qCritical() << "Error: --export-to specified without any files to export.";
+            return -1;
+        }
+        int jobs = 0;
+        if (parser.isSet(QStringLiteral("jobs"))) {
+            bool ok = true;
+            jobs = parser.value(QStringLiteral("jobs")).toInt(&ok);
+            if (!ok || jobs < 1) {
+                qCritical() << "Error: --jobs needs a positive number.";
+                return -1;
+            }
+        }
+        QSize size(800, 600);
+        if (parser.isSet(QStringLiteral("size"))) {
+            const QStringList wh = parser.value(QStringLiteral("size")).split(QLatin1Char('x'));
+            bool ok = wh.size() == 2;
+            bool ok2 = ok;
+            if (ok)
+                size = QSize(wh[0].toInt(&ok), wh[1].toInt(&ok2));
+            if (!ok || !ok2 || size.isEmpty()) {
+                qCritical() << "Error: --size needs a size like 800x600.";
+                return -1;
+            }
+        }
+        return batchExport(urls, parser.values(QStringLiteral("export-to")), parser.value(QStringLiteral("output-dir")), jobs, size);
     } else {
         if (parser.isSet(QStringLiteral("outfile"))) {
             qCritical() << "Error: --outfile specified without convert-to-native.";
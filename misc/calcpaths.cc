@@ -28,40 +28,61 @@
 
 #define NEWCALCPATH
 #ifdef NEWCALCPATH
-void localdfs(ObjectCalcer *obj, std::vector<ObjectCalcer *> &visited, std::vector<ObjectCalcer *> &all);
+void localdfs(ObjectCalcer *obj, std::set<ObjectCalcer *> &visited, std::vector<ObjectCalcer *> &all);
 
 std::vector<ObjectCalcer *> calcPath(const std::vector<ObjectCalcer *> &os)
 {
-    // "all" is the Objects var we're building, in reverse ordering
-    std::vector<ObjectCalcer *> visited;
+    // "all" is the Objects var we're building, in reverse ordering.
+    // visited and wanted are sets, so that this stays fast when
+    // thousands of objects are added at once..
+    std::set<ObjectCalcer *> visited;
     std::vector<ObjectCalcer *> all;
 
     for (std::vector<ObjectCalcer *>::const_iterator i = os.begin(); i != os.end(); ++i) {
-        if (std::find(visited.begin(), visited.end(), *i) == visited.end()) {
+        if (visited.find(*i) == visited.end()) {
             localdfs(*i, visited, all);
         }
     }
 
     // now, we need to remove all objects that are not in os
     // (forgot to do this in previous fix :-( )
+    const std::set<ObjectCalcer *> wanted(os.begin(), os.end());
     std::vector<ObjectCalcer *> ret;
     for (std::vector<ObjectCalcer *>::reverse_iterator i = all.rbegin(); i != all.rend(); ++i) {
         // we only add objects that appear in os
-        if (std::find(os.begin(), os.end(), *i) != os.end())
+        if (wanted.find(*i) != wanted.end())
             ret.push_back(*i);
     };
     return ret;
 }
 
-void localdfs(ObjectCalcer *obj, std::vector<ObjectCalcer *> &visited, std::vector<ObjectCalcer *> &all)
+void localdfs(ObjectCalcer *obj, std::set<ObjectCalcer *> &visited, std::vector<ObjectCalcer *> &all)
 {
-    visited.push_back(obj);
-    const std::vector<ObjectCalcer *> o = obj->children();
-    for (std::vector<ObjectCalcer *>::const_iterator i = o.begin(); i != o.end(); ++i) {
-        if (std::find(visited.begin(), visited.end(), *i) == visited.end())
-            localdfs(*i, visited, all);
+    // this used to recurse for every child, which overflows the stack
+    // on long chains of objects, like a million nested triangles.  We
+    // keep our own stack instead: every frame is an object, its
+    // children, and the next child to visit.  The objects end up in
+    // all in the same order as before..
+    struct Frame {
+        ObjectCalcer *obj;
+        std::vector<ObjectCalcer *> children;
+        std::vector<ObjectCalcer *>::size_type next;
+    };
+    std::vector<Frame> stack;
+    visited.insert(obj);
+    stack.push_back(Frame{obj, obj->children(), 0});
+    while (!stack.empty()) {
+        Frame &f = stack.back();
+        if (f.next == f.children.size()) {
+            all.push_back(f.obj);
+            stack.pop_back();
+            continue;
+        }
+        ObjectCalcer *child = f.children[f.next++];
+        // f is not used anymore after this, push_back may move it..
+        if (visited.insert(child).second)
+            stack.push_back(Frame{child, child->children(), 0});
     }
-    all.push_back(obj);
 }
 
 // old calcPath commented out...
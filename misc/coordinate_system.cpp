@@ -215,27 +215,20 @@ static double nicenum(double x, bool round)
     return nf * pow(10., exp);
 }
 
-void EuclideanCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) const
+Coordinate EuclideanCoords::gridInterval(const Rect &shown, double pixelwidth) const
 {
-    p.setWholeWinOverlay();
-
-    // this instruction in not necessary, but there is a little
-    // optimization when there are no grid and no axes.
-    if (!(showgrid || showaxes))
-        return;
-
     // this function is inspired upon ( public domain ) code from the
     // first Graphics Gems book.  Credits to Paul S. Heckbert, who wrote
     // the "Nice number for graph labels" gem.
 
-    const double hmax = ceil(p.window().right());
-    const double hmin = floor(p.window().left());
-    const double vmax = ceil(p.window().top());
-    const double vmin = floor(p.window().bottom());
+    const double hmax = ceil(shown.right());
+    const double hmin = floor(shown.left());
+    const double vmax = ceil(shown.top());
+    const double vmin = floor(shown.bottom());
 
     // the number of intervals we would like to have:
     // we try to have one of them per 40 pixels or so..
-    const int ntick = static_cast<int>(kigMax(hmax - hmin, vmax - vmin) / p.pixelWidth() / 40.) + 1;
+    const int ntick = static_cast<int>(kigMax(hmax - hmin, vmax - vmin) / pixelwidth / 40.) + 1;
 
     double hrange = nicenum(hmax - hmin, false);
     double vrange = nicenum(vmax - vmin, false);
@@ -243,8 +236,19 @@ void EuclideanCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) cons
     hrange = newrange;
     vrange = newrange;
 
-    const double hd = nicenum(hrange / (ntick - 1), true);
-    const double vd = nicenum(vrange / (ntick - 1), true);
+    return Coordinate(nicenum(hrange / (ntick - 1), true), nicenum(vrange / (ntick - 1), true));
+}
+
+void EuclideanCoords::drawGridLayer(KigPainter &p, const Rect &shown, bool showgrid, bool showaxes) const
+{
+    const Coordinate interval = gridInterval(shown, p.pixelWidth());
+    const double hd = interval.x;
+    const double vd = interval.y;
+
+    const double hmax = ceil(p.window().right());
+    const double hmin = floor(p.window().left());
+    const double vmax = ceil(p.window().top());
+    const double vmin = floor(p.window().bottom());
 
     const double hgraphmin = ceil(hmin / hd) * hd;
     const double hgraphmax = floor(hmax / hd) * hd;
@@ -292,31 +296,38 @@ void EuclideanCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) cons
                 continue;
             p.drawText(Rect(Coordinate(0, i), 2 * hd, vd).normalized(), currentLocale.toString(i, 'f', vnfrac), Qt::AlignBottom | Qt::AlignLeft);
         };
-        // arrows on the ends of the axes...
-        p.setPen(QPen(Qt::gray, 1, Qt::SolidLine));
-        p.setBrush(QBrush(Qt::gray));
-        std::vector<Coordinate> a;
-
-        // the arrow on the right end of the X axis...
-        a.reserve(3);
-        double u = p.pixelWidth();
-        a.push_back(Coordinate(hmax - 6 * u, -3 * u));
-        a.push_back(Coordinate(hmax, 0));
-        a.push_back(Coordinate(hmax - 6 * u, 3 * u));
-        p.drawArea(a);
-        //    p.drawPolygon( a, true );
-
-        // the arrow on the top end of the Y axis...
-        a.clear();
-        a.reserve(3);
-        a.push_back(Coordinate(3 * u, vmax - 6 * u));
-        a.push_back(Coordinate(0, vmax));
-        a.push_back(Coordinate(-3 * u, vmax - 6 * u));
-        p.drawArea(a);
-        //    p.drawPolygon( a, true );
     }; // if( showaxes )
 }
 
+void EuclideanCoords::drawAxesArrows(KigPainter &p) const
+{
+    const double hmax = ceil(p.window().right());
+    const double vmax = ceil(p.window().top());
+
+    // arrows on the ends of the axes...
+    p.setPen(QPen(Qt::gray, 1, Qt::SolidLine));
+    p.setBrush(QBrush(Qt::gray));
+    std::vector<Coordinate> a;
+
+    // the arrow on the right end of the X axis...
+    a.reserve(3);
+    double u = p.pixelWidth();
+    a.push_back(Coordinate(hmax - 6 * u, -3 * u));
+    a.push_back(Coordinate(hmax, 0));
+    a.push_back(Coordinate(hmax - 6 * u, 3 * u));
+    p.drawArea(a);
+    //    p.drawPolygon( a, true );
+
+    // the arrow on the top end of the Y axis...
+    a.clear();
+    a.reserve(3);
+    a.push_back(Coordinate(3 * u, vmax - 6 * u));
+    a.push_back(Coordinate(0, vmax));
+    a.push_back(Coordinate(-3 * u, vmax - 6 * u));
+    p.drawArea(a);
+    //    p.drawPolygon( a, true );
+}
+
 QString EuclideanCoords::coordinateFormatNotice() const
 {
     return i18n(
@@ -343,6 +354,20 @@ CoordinateSystem::CoordinateSystem()
 {
 }
 
+void CoordinateSystem::drawGrid(KigPainter &p, bool showgrid, bool showaxes) const
+{
+    p.setWholeWinOverlay();
+
+    // this instruction in not necessary, but there is a little
+    // optimization when there are no grid and no axes.
+    if (!(showgrid || showaxes))
+        return;
+
+    drawGridLayer(p, p.window(), showgrid, showaxes);
+    if (showaxes)
+        drawAxesArrows(p);
+}
+
 PolarCoords::PolarCoords()
 {
 }
@@ -407,33 +432,38 @@ Coordinate PolarCoords::toScreen(const QString &s, bool &ok) const
         return Coordinate();
 }
 
-void PolarCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) const
+Coordinate PolarCoords::gridInterval(const Rect &shown, double pixelwidth) const
 {
-    p.setWholeWinOverlay();
-
-    // this instruction in not necessary, but there is a little
-    // optimization when there are no grid and no axes.
-    if (!(showgrid || showaxes))
-        return;
-
     // we multiply by sqrt( 2 ) cause we don't want to miss circles in
     // the corners, that intersect with the axes outside of the
     // screen..
 
-    const double hmax = M_SQRT2 * p.window().right();
-    const double hmin = M_SQRT2 * p.window().left();
-    const double vmax = M_SQRT2 * p.window().top();
-    const double vmin = M_SQRT2 * p.window().bottom();
+    const double hmax = M_SQRT2 * shown.right();
+    const double hmin = M_SQRT2 * shown.left();
+    const double vmax = M_SQRT2 * shown.top();
+    const double vmin = M_SQRT2 * shown.bottom();
 
     // the intervals:
     // we try to have one of them per 40 pixels or so..
-    const int ntick = static_cast<int>(kigMax(hmax - hmin, vmax - vmin) / p.pixelWidth() / 40) + 1;
+    const int ntick = static_cast<int>(kigMax(hmax - hmin, vmax - vmin) / pixelwidth / 40) + 1;
 
     const double hrange = nicenum(hmax - hmin, false);
     const double vrange = nicenum(vmax - vmin, false);
 
-    const double hd = nicenum(hrange / (ntick - 1), true);
-    const double vd = nicenum(vrange / (ntick - 1), true);
+    return Coordinate(nicenum(hrange / (ntick - 1), true), nicenum(vrange / (ntick - 1), true));
+}
+
+void PolarCoords::drawGridLayer(KigPainter &p, const Rect &shown, bool showgrid, bool showaxes) const
+{
+    const Coordinate interval = gridInterval(shown, p.pixelWidth());
+    const double hd = interval.x;
+    const double vd = interval.y;
+
+    const Rect window = p.window();
+    const double hmax = M_SQRT2 * window.right();
+    const double hmin = M_SQRT2 * window.left();
+    const double vmax = M_SQRT2 * window.top();
+    const double vmin = M_SQRT2 * window.bottom();
 
     const double hgraphmin = floor(hmin / hd) * hd;
     const double hgraphmax = ceil(hmax / hd) * hd;
@@ -446,18 +476,25 @@ void PolarCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) const
 
     /****** the grid lines ******/
     if (showgrid) {
-        double d = kigMin(hd, vd);
-        double begin = kigMin(kigAbs(hgraphmin), kigAbs(vgraphmin));
-        if (kigSgn(hgraphmin) != kigSgn(hgraphmax) && kigSgn(vgraphmin) != kigSgn(vgraphmax))
-            begin = d;
-        double end = kigMax(hgraphmax, vgraphmax);
-
-        // we also want the circles that don't fit entirely in the
-        // screen..
+        // we never draw the circles closer than a few pixels to each
+        // other, and only the ones that go through the window: when
+        // zooming in on a small part of the document far from the
+        // origin, we used to draw millions of circles, which blocked
+        // Kig..
+        double d = kigMax(kigMin(hd, vd), 10 * p.pixelWidth());
+
+        const double dx = window.left() > 0 ? window.left() : (window.right() < 0 ? -window.right() : 0);
+        const double dy = window.bottom() > 0 ? window.bottom() : (window.top() < 0 ? -window.top() : 0);
+        const double rmin = sqrt(dx * dx + dy * dy);
+        const double rmax = kigMax(kigMax(window.topLeft().length(), window.topRight().length()),
+                                   kigMax(window.bottomLeft().length(), window.bottomRight().length()));
+
+        double begin = kigMax(ceil(rmin / d), 1.) * d;
+
         Coordinate c(0, 0);
         p.setPen(QPen(Qt::lightGray, 0, Qt::DotLine));
-        for (double i = begin; i <= end + d / 2; i += d)
-            drawGridLine(p, c, fabs(i));
+        for (double i = begin; i <= rmax + d / 2; i += d)
+            drawGridLine(p, c, i);
     }
 
     /****** the axes ******/
@@ -491,31 +528,38 @@ void PolarCoords::drawGrid(KigPainter &p, bool showgrid, bool showaxes) const
 
             p.drawText(Rect(Coordinate(0, i), hd, vd).normalized(), is, Qt::AlignBottom | Qt::AlignLeft);
         };
-        // arrows on the ends of the axes...
-        p.setPen(QPen(Qt::gray, 1, Qt::SolidLine));
-        p.setBrush(QBrush(Qt::gray));
-        std::vector<Coordinate> a;
-
-        // the arrow on the right end of the X axis...
-        a.reserve(3);
-        double u = p.pixelWidth();
-        a.push_back(Coordinate(hmax - 6 * u, -3 * u));
-        a.push_back(Coordinate(hmax, 0));
-        a.push_back(Coordinate(hmax - 6 * u, 3 * u));
-        //    p.drawPolygon( a, true );
-        p.drawArea(a);
-
-        // the arrow on the top end of the Y axis...
-        a.clear();
-        a.reserve(3);
-        a.push_back(Coordinate(3 * u, vmax - 6 * u));
-        a.push_back(Coordinate(0, vmax));
-        a.push_back(Coordinate(-3 * u, vmax - 6 * u));
-        //    p.drawPolygon( a, true );
-        p.drawArea(a);
     }; // if( showaxes )
 }
 
+void PolarCoords::drawAxesArrows(KigPainter &p) const
+{
+    const double hmax = M_SQRT2 * p.window().right();
+    const double vmax = M_SQRT2 * p.window().top();
+
+    // arrows on the ends of the axes...
+    p.setPen(QPen(Qt::gray, 1, Qt::SolidLine));
+    p.setBrush(QBrush(Qt::gray));
+    std::vector<Coordinate> a;
+
+    // the arrow on the right end of the X axis...
+    a.reserve(3);
+    double u = p.pixelWidth();
+    a.push_back(Coordinate(hmax - 6 * u, -3 * u));
+    a.push_back(Coordinate(hmax, 0));
+    a.push_back(Coordinate(hmax - 6 * u, 3 * u));
+    //    p.drawPolygon( a, true );
+    p.drawArea(a);
+
+    // the arrow on the top end of the Y axis...
+    a.clear();
+    a.reserve(3);
+    a.push_back(Coordinate(3 * u, vmax - 6 * u));
+    a.push_back(Coordinate(0, vmax));
+    a.push_back(Coordinate(-3 * u, vmax - 6 * u));
+    //    p.drawPolygon( a, true );
+    p.drawArea(a);
+}
+
 QValidator *EuclideanCoords::coordinateValidator() const
 {
     return new CoordinateValidator(CoordinateValidator::Euclidean);
@@ -623,30 +667,10 @@ Coordinate EuclideanCoords::snapToGrid(const Coordinate &c, const KigWidget &w)
 
 Coordinate PolarCoords::snapToGrid(const Coordinate &c, const KigWidget &w) const
 {
-    // we reuse the drawGrid code to find
-
-    // we multiply by sqrt( 2 ) cause we don't want to miss circles in
-    // the corners, that intersect with the axes outside of the
-    // screen..
-
-    Rect r = w.showingRect();
-
-    const double hmax = M_SQRT2 * r.right();
-    const double hmin = M_SQRT2 * r.left();
-    const double vmax = M_SQRT2 * r.top();
-    const double vmin = M_SQRT2 * r.bottom();
-
-    // the intervals:
-    // we try to have one of them per 40 pixels or so..
-    const int ntick = static_cast<int>(kigMax(hmax - hmin, vmax - vmin) / w.pixelWidth() / 40) + 1;
-
-    const double hrange = nicenum(hmax - hmin, false);
-    const double vrange = nicenum(vmax - vmin, false);
-
-    const double hd = nicenum(hrange / (ntick - 1), true);
-    const double vd = nicenum(vrange / (ntick - 1), true);
-
-    double d = kigMin(hd, vd);
+    // we reuse the drawGrid code to find the distance between the
+    // circles..
+    const Coordinate interval = gridInterval(w.showingRect(), w.pixelWidth());
+    double d = kigMin(interval.x, interval.y);
 
     double dist = c.length();
     double ndist = qRound(dist / d) * d;
@@ -655,65 +679,40 @@ Coordinate PolarCoords::snapToGrid(const Coordinate &c, const KigWidget &w) cons
 
 void PolarCoords::drawGridLine(KigPainter &p, const Coordinate &c, double r) const
 {
-#ifdef KIG_TESSELLATE_POLAR_GRID_CIRCLE
     Rect rect = p.window();
+    if (r < rect.width() + rect.height()) {
+        p.drawCircle(c, r);
+        return;
+    }
 
-    struct iterdata_t {
-        int xd;
-        int yd;
-        Coordinate (Rect::*point)() const;
-        Coordinate (Rect::*oppositepoint)() const;
-        double horizAngle;
-        double vertAngle;
-    };
+    // the circle is a lot larger than the window, so it can only go
+    // through it if the center is outside the window.  Stroking the
+    // entire (dotted) circle is very slow in that case, so we only draw
+    // the arc that we can see, as a polyline..
+    if (rect.contains(c))
+        return;
 
-    static const iterdata_t iterdata[] = {{+1, +1, &Rect::topRight, &Rect::bottomLeft, 0, M_PI / 2},
-                                          {-1, +1, &Rect::topLeft, &Rect::bottomRight, M_PI, M_PI / 2},
-                                          {-1, -1, &Rect::bottomLeft, &Rect::topRight, M_PI, 3 * M_PI / 2},
-                                          {+1, -1, &Rect::bottomRight, &Rect::topLeft, 2 * M_PI, 3 * M_PI / 2}};
+    const Coordinate mid = rect.center() - c;
+    const double midangle = atan2(mid.y, mid.x);
+    const Coordinate corners[] = {rect.topLeft(), rect.topRight(), rect.bottomLeft(), rect.bottomRight()};
+    double minangle = 0;
+    double maxangle = 0;
     for (int i = 0; i < 4; ++i) {
-        int xd = iterdata[i].xd;
-        int yd = iterdata[i].yd;
-        Coordinate point = (rect.*iterdata[i].point)();
-        Coordinate opppoint = (rect.*iterdata[i].oppositepoint)();
-        double horizangle = iterdata[i].horizAngle;
-        double vertangle = iterdata[i].vertAngle;
-
-        if ((c.x - point.x) * xd > 0 || (c.y - point.y) * yd > 0)
-            continue;
-        if ((c.x - opppoint.x) * -xd > r || (c.y - opppoint.y) * -yd > r)
-            continue;
-
-        int posdir = xd * yd;
-        double hd = (point.x - c.x) * xd;
-        assert(hd >= 0);
-        if (hd < r) {
-            double anglediff = acos(hd / r);
-            horizangle += posdir * anglediff;
-        }
-
-        hd = (c.x - opppoint.x) * -xd;
-        if (hd >= 0) {
-            double anglediff = asin(hd / r);
-            vertangle -= posdir * anglediff;
-        }
-
-        double vd = (point.y - c.y) * yd;
-        assert(vd >= 0);
-        if (vd < r) {
-            double anglediff = acos(vd / r);
-            vertangle -= posdir * anglediff;
-        }
-
-        vd = (c.y - opppoint.y) * -xd;
-        if (vd >= 0) {
-            double anglediff = asin(hd / r);
-            horizangle += posdir * anglediff;
-        }
+        const Coordinate v = corners[i] - c;
+        const double a = remainder(atan2(v.y, v.x) - midangle, 2 * M_PI);
+        minangle = kigMin(minangle, a);
+        maxangle = kigMax(maxangle, a);
+    }
 
-        p.drawArc(c, r, kigMin(horizangle, vertangle), kigMax(horizangle, vertangle));
+    // the step is such that the arc is never further than half a pixel
+    // away from the polyline..
+    const double step = sqrt(2 * p.pixelWidth() / r);
+    const int n = static_cast<int>(ceil((maxangle - minangle) / step)) + 1;
+    std::vector<Coordinate> pts;
+    pts.reserve(n + 1);
+    for (int i = 0; i <= n; ++i) {
+        const double a = midangle + minangle + (maxangle - minangle) * i / n;
+        pts.push_back(c + r * Coordinate(cos(a), sin(a)));
     }
-#else
-    p.drawCircle(c, r);
-#endif
+    p.drawPolyline(pts);
 }
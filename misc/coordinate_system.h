@@ -16,6 +16,7 @@ class CoordinateSystem;
 class QValidator;
 class Coordinate;
 class QString;
+class Rect;
 
 /**
  * a factory to build a CoordinateSystem and a small handle to the
@@ -63,7 +64,29 @@ public:
      */
     virtual QString coordinateFormatNoticeMarkup() const = 0;
     virtual Coordinate toScreen(const QString &pt, bool &ok) const = 0;
-    virtual void drawGrid(KigPainter &p, bool showgrid = true, bool showaxes = true) const = 0;
+    /**
+     * draw the grid and the axes on \p p.  This is drawGridLayer()
+     * followed by drawAxesArrows() for the window of \p p.
+     */
+    void drawGrid(KigPainter &p, bool showgrid = true, bool showaxes = true) const;
+    /**
+     * draw the grid lines, the axes and their labels, with the
+     * intervals that fit the rect \p shown.  The window of \p p may
+     * be larger than \p shown, so that KigWidget can keep the result
+     * in a cache, and reuse it when the view is scrolled.
+     */
+    virtual void drawGridLayer(KigPainter &p, const Rect &shown, bool showgrid, bool showaxes) const = 0;
+    /**
+     * draw the arrows at the ends of the axes.  They stick to the
+     * border of the window of \p p, so they are not part of the grid
+     * layer...
+     */
+    virtual void drawAxesArrows(KigPainter &p) const = 0;
+    /**
+     * the horizontal and vertical distance between two grid lines or
+     * labels when showing the rect \p shown...
+     */
+    virtual Coordinate gridInterval(const Rect &shown, double pixelwidth) const = 0;
     virtual QValidator *coordinateValidator() const = 0;
     virtual Coordinate snapToGrid(const Coordinate &c, const KigWidget &w) const = 0;
 
@@ -80,7 +103,9 @@ public:
     QString coordinateFormatNotice() const override;
     QString coordinateFormatNoticeMarkup() const override;
     Coordinate toScreen(const QString &pt, bool &ok) const override;
-    void drawGrid(KigPainter &p, bool showgrid = true, bool showaxes = true) const override;
+    void drawGridLayer(KigPainter &p, const Rect &shown, bool showgrid, bool showaxes) const override;
+    void drawAxesArrows(KigPainter &p) const override;
+    Coordinate gridInterval(const Rect &shown, double pixelwidth) const override;
     QValidator *coordinateValidator() const override;
     Coordinate snapToGrid(const Coordinate &c, const KigWidget &w) const override;
 
@@ -99,7 +124,9 @@ public:
     QString coordinateFormatNotice() const override;
     QString coordinateFormatNoticeMarkup() const override;
     Coordinate toScreen(const QString &pt, bool &ok) const override;
-    void drawGrid(KigPainter &p, bool showgrid = true, bool showaxes = true) const override;
+    void drawGridLayer(KigPainter &p, const Rect &shown, bool showgrid, bool showaxes) const override;
+    void drawAxesArrows(KigPainter &p) const override;
+    Coordinate gridInterval(const Rect &shown, double pixelwidth) const override;
     QValidator *coordinateValidator() const override;
     Coordinate snapToGrid(const Coordinate &c, const KigWidget &w) const override;
 
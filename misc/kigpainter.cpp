@@ -17,10 +17,17 @@
 #include "conic-common.h"
 #include "coordinate_system.h"
 #include "cubic-common.h"
+#include "kigprofiler.h"
+#include "kigtracer.h"
 #include "object_hierarchy.h"
 
+#include <QCoreApplication>
 #include <QPen>
+#include <QPixmapCache>
+#include <QThread>
 #include <QPolygon>
+#include <QStaticText>
+#include <QtMath>
 #include <QTransform>
 
 #include <algorithm>
@@ -45,8 +52,9 @@ KigPainter::KigPainter(const ScreenInfo &si, QPaintDevice *device, const KigDocu
     , mNeedOverlay(no)
     , overlayenlarge(0)
     , mSelected(false)
+    , mBatchPoints(false)
 {
-    mP.setBackground(QBrush(Qt::white));
+    mP.setBackground(QBrush(backgroundColor(doc.getNightVision())));
 }
 
 KigPainter::~KigPainter()
@@ -59,14 +67,14 @@ void KigPainter::drawRect(const Rect &r)
     QRect qr = toScreen(rt).normalized();
     mP.drawRect(qr);
     if (mNeedOverlay)
-        mOverlay.push_back(qr);
+        addOverlay(qr);
 }
 
 void KigPainter::drawRect(const QRect &r)
 {
     mP.drawRect(r);
     if (mNeedOverlay)
-        mOverlay.push_back(r);
+        addOverlay(r);
 }
 
 void KigPainter::drawCircle(const Coordinate &center, double radius)
@@ -88,88 +96,158 @@ void KigPainter::drawSegment(const Coordinate &from, const Coordinate &to)
         segmentOverlay(from, to);
 }
 
-void KigPainter::drawFatPoint(const Coordinate &p)
-{
-    int twidth = width == -1 ? 5 : width;
-    mP.setPen(QPen(color, 1, style));
-    switch (pointstyle) {
-    case Kig::Round: {
-        double radius = twidth * pixelWidth();
-        setBrushStyle(Qt::SolidPattern);
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
-        mP.drawEllipse(qr);
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+/**
+ * draw a fat point of style ps in the rect qr...  This is used both to
+ * draw a point directly, and to render the sprites of batched points.
+ */
+static void drawPointShape(QPainter &p, const QRect &qr, Kig::PointStyle ps, const QColor &color, const QColor &brushcolor, Qt::PenStyle style)
+{
+    p.setPen(QPen(color, 1, style));
+    switch (ps) {
+    case Kig::Round:
+        p.setBrush(QBrush(brushcolor, Qt::SolidPattern));
+        p.drawEllipse(qr);
         break;
-    }
-    case Kig::RoundEmpty: {
-        double radius = twidth * pixelWidth();
-        setBrushStyle(Qt::NoBrush);
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
-        mP.drawEllipse(qr);
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+    case Kig::RoundEmpty:
+        p.setBrush(Qt::NoBrush);
+        p.drawEllipse(qr);
         break;
-    }
-    case Kig::Rectangular: {
-        double radius = twidth * pixelWidth();
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
-        mP.drawRect(qr);
-        mP.fillRect(qr, QBrush(color, Qt::SolidPattern));
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+    case Kig::Rectangular:
+        p.setBrush(Qt::NoBrush);
+        p.drawRect(qr);
+        p.fillRect(qr, QBrush(color, Qt::SolidPattern));
         break;
-    }
-    case Kig::RectangularEmpty: {
-        double radius = twidth * pixelWidth();
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
-        mP.drawRect(qr);
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+    case Kig::RectangularEmpty:
+        p.setBrush(Qt::NoBrush);
+        p.drawRect(qr);
         break;
-    }
-    case Kig::Cross: {
-        double radius = twidth * pixelWidth();
-        Coordinate rad(radius, radius);
-        rad /= 2;
-        Coordinate tl = p - rad;
-        Coordinate br = p + rad;
-        Rect r(tl, br);
-        QRect qr = toScreen(r);
-        mP.setPen(QPen(color, 2));
-        mP.drawLine(qr.topLeft(), qr.bottomRight());
-        mP.drawLine(qr.topRight(), qr.bottomLeft());
-        if (mNeedOverlay)
-            mOverlay.push_back(qr);
+    case Kig::Cross:
+        p.setPen(QPen(color, 2));
+        p.drawLine(qr.topLeft(), qr.bottomRight());
+        p.drawLine(qr.topRight(), qr.bottomLeft());
         break;
-    }
-    default: {
+    default:
         break;
     }
-    }
+}
+
+bool KigPainter::PointBatchKey::operator<(const PointBatchKey &rhs) const
+{
+    if (pointstyle != rhs.pointstyle)
+        return pointstyle < rhs.pointstyle;
+    if (color != rhs.color)
+        return color < rhs.color;
+    if (brushcolor != rhs.brushcolor)
+        return brushcolor < rhs.brushcolor;
+    if (style != rhs.style)
+        return style < rhs.style;
+    if (size.width() != rhs.size.width())
+        return size.width() < rhs.size.width();
+    return size.height() < rhs.size.height();
+}
+
+void KigPainter::drawFatPoint(const Coordinate &p)
+{
+    int twidth = width == -1 ? 5 : width;
+    double radius = twidth * pixelWidth();
+    Coordinate rad(radius, radius);
+    rad /= 2;
+    Coordinate tl = p - rad;
+    Coordinate br = p + rad;
+    Rect r(tl, br);
+    QRect qr = toScreen(r);
+
+    if (pointstyle == Kig::Round)
+        brushStyle = Qt::SolidPattern;
+    else if (pointstyle == Kig::RoundEmpty)
+        brushStyle = Qt::NoBrush;
+
+    if (mBatchPoints) {
+        PointBatchKey key;
+        key.pointstyle = pointstyle;
+        key.color = color.rgba();
+        key.brushcolor = brushColor.rgba();
+        key.style = style;
+        key.size = qr.size();
+        mPointBatch[key].push_back(qr.topLeft());
+    } else
+        drawPointShape(mP, qr, pointstyle, color, brushColor, style);
+    if (mNeedOverlay)
+        addOverlay(qr);
+
+    mP.setBrush(QBrush(brushColor, brushStyle));
     mP.setPen(QPen(color, twidth, style));
 }
 
+void KigPainter::beginPointBatch()
+{
+    // sprites only make sense on raster devices, we don't want bitmaps
+    // in our SVG exports or print-outs..  The sprites are QPixmaps in
+    // QPixmapCache, which only work in the GUI thread, so the batch
+    // exports don't use them either.
+    const int type = mP.device() ? mP.device()->devType() : 0;
+    mBatchPoints = (type == QInternal::Pixmap || type == QInternal::Image) && QThread::currentThread() == QCoreApplication::instance()->thread();
+}
+
+void KigPainter::endPointBatch()
+{
+    flushPointBatch();
+    mBatchPoints = false;
+}
+
+void KigPainter::flushPointBatch()
+{
+    if (mPointBatch.empty())
+        return;
+    // the batched points only queue themselves when they are drawn, the
+    // painting happens here..
+    KigProfiler::Scope prof(PointImp::stype());
+
+    // the margin around the point in the sprites, for the border and the
+    // width of the lines of a cross..
+    static const int margin = 2;
+
+    QPen oldpen = mP.pen();
+    QBrush oldbrush = mP.brush();
+    QVector<QPainter::PixmapFragment> fragments;
+    for (std::map<PointBatchKey, std::vector<QPoint>>::const_iterator i = mPointBatch.begin(); i != mPointBatch.end(); ++i) {
+        const PointBatchKey &key = i->first;
+        const QString cachekey = QStringLiteral("kig-point-%1-%2-%3-%4-%5x%6")
+                                     .arg(key.pointstyle)
+                                     .arg(key.color)
+                                     .arg(key.brushcolor)
+                                     .arg(key.style)
+                                     .arg(key.size.width())
+                                     .arg(key.size.height());
+        QPixmap sprite;
+        if (!QPixmapCache::find(cachekey, &sprite)) {
+            sprite = QPixmap(key.size + QSize(2 * margin, 2 * margin));
+            sprite.fill(Qt::transparent);
+            QPainter sp(&sprite);
+            drawPointShape(sp,
+                           QRect(QPoint(margin, margin), key.size),
+                           key.pointstyle,
+                           QColor::fromRgba(key.color),
+                           QColor::fromRgba(key.brushcolor),
+                           key.style);
+            sp.end();
+            QPixmapCache::insert(cachekey, sprite);
+        }
+
+        // drawPixmapFragments() takes the centers of the fragments..
+        const QPointF offset(sprite.width() / 2. - margin, sprite.height() / 2. - margin);
+        const QRectF source(sprite.rect());
+        fragments.clear();
+        fragments.reserve(i->second.size());
+        for (std::vector<QPoint>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+            fragments.append(QPainter::PixmapFragment::create(QPointF(*j) + offset, source));
+        mP.drawPixmapFragments(fragments.constData(), fragments.size(), sprite);
+    }
+    mPointBatch.clear();
+    mP.setPen(oldpen);
+    mP.setBrush(oldbrush);
+}
+
 void KigPainter::drawPoint(const Coordinate &p)
 {
     mP.drawPoint(toScreen(p));
@@ -199,7 +277,7 @@ void KigPainter::textOverlay(const QRect &r, const QString &s, int textFlags)
     QRect newr(mP.boundingRect(r, textFlags, s));
     newr.setWidth(newr.width() + 4);
     newr.setHeight(newr.height() + 4);
-    mOverlay.push_back(newr);
+    addOverlay(newr);
 }
 
 const Rect KigPainter::boundingRect(const Rect &r, const QString &s, int f) const
@@ -267,11 +345,21 @@ void KigPainter::setFont(const QFont &f)
     mP.setFont(f);
 }
 
+const QFont &KigPainter::font() const
+{
+    return mP.font();
+}
+
 bool KigPainter::getNightVision() const
 {
     return mdoc.getNightVision();
 }
 
+QColor KigPainter::backgroundColor(bool)
+{
+    return Qt::white;
+}
+
 QColor KigPainter::getColor() const
 {
     return color;
@@ -315,7 +403,20 @@ void KigPainter::drawPolygon(const std::vector<QPoint> &pts, Qt::FillRule fillRu
     setBrush(oldbrush);
     unsetSelected();
     if (mNeedOverlay)
-        mOverlay.push_back(t.boundingRect());
+        addOverlay(t.boundingRect());
+}
+
+void KigPainter::drawPolyline(const std::vector<Coordinate> &pts)
+{
+    QPolygon t(pts.size());
+    int c = 0;
+    for (std::vector<Coordinate>::const_iterator i = pts.begin(); i != pts.end(); ++i) {
+        QPoint p = toScreen(*i);
+        t.putPoints(c++, 1, p.x(), p.y());
+    }
+    mP.drawPolyline(t);
+    if (mNeedOverlay)
+        addOverlay(t.boundingRect().adjusted(-overlayenlarge - 1, -overlayenlarge - 1, overlayenlarge + 1, overlayenlarge + 1));
 }
 
 void KigPainter::drawArea(const std::vector<Coordinate> &pts, bool border)
@@ -337,7 +438,7 @@ void KigPainter::drawArea(const std::vector<Coordinate> &pts, bool border)
     setPen(oldpen);
     setBrush(oldbrush);
     if (mNeedOverlay)
-        mOverlay.push_back(t.boundingRect());
+        addOverlay(t.boundingRect());
 }
 
 Rect KigPainter::window()
@@ -396,7 +497,7 @@ void KigPainter::circleOverlayRecurse(const Coordinate &centre, double radiussq,
     // the rect contains some of the circle
     // -> if it's small enough, we keep it
     if (currentRect.width() < overlayRectSize()) {
-        mOverlay.push_back(toScreenEnlarge(currentRect));
+        addOverlay(toScreenEnlarge(currentRect));
     } else {
         // this func works recursive: we subdivide the current rect, and if
         // it is of a good size, we keep it, otherwise we handle it again
@@ -441,7 +542,7 @@ void KigPainter::segmentOverlay(const Coordinate &p1, const Coordinate &p2)
         length = fabs(p3.y);
     if (length < pixelWidth()) {
         // hopefully prevent SIGZERO's
-        mOverlay.push_back(toScreen(Rect(p1, p2)));
+        addOverlay(toScreen(Rect(p1, p2)));
         return;
     };
     p3 *= overlayRectSize();
@@ -460,7 +561,7 @@ void KigPainter::segmentOverlay(const Coordinate &p1, const Coordinate &p2)
             break;
         }
         if (tR.intersects(border))
-            mOverlay.push_back(toScreenEnlarge(tR));
+            addOverlay(toScreenEnlarge(tR));
         if (++counter > 100) {
             qDebug() << "counter got too big :( ";
             break;
@@ -468,6 +569,65 @@ void KigPainter::segmentOverlay(const Coordinate &p1, const Coordinate &p2)
     }
 }
 
+/**
+ * merging two overlay rects is worth it when their union isn't larger
+ * than the two rects plus this number of pixels: blitting one rect
+ * costs about the same as copying this many pixels more...
+ */
+static const int overlayMergeSlack = 1024;
+/**
+ * never keep more than this many rects in an overlay...
+ */
+static const uint maxOverlayRects = 32;
+
+static inline qint64 rectArea(const QRect &r)
+{
+    return static_cast<qint64>(r.width()) * r.height();
+}
+
+void KigPainter::mergeOverlay(std::vector<QRect> &overlay, const QRect &r)
+{
+    if (r.isEmpty())
+        return;
+    QRect n = r;
+    // merge n with all the rects that it (or the union we get) is close
+    // enough to.  This also drops the rects that are already covered..
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (std::vector<QRect>::iterator i = overlay.begin(); i != overlay.end(); ++i) {
+            QRect u = *i | n;
+            if (rectArea(u) <= rectArea(*i) + rectArea(n) + overlayMergeSlack) {
+                n = u;
+                overlay.erase(i);
+                merged = true;
+                break;
+            }
+        }
+    }
+    if (overlay.size() >= maxOverlayRects) {
+        // we have too many rects already, so we merge n with the one that
+        // grows the least by it..
+        std::vector<QRect>::iterator best = overlay.begin();
+        qint64 bestcost = rectArea(*best | n) - rectArea(*best);
+        for (std::vector<QRect>::iterator i = best + 1; i != overlay.end(); ++i) {
+            qint64 cost = rectArea(*i | n) - rectArea(*i);
+            if (cost < bestcost) {
+                best = i;
+                bestcost = cost;
+            }
+        }
+        n |= *best;
+        overlay.erase(best);
+    }
+    overlay.push_back(n);
+}
+
+void KigPainter::addOverlay(const QRect &r)
+{
+    mergeOverlay(mOverlay, r);
+}
+
 double KigPainter::overlayRectSize()
 {
     return 20 * pixelWidth();
@@ -482,7 +642,7 @@ void KigPainter::pointOverlay(const Coordinate &p1)
 {
     Rect r(p1, 3 * pixelWidth(), 3 * pixelWidth());
     r.setCenter(p1);
-    mOverlay.push_back(toScreen(r));
+    addOverlay(toScreen(r));
 }
 
 double KigPainter::pixelWidth()
@@ -516,6 +676,10 @@ void KigPainter::drawGrid(const CoordinateSystem &c, bool showGrid, bool showAxe
 
 void KigPainter::drawObject(const ObjectHolder *o, bool ss)
 {
+    // the batched points have to be drawn before the next object that
+    // isn't a point, or they would end up on top of it..
+    if (!mPointBatch.empty() && !o->imp()->inherits(PointImp::stype()))
+        flushPointBatch();
     o->draw(*this, ss);
 }
 
@@ -768,6 +932,7 @@ const double CurveImpPointCalcer::endinterval = 1.;
 
 void KigPainter::drawCurve(const CurveImp *curve)
 {
+    KigTracer::Span span("drawCurve", "paint");
     // we manage our own overlay
     bool tNeedOverlay = mNeedOverlay;
     mNeedOverlay = false;
@@ -802,8 +967,19 @@ void KigPainter::drawCurve(const CurveImp *curve)
     // final result).
     // First push the [0,1] interval into the stack:
 
-    Coordinate coo1 = curve->getPoint(0., mdoc);
-    Coordinate coo2 = curve->getPoint(1., mdoc);
+    // every multiple of 1/gridsize is always sampled, because the
+    // intervals are split until h < hmax, so we ask the curve for
+    // all of those in one go.  This matters for curves that are
+    // expensive to evaluate one point at a time, like loci through
+    // python scripts..
+    static const int gridsize = 32;
+    std::vector<double> gridparams;
+    for (int i = 0; i <= gridsize; ++i)
+        gridparams.push_back(static_cast<double>(i) / gridsize);
+    const std::vector<Coordinate> grid = curve->getPoints(gridparams, mdoc);
+
+    Coordinate coo1 = grid.front();
+    Coordinate coo2 = grid.back();
     workstack.push(workitem(coordparampair(0., coo1), coordparampair(1., coo2), nullptr));
 
     // maxlength is the square of the maximum size that we allow
@@ -864,7 +1040,8 @@ void KigPainter::drawCurve(const CurveImp *curve)
             //      }
 
             Rect *overlaypt = curitem.overlay;
-            Coordinate p2 = curve->getPoint(t2, mdoc);
+            const double gridt2 = t2 * gridsize;
+            Coordinate p2 = gridt2 == std::floor(gridt2) ? grid[static_cast<int>(gridt2)] : curve->getPoint(t2, mdoc);
             bool allvalid = p2.valid() && valid0 && valid1;
             bool dooverlay =
                 !overlaypt && h < hmaxoverlay && valid0 && valid1 && fabs(p0.x - p1.x) <= overlayRectSize() && fabs(p0.y - p1.y) <= overlayRectSize();
@@ -923,12 +1100,46 @@ void KigPainter::drawCurve(const CurveImp *curve)
             Rect overlay = overlaystack.top();
             overlaystack.pop();
             if (overlay.intersects(border))
-                mOverlay.push_back(toScreenEnlarge(overlay));
+                addOverlay(toScreenEnlarge(overlay));
         }
     }
     mNeedOverlay = tNeedOverlay;
 }
 
+const Rect KigPainter::drawTextFrame(const Coordinate &c, QStaticText &layout, bool needframe)
+{
+    QPoint tl = toScreen(c);
+    // like in simpleBoundingRect(), the text is wrapped at the right
+    // border of the window.  Text that fits is not touched, otherwise
+    // the width is rounded down to a multiple of 32 pixels, so that
+    // dragging the text around only redoes the layout now and then..
+    const int available = toScreen(window()).right() - tl.x();
+    if (layout.textWidth() >= 0 || layout.size().width() > available) {
+        const qreal textwidth = qMax(32, available - available % 32);
+        if (layout.textWidth() != textwidth)
+            layout.setTextWidth(textwidth);
+    }
+    QSizeF ts = layout.size();
+    QRect qr(tl, QSize(qCeil(ts.width()) + 4, qCeil(ts.height()) + 4));
+    Rect frame = fromScreen(qr);
+    QPen oldpen = mP.pen();
+    QBrush oldbrush = mP.brush();
+    if (needframe) {
+        setPen(QPen(Qt::black, 1));
+        setBrush(QBrush(QColor(255, 255, 222)));
+        mP.drawRect(qr);
+        setPen(QPen(QColor(197, 194, 197), 1, Qt::SolidLine));
+        mP.drawLine(qr.topLeft(), qr.topRight());
+        mP.drawLine(qr.topLeft(), qr.bottomLeft());
+    };
+    setPen(oldpen);
+    setBrush(oldbrush);
+    mP.drawStaticText(tl + QPoint(2, 2), layout);
+    if (mNeedOverlay)
+        addOverlay(qr.adjusted(0, 0, 1, 1));
+    return frame;
+}
+
 void KigPainter::drawTextFrame(const Rect &frame, const QString &s, bool needframe)
 {
     QPen oldpen = mP.pen();
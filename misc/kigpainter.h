@@ -16,9 +16,11 @@
 #include <QFont>
 #include <QPainter>
 
+#include <map>
 #include <vector>
 
 class KigWidget;
+class QStaticText;
 class QPaintDevice;
 class CoordinateSystem;
 class LineData;
@@ -56,6 +58,23 @@ protected:
     int overlayenlarge;
     bool mSelected;
 
+    /**
+     * while drawing a batch of objects, drawFatPoint() doesn't draw the
+     * points, but collects them by style in mPointBatch.
+     * flushPointBatch() then draws all points with the same style at
+     * once, from a pre-rendered sprite.
+     */
+    struct PointBatchKey {
+        Kig::PointStyle pointstyle;
+        QRgb color;
+        QRgb brushcolor;
+        Qt::PenStyle style;
+        QSize size;
+        bool operator<(const PointBatchKey &rhs) const;
+    };
+    bool mBatchPoints;
+    std::map<PointBatchKey, std::vector<QPoint>> mPointBatch;
+
 public:
     /**
      * construct a new KigPainter:
@@ -95,12 +114,21 @@ public:
     void setBrushColor(const QColor &c);
 
     void setFont(const QFont &f);
+    const QFont &font() const;
 
     void setSelected(bool selected);
 
     QColor getColor() const;
     bool getNightVision() const;
 
+    /**
+     * the colour the paper is filled with in the given night vision
+     * state.  Night vision only reveals hidden objects, so this is
+     * white either way, but callers that cache drawn layers per state
+     * should fill them with this..
+     */
+    static QColor backgroundColor(bool nightvision);
+
     double pixelWidth();
 
     /**
@@ -120,10 +148,29 @@ public:
     template<typename iter>
     void drawObjects(iter begin, iter end, bool sel)
     {
+        beginPointBatch();
         for (; begin != end; ++begin)
             drawObject(*begin, sel);
+        endPointBatch();
     }
 
+    /**
+     * from now on, collect the points passed to drawFatPoint(), and
+     * draw them all at once in flushPointBatch()...  This only has an
+     * effect when painting on a pixmap or an image.
+     */
+    void beginPointBatch();
+    /**
+     * draw the points collected so far.  drawObject() calls this before
+     * it draws anything but a point, so that the points stay below the
+     * objects that come after them...
+     */
+    void flushPointBatch();
+    /**
+     * flush the points, and draw them directly again from now on...
+     */
+    void endPointBatch();
+
     /**
      * draw a generic curve...
      */
@@ -192,6 +239,11 @@ public:
     void drawPolygon(const std::vector<QPoint> &pts, Qt::FillRule fillRule = Qt::OddEvenFill);
     void drawPolygon(const std::vector<Coordinate> &pts, Qt::FillRule fillRule = Qt::OddEvenFill);
 
+    /**
+     * draw the open polyline through the points in pts...
+     */
+    void drawPolyline(const std::vector<Coordinate> &pts);
+
     /**
      * draw an area defined by the points in pts filled with the set
      * color...
@@ -232,6 +284,15 @@ public:
 
     void drawSimpleText(const Coordinate &c, const QString &s);
     void drawTextFrame(const Rect &frame, const QString &s, bool needframe);
+    /**
+     * draw the text of layout in a frame with its top left corner at c.
+     * This is like calling drawTextFrame() on simpleBoundingRect(), but
+     * the text doesn't need to be measured and laid out every time,
+     * only when the room left to the right of c changes.  Like
+     * simpleBoundingRect(), the text is wrapped at the border of the
+     * window.  Returns the frame.
+     */
+    const Rect drawTextFrame(const Coordinate &c, QStaticText &layout, bool needframe);
 
     const Rect boundingRect(const Rect &r, const QString &s, int f = 0) const;
 
@@ -246,6 +307,14 @@ public:
         return mOverlay;
     }
 
+    /**
+     * add r to the rects in overlay.  Instead of simply appending it,
+     * we merge it with the rects that are close to it, and we never
+     * keep more than a small number of rects, so that the widget
+     * doesn't need to copy thousands of tiny rects when updating...
+     */
+    static void mergeOverlay(std::vector<QRect> &overlay, const QRect &r);
+
 protected:
     /**
      * adds a number of rects to mOverlay so that the rects entirely
@@ -274,6 +343,11 @@ protected:
      */
     void textOverlay(const QRect &r, const QString &s, int textFlags);
 
+    /**
+     * add r to mOverlay, \see mergeOverlay()
+     */
+    void addOverlay(const QRect &r);
+
     /**
      * the size we want the overlay rects to be...
      */
@@ -0,0 +1,135 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "kigprofiler.h"
+
+#include "object_hierarchy.h"
+
+#include "../objects/object_imp.h"
+#include "../objects/object_type.h"
+
+#include <algorithm>
+#include <map>
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <KLocalizedString>
+
+std::atomic<bool> KigProfiler::senabled(false);
+
+// the objects may be calculated on more than one thread, e.g. by the
+// batch exporter..
+static QMutex profilerlock;
+
+// counted without a lock, every thread has its own..
+static thread_local qint64 profilerimps = 0;
+
+/**
+ * the counters, by kind and name.  The names are used as keys instead
+ * of the pointers, which may be reused for other objects..
+ */
+typedef std::map<std::pair<int, QByteArray>, KigProfiler::Entry> EntryMap;
+static EntryMap &profilerEntries()
+{
+    static EntryMap entries;
+    return entries;
+}
+
+void KigProfiler::setEnabled(bool enabled)
+{
+    senabled.store(enabled, std::memory_order_relaxed);
+}
+
+void KigProfiler::reset()
+{
+    QMutexLocker l(&profilerlock);
+    profilerEntries().clear();
+}
+
+void KigProfiler::countImp()
+{
+    ++profilerimps;
+}
+
+qint64 KigProfiler::impCount()
+{
+    return profilerimps;
+}
+
+void KigProfiler::record(Kind kind, const void *key, qint64 imps, qint64 time)
+{
+    QByteArray name;
+    switch (kind) {
+    case Calc:
+        name = static_cast<const ObjectType *>(key)->fullName();
+        break;
+    case Property:
+        name = ObjectImp::getPropName(static_cast<int>(reinterpret_cast<quintptr>(key)));
+        break;
+    case Hierarchy: {
+        const ObjectHierarchy *h = static_cast<const ObjectHierarchy *>(key);
+        name = QByteArray::number(static_cast<qulonglong>(h->mnodes.size())) + " nodes";
+        break;
+    }
+    case Draw:
+        name = static_cast<const ObjectImpType *>(key)->internalName();
+        break;
+    }
+
+    QMutexLocker l(&profilerlock);
+    EntryMap::iterator i = profilerEntries().find(std::make_pair(static_cast<int>(kind), name));
+    if (i == profilerEntries().end()) {
+        Entry e = {kind, name, 0, 0, 0, 0};
+        i = profilerEntries().insert(std::make_pair(std::make_pair(static_cast<int>(kind), name), e)).first;
+    }
+    Entry &e = i->second;
+    ++e.calls;
+    e.totaltime += time;
+    e.maxtime = std::max(e.maxtime, time);
+    e.imps += imps;
+}
+
+std::vector<KigProfiler::Entry> KigProfiler::entries()
+{
+    QMutexLocker l(&profilerlock);
+    std::vector<Entry> ret;
+    for (EntryMap::const_iterator i = profilerEntries().begin(); i != profilerEntries().end(); ++i)
+        ret.push_back(i->second);
+    return ret;
+}
+
+QString KigProfiler::kindName(Kind kind)
+{
+    switch (kind) {
+    case Calc:
+        return i18nc("what is being profiled", "Type");
+    case Property:
+        return i18nc("what is being profiled", "Property");
+    case Hierarchy:
+        return i18nc("what is being profiled", "Hierarchy");
+    case Draw:
+        return i18nc("what is being profiled", "Drawing");
+    }
+    return QString();
+}
+
+QString KigProfiler::toCsv()
+{
+    // the header is not translated, the file is meant for scripts..
+    QString ret = QStringLiteral("kind,name,calls,total_ms,average_us,max_us,imps\n");
+    const std::vector<Entry> es = entries();
+    for (std::vector<Entry>::const_iterator i = es.begin(); i != es.end(); ++i) {
+        static const char *const kinds[] = {"calc", "property", "hierarchy", "draw"};
+        ret += QStringLiteral("%1,%2,%3,%4,%5,%6,%7\n")
+                   .arg(QLatin1String(kinds[i->kind]))
+                   .arg(QString::fromLatin1(i->name))
+                   .arg(i->calls)
+                   .arg(i->totaltime / 1e6, 0, 'f', 3)
+                   .arg(i->totaltime / 1e3 / i->calls, 0, 'f', 3)
+                   .arg(i->maxtime / 1e3, 0, 'f', 3)
+                   .arg(i->imps);
+    }
+    return ret;
+}
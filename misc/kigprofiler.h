@@ -0,0 +1,149 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+class ObjectHierarchy;
+class ObjectImpType;
+class ObjectType;
+
+/**
+ * Counts how often every ObjectType is calculated, every property is
+ * fetched, every ObjectHierarchy is applied and every kind of ObjectImp
+ * is drawn, and how long that takes, so that one can find out which
+ * objects make a document slow.  The times and the numbers of
+ * ObjectImp's constructed include those of nested calculations, e.g.
+ * the hierarchy of a macro type is counted both for the hierarchy and
+ * for the type.
+ *
+ * Profiling is off by default, and then all that the instrumented code
+ * does is test a single flag.  See KigProfilerDialog for the report..
+ */
+class KigProfiler
+{
+public:
+    enum Kind { Calc, Property, Hierarchy, Draw };
+
+    struct Entry {
+        Kind kind;
+        QByteArray name;
+        qint64 calls;
+        /**
+         * in nanoseconds..
+         */
+        qint64 totaltime;
+        qint64 maxtime;
+        /**
+         * the number of ObjectImp's that were constructed, on the
+         * thread that did the work..
+         */
+        qint64 imps;
+    };
+
+    static bool enabled()
+    {
+        return senabled.load(std::memory_order_relaxed);
+    }
+    static void setEnabled(bool enabled);
+    /**
+     * forget everything counted so far..
+     */
+    static void reset();
+
+    /**
+     * the counters, sorted by kind and name..
+     */
+    static std::vector<Entry> entries();
+    static QString kindName(Kind kind);
+    /**
+     * the counters as CSV, with a header line..
+     */
+    static QString toCsv();
+
+    /**
+     * called by every ObjectImp constructor while profiling is on..
+     */
+    static void countImp();
+
+    /**
+     * Put one of these on the stack around the code to profile, it
+     * records the time until it goes out of scope..
+     */
+    class Scope
+    {
+        const void *mkey;
+        std::chrono::steady_clock::time_point mstart;
+        Kind mkind;
+        qint64 mimps;
+        bool mactive;
+
+        void start(Kind kind, const void *key)
+        {
+            mkind = kind;
+            mkey = key;
+            mimps = impCount();
+            mstart = std::chrono::steady_clock::now();
+        }
+
+    public:
+        explicit Scope(const ObjectType *type)
+            : mactive(senabled.load(std::memory_order_relaxed))
+        {
+            if (mactive)
+                start(Calc, type);
+        }
+        /**
+         * fetching the property with global id \p propgid..
+         */
+        explicit Scope(int propgid)
+            : mactive(senabled.load(std::memory_order_relaxed))
+        {
+            if (mactive)
+                start(Property, reinterpret_cast<const void *>(static_cast<quintptr>(propgid)));
+        }
+        /**
+         * applying \p hierarchy to one or more sets of arguments..
+         */
+        explicit Scope(const ObjectHierarchy *hierarchy)
+            : mactive(senabled.load(std::memory_order_relaxed))
+        {
+            if (mactive)
+                start(Hierarchy, hierarchy);
+        }
+        explicit Scope(const ObjectImpType *type)
+            : mactive(senabled.load(std::memory_order_relaxed))
+        {
+            if (mactive)
+                start(Draw, type);
+        }
+        ~Scope()
+        {
+            if (mactive)
+                record(mkind, mkey, impCount() - mimps, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mstart).count());
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+private:
+    /**
+     * the calcs on other threads read this without taking a lock, it
+     * doesn't matter when exactly they see it change..
+     */
+    static std::atomic<bool> senabled;
+    /**
+     * the number of ObjectImp's constructed on this thread while
+     * profiling was on, the scopes count the difference..
+     */
+    static qint64 impCount();
+    static void record(Kind kind, const void *key, qint64 imps, qint64 time);
+};
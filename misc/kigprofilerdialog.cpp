@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "kigprofilerdialog.h"
+
+#include "kigprofiler.h"
+
+#include "../kig/kig_view.h"
+
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLocale>
+#include <QPushButton>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <KLocalizedString>
+#include <KMessageBox>
+
+/**
+ * a row of the table, that sorts its numeric columns as numbers..
+ */
+class ProfilerItem : public QTreeWidgetItem
+{
+public:
+    bool operator<(const QTreeWidgetItem &other) const override
+    {
+        const int column = treeWidget() ? treeWidget()->sortColumn() : 0;
+        if (column < 2)
+            return QTreeWidgetItem::operator<(other);
+        return data(column, Qt::UserRole).toDouble() < other.data(column, Qt::UserRole).toDouble();
+    }
+};
+
+static void setNumber(QTreeWidgetItem *item, int column, double value, int decimals)
+{
+    item->setText(column, QLocale().toString(value, 'f', decimals));
+    item->setData(column, Qt::UserRole, value);
+    item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+}
+
+KigProfilerDialog::KigProfilerDialog(KigWidget *widget, QWidget *parent)
+    : QDialog(parent)
+    , mwidget(widget)
+{
+    setWindowTitle(i18nc("@title:window", "Profiler"));
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    menabled = new QCheckBox(i18n("Profile calculating and drawing the objects"), this);
+    menabled->setChecked(KigProfiler::enabled());
+    connect(menabled, &QCheckBox::toggled, this, &KigProfilerDialog::setProfilingEnabled);
+
+    mtable = new QTreeWidget(this);
+    mtable->setRootIsDecorated(false);
+    mtable->setSortingEnabled(true);
+    mtable->setHeaderLabels(QStringList() << i18nc("what is being profiled", "Kind") << i18n("Name") << i18n("Calls") << i18n("Total (ms)")
+                                          << i18n("Average (µs)") << i18n("Maximum (µs)") << i18n("Objects Allocated"));
+    mtable->sortByColumn(3, Qt::DescendingOrder);
+
+    mpaintstats = new QLabel(this);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    QPushButton *resetButton = buttonBox->addButton(i18n("&Reset"), QDialogButtonBox::ResetRole);
+    QPushButton *exportButton = buttonBox->addButton(i18n("&Export as CSV..."), QDialogButtonBox::ActionRole);
+    connect(resetButton, &QPushButton::clicked, this, &KigProfilerDialog::reset);
+    connect(exportButton, &QPushButton::clicked, this, &KigProfilerDialog::exportCsv);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(menabled);
+    mainLayout->addWidget(mtable);
+    mainLayout->addWidget(mpaintstats);
+    mainLayout->addWidget(buttonBox);
+    resize(700, 450);
+
+    mtimer = new QTimer(this);
+    mtimer->setInterval(1000);
+    connect(mtimer, &QTimer::timeout, this, &KigProfilerDialog::refresh);
+    if (KigProfiler::enabled())
+        mtimer->start();
+
+    refresh();
+}
+
+KigProfilerDialog::~KigProfilerDialog()
+{
+}
+
+void KigProfilerDialog::setProfilingEnabled(bool enabled)
+{
+    KigProfiler::setEnabled(enabled);
+    if (enabled)
+        mtimer->start();
+    else
+        mtimer->stop();
+    refresh();
+}
+
+void KigProfilerDialog::refresh()
+{
+    mtable->setSortingEnabled(false);
+    mtable->clear();
+    const std::vector<KigProfiler::Entry> entries = KigProfiler::entries();
+    for (std::vector<KigProfiler::Entry>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+        QTreeWidgetItem *item = new ProfilerItem;
+        item->setText(0, KigProfiler::kindName(i->kind));
+        item->setText(1, QString::fromLatin1(i->name));
+        setNumber(item, 2, i->calls, 0);
+        setNumber(item, 3, i->totaltime / 1e6, 3);
+        setNumber(item, 4, i->totaltime / 1e3 / i->calls, 3);
+        setNumber(item, 5, i->maxtime / 1e3, 3);
+        setNumber(item, 6, i->imps, 0);
+        mtable->addTopLevelItem(item);
+    }
+    mtable->setSortingEnabled(true);
+    mtable->header()->resizeSections(QHeaderView::ResizeToContents);
+
+    if (mwidget) {
+        const KigWidget::OverlayStats &stats = mwidget->lastOverlayStats();
+        mpaintstats->setText(i18n("Last repaint: %1 rectangles, %2 pixels", stats.rects, QLocale().toString(stats.pixels)) + QLatin1Char('\n')
+                             + i18n("Time between frames while moving: %1", mwidget->frameTimes().toString()));
+    }
+    mpaintstats->setVisible(!mwidget.isNull());
+}
+
+void KigProfilerDialog::reset()
+{
+    KigProfiler::reset();
+    if (mwidget)
+        mwidget->clearFrameTimes();
+    refresh();
+}
+
+void KigProfilerDialog::exportCsv()
+{
+    const QString file = QFileDialog::getSaveFileName(this, i18nc("@title:window", "Export Profile"), QString(), i18n("CSV files (*.csv)"));
+    if (file.isEmpty())
+        return;
+    QFile f(file);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        KMessageBox::error(this, i18n("The file \"%1\" could not be opened for writing.", file));
+        return;
+    }
+    f.write(KigProfiler::toCsv().toUtf8());
+}
@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <QDialog>
+#include <QPointer>
+
+class KigWidget;
+class QCheckBox;
+class QLabel;
+class QTimer;
+class QTreeWidget;
+
+/**
+ * Shows the counters of the KigProfiler, updated every second while
+ * profiling is on, and lets the user turn profiling on and off, reset
+ * the counters and export them as CSV.  Below the table it shows how
+ * much of \p widget was repainted the last time, and how its frames
+ * were paced..
+ */
+class KigProfilerDialog : public QDialog
+{
+    Q_OBJECT
+
+    QCheckBox *menabled;
+    QTreeWidget *mtable;
+    QLabel *mpaintstats;
+    QTimer *mtimer;
+    QPointer<KigWidget> mwidget;
+
+public:
+    explicit KigProfilerDialog(KigWidget *widget, QWidget *parent = nullptr);
+    ~KigProfilerDialog() override;
+
+private Q_SLOTS:
+    void setProfilingEnabled(bool enabled);
+    void refresh();
+    void reset();
+    void exportCsv();
+};
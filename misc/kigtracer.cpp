@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "kigtracer.h"
+
+#include <algorithm>
+#include <map>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+std::atomic<bool> KigTracer::senabled(false);
+
+// guards the ring buffer: the spans are recorded by whichever thread
+// ran them, and the GUI thread reads the buffer to save it..
+static QMutex tracerlock;
+
+/**
+ * the ring buffer.  It is only allocated when the tracer is turned on,
+ * next is where the next span goes, and once the buffer is full, that
+ * is also where the oldest one is..
+ */
+struct TraceBuffer {
+    std::vector<KigTracer::Event> events;
+    size_t next = 0;
+    bool full = false;
+    // about 4 MB, which is a minute or so of dragging a big document..
+    int capacity = 100000;
+};
+
+static TraceBuffer &traceBuffer()
+{
+    static TraceBuffer buffer;
+    return buffer;
+}
+
+void KigTracer::setEnabled(bool enabled)
+{
+    if (enabled) {
+        QMutexLocker l(&tracerlock);
+        TraceBuffer &b = traceBuffer();
+        if (b.events.empty())
+            b.events.resize(b.capacity);
+    }
+    senabled.store(enabled, std::memory_order_relaxed);
+}
+
+int KigTracer::capacity()
+{
+    QMutexLocker l(&tracerlock);
+    return traceBuffer().capacity;
+}
+
+void KigTracer::setCapacity(int events)
+{
+    QMutexLocker l(&tracerlock);
+    TraceBuffer &b = traceBuffer();
+    events = std::max(events, 1);
+    if (events == b.capacity)
+        return;
+    // the spans are dropped rather than moved, this is only done before
+    // tracing starts..
+    b.capacity = events;
+    b.next = 0;
+    b.full = false;
+    if (!b.events.empty())
+        b.events.assign(events, Event());
+}
+
+void KigTracer::clear()
+{
+    QMutexLocker l(&tracerlock);
+    traceBuffer().next = 0;
+    traceBuffer().full = false;
+}
+
+void KigTracer::record(const char *name, const char *category, std::chrono::steady_clock::time_point start)
+{
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    Event e;
+    e.name = name;
+    e.category = category;
+    e.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count();
+    e.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    e.thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    QMutexLocker l(&tracerlock);
+    TraceBuffer &b = traceBuffer();
+    // the tracer may have been turned on while the span was open..
+    if (b.events.empty())
+        return;
+    b.events[b.next] = e;
+    if (++b.next == b.events.size()) {
+        b.next = 0;
+        b.full = true;
+    }
+}
+
+std::vector<KigTracer::Event> KigTracer::events()
+{
+    QMutexLocker l(&tracerlock);
+    const TraceBuffer &b = traceBuffer();
+    std::vector<Event> ret;
+    if (b.full)
+        ret.insert(ret.end(), b.events.begin() + b.next, b.events.end());
+    ret.insert(ret.end(), b.events.begin(), b.events.begin() + b.next);
+    return ret;
+}
+
+QByteArray KigTracer::toChromeTrace()
+{
+    // the spans are recorded when they end, so the outer ones come
+    // after the ones nested in them, the viewers want them by start..
+    std::vector<Event> es = events();
+    std::stable_sort(es.begin(), es.end(), [](const Event &a, const Event &b) {
+        return a.start < b.start;
+    });
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray trace;
+    QJsonObject process;
+    process.insert(QStringLiteral("name"), QStringLiteral("process_name"));
+    process.insert(QStringLiteral("ph"), QStringLiteral("M"));
+    process.insert(QStringLiteral("pid"), pid);
+    process.insert(QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), QStringLiteral("kig")}});
+    trace.append(process);
+
+    // the thread ids are pointers, we number the threads in the order
+    // in which they show up instead, and the times start at the first
+    // span, so that the numbers stay readable..
+    std::map<quintptr, int> threads;
+    const qint64 origin = es.empty() ? 0 : es.front().start;
+    for (std::vector<Event>::const_iterator i = es.begin(); i != es.end(); ++i) {
+        const int tid = threads.insert(std::make_pair(i->thread, static_cast<int>(threads.size()) + 1)).first->second;
+        QJsonObject e;
+        e.insert(QStringLiteral("name"), QLatin1String(i->name));
+        e.insert(QStringLiteral("cat"), QLatin1String(i->category));
+        e.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        // in microseconds..
+        e.insert(QStringLiteral("ts"), (i->start - origin) / 1e3);
+        e.insert(QStringLiteral("dur"), i->duration / 1e3);
+        e.insert(QStringLiteral("pid"), pid);
+        e.insert(QStringLiteral("tid"), tid);
+        trace.append(e);
+    }
+
+    QJsonObject ret;
+    ret.insert(QStringLiteral("traceEvents"), trace);
+    ret.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+    return QJsonDocument(ret).toJson(QJsonDocument::Compact);
+}
+
+bool KigTracer::write(const QString &file)
+{
+    QFile f(file);
+    if (!f.open(QIODevice::WriteOnly))
+        return false;
+    return f.write(toChromeTrace()) != -1;
+}
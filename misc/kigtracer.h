@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * Records what an interactive session spends its time on, as a
+ * timeline of nested spans: the dispatch of mouse events to the modes,
+ * moving objects, calculating them again, redrawing the screen, drawing
+ * curves, copying the overlay to the widget and loading and saving
+ * documents.  Unlike KigProfiler, which adds everything up, this keeps
+ * every single span, so that one can see why one frame of a drag took
+ * too long.
+ *
+ * The spans go to a ring buffer, so that only the last ones are kept
+ * however long Kig runs, and they can be written as a Chrome trace
+ * (the JSON format that chrome://tracing and Perfetto read) whenever
+ * the user has seen something slow.
+ *
+ * Tracing is off by default, and then all that the instrumented code
+ * does is test a single flag.  It is turned on with the Tools menu, or
+ * from the start with the KIG_TRACE environment variable..
+ */
+class KigTracer
+{
+public:
+    struct Event {
+        /**
+         * these are string literals, so that recording a span doesn't
+         * allocate anything..
+         */
+        const char *name;
+        const char *category;
+        /**
+         * in nanoseconds, the start since an arbitrary point in time..
+         */
+        qint64 start;
+        qint64 duration;
+        quintptr thread;
+    };
+
+    static bool enabled()
+    {
+        return senabled.load(std::memory_order_relaxed);
+    }
+    /**
+     * turning the tracer on allocates the buffer, turning it off keeps
+     * the spans recorded so far..
+     */
+    static void setEnabled(bool enabled);
+    /**
+     * the number of spans that are kept, the oldest ones are dropped
+     * first..
+     */
+    static int capacity();
+    static void setCapacity(int events);
+    static void clear();
+
+    /**
+     * the spans in the buffer, the oldest first..
+     */
+    static std::vector<Event> events();
+    static QByteArray toChromeTrace();
+    static bool write(const QString &file);
+
+    /**
+     * Put one of these on the stack around the code to trace, it
+     * records a span until it goes out of scope..
+     */
+    class Span
+    {
+        const char *mname;
+        const char *mcategory;
+        std::chrono::steady_clock::time_point mstart;
+        bool mactive;
+
+    public:
+        Span(const char *name, const char *category)
+            : mactive(senabled.load(std::memory_order_relaxed))
+        {
+            if (mactive) {
+                mname = name;
+                mcategory = category;
+                mstart = std::chrono::steady_clock::now();
+            }
+        }
+        ~Span()
+        {
+            if (mactive)
+                record(mname, mcategory, mstart);
+        }
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+    };
+
+private:
+    /**
+     * read without a lock on every span, a span that starts just
+     * before the tracer is turned on or off is simply missed or
+     * dropped..
+     */
+    static std::atomic<bool> senabled;
+    static void record(const char *name, const char *category, std::chrono::steady_clock::time_point start);
+};
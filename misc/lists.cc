@@ -7,6 +7,7 @@
 #include "../kig/kig_part.h"
 #include "guiaction.h"
 #include "kig_version.h"
+#include "macro_index.h"
 #include "object_constructor.h"
 #include "object_hierarchy.h"
 
@@ -254,7 +255,7 @@ bool MacroList::save(const std::vector<Macro *> &ms, const QString &f)
 
         // data
         QDomElement hierelem = doc.createElement(QStringLiteral("Construction"));
-        ctor->hierarchy().serialize(hierelem, doc);
+        ctor->serializeHierarchy(hierelem, doc);
         macroelem.appendChild(hierelem);
 
         docelem.appendChild(macroelem);
@@ -270,24 +271,16 @@ bool MacroList::save(const std::vector<Macro *> &ms, const QString &f)
     return true;
 }
 
-bool MacroList::load(const QString &f, std::vector<Macro *> &ret, const KigPart &kdoc)
+bool MacroList::load(const QString &f, std::vector<Macro *> &ret, const KigPart &)
 {
-    QFile file(f);
-    if (!file.open(QIODevice::ReadOnly)) {
-        KMessageBox::error(nullptr, i18n("Could not open macro file '%1'", f));
-        return false;
-    }
-    QDomDocument doc(QStringLiteral("KigMacroFile"));
-    if (!doc.setContent(&file)) {
+    // we only index the file here, the hierarchies of the macros are
+    // built when they are first used..
+    MacroIndex::vectype entries;
+    MacroIndex::Status st = MacroIndex::instance()->lookup(f, entries);
+    if (st == MacroIndex::CouldNotOpen) {
         KMessageBox::error(nullptr, i18n("Could not open macro file '%1'", f));
         return false;
-    }
-    file.close();
-    QDomElement main = doc.documentElement();
-
-    if (main.tagName() == QLatin1String("KigMacroFile"))
-        return loadNew(main, ret, kdoc);
-    else {
+    } else if (st == MacroIndex::OldFormat) {
         KMessageBox::detailedError(nullptr,
                                    i18n("Kig cannot open the macro file \"%1\".", f),
                                    i18n("This file was created by a very old Kig version (pre-0.4). "
@@ -297,62 +290,19 @@ bool MacroList::load(const QString &f, std::vector<Macro *> &ret, const KigPart
                                    i18n("Not Supported"));
         return false;
     }
-}
-
-bool MacroList::loadNew(const QDomElement &docelem, std::vector<Macro *> &ret, const KigPart &)
-{
-    bool sok = true;
-    // unused..
-    //  int number = docelem.attribute( "Number" ).toInt( &sok );
-    if (!sok)
-        return false;
-
-    QString version = docelem.attribute(QStringLiteral("Version"));
-    //  QRegularExpression re( "(\\d+)\\.(\\d+)\\.(\\d+)" );
-    //  re.match( version );
-    // unused..
-    //  int major = re.cap( 1 ).toInt( &sok );
-    //  int minor = re.cap( 2 ).toInt( &sok );
-    //  int mminor = re.cap( 3 ).toInt( &sok );
-    //  if ( ! sok ) return false;
 
     int unnamedindex = 1;
-    QString tmp;
-
-    for (QDomElement macroelem = docelem.firstChild().toElement(); !macroelem.isNull(); macroelem = macroelem.nextSibling().toElement()) {
-        QString name, description;
-        ObjectHierarchy *hierarchy = nullptr;
-        QByteArray actionname;
-        QByteArray iconfile("system-run");
-        if (macroelem.tagName() != QLatin1String("Macro"))
-            continue; // forward compat ?
-        for (QDomElement dataelem = macroelem.firstChild().toElement(); !dataelem.isNull(); dataelem = dataelem.nextSibling().toElement()) {
-            if (dataelem.tagName() == QLatin1String("Name"))
-                name = dataelem.text();
-            else if (dataelem.tagName() == QLatin1String("Description"))
-                description = dataelem.text();
-            else if (dataelem.tagName() == QLatin1String("Construction"))
-                hierarchy = ObjectHierarchy::buildSafeObjectHierarchy(dataelem, tmp);
-            else if (dataelem.tagName() == QLatin1String("ActionName"))
-                actionname = dataelem.text().toLatin1();
-            else if (dataelem.tagName() == QLatin1String("IconFileName"))
-                iconfile = dataelem.text().toLatin1();
-            else
-                continue;
-        };
-        assert(hierarchy);
+    for (MacroIndex::vectype::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+        QString name = i->name;
         // if the macro has no name, we give it a bogus name...
         bool name_i18ned = false;
         if (name.isEmpty()) {
             name = i18n("Unnamed Macro #%1", unnamedindex++);
             name_i18ned = true;
         }
-        MacroConstructor *ctor = new MacroConstructor(*hierarchy,
-                                                      name_i18ned ? name : i18n(name.toUtf8()),
-                                                      description.isEmpty() ? QString() : i18n(description.toUtf8()),
-                                                      iconfile);
-        delete hierarchy;
-        GUIAction *act = new ConstructibleAction(ctor, actionname);
+        MacroConstructor *ctor =
+            new MacroConstructor(*i, name_i18ned ? name : i18n(name.toUtf8()), i->description.isEmpty() ? QString() : i18n(i->description.toUtf8()));
+        GUIAction *act = new ConstructibleAction(ctor, i->actionname);
         Macro *macro = new Macro(act, ctor);
         ret.push_back(macro);
     };
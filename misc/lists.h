@@ -39,6 +39,13 @@ public:
     {
         return mactions;
     }
+    /**
+     * the documents that are open..
+     */
+    const dvectype &docs() const
+    {
+        return mdocs;
+    }
 
     /**
      * register this document, so that it receives notifications for
@@ -155,7 +162,4 @@ public:
      * get access to the list of macro's.
      */
     const vectype &macros() const;
-
-private:
-    bool loadNew(const QDomElement &docelem, std::vector<Macro *> &ret, const KigPart &);
 };
@@ -0,0 +1,325 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "macro_index.h"
+
+#include "argsparser.h"
+#include "object_hierarchy.h"
+
+#include "../objects/object_imp.h"
+#include "../objects/object_type.h"
+#include "../objects/object_type_factory.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+// "KGMI"
+static const quint32 indexmagic = 0x494d474b;
+// bump this when the layout of the index file or the Entry struct
+// changes..
+static const quint32 indexversion = 1;
+
+static QString indexFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/macro-index");
+}
+
+ArgsParser MacroIndex::Entry::argParser() const
+{
+    std::vector<const ObjectImpType *> reqs;
+    for (std::vector<QByteArray>::const_iterator i = requirements.begin(); i != requirements.end(); ++i) {
+        const ObjectImpType *req = ObjectImpType::typeFromInternalName(i->constData());
+        // same fallback as ObjectHierarchy::buildSafeObjectHierarchy..
+        reqs.push_back(req ? req : ObjectImp::stype());
+    }
+    return ObjectHierarchy::argParser(reqs, usetexts, selectstatements);
+}
+
+const ObjectImpType *MacroIndex::Entry::lastResult() const
+{
+    if (lastnode == FetchPropertyNode)
+        return ObjectImp::stype();
+    if (lastnode == CalcNode) {
+        const ObjectType *type = ObjectTypeFactory::instance()->find(lasttype.constData());
+        if (type)
+            return type->resultId();
+    }
+    // the type of a pushed imp is only known after deserializing it..
+    return nullptr;
+}
+
+static QDataStream &operator<<(QDataStream &s, const MacroIndex::Entry &e)
+{
+    s << e.name << e.description << e.actionname << e.iconfile;
+    s << static_cast<quint32>(e.requirements.size());
+    for (uint i = 0; i < e.requirements.size(); ++i)
+        s << e.requirements[i] << e.usetexts[i] << e.selectstatements[i];
+    s << static_cast<quint32>(e.numberofresults) << static_cast<quint8>(e.lastnode) << e.lasttype << e.construction;
+    return s;
+}
+
+static QDataStream &operator>>(QDataStream &s, MacroIndex::Entry &e)
+{
+    quint32 nargs = 0;
+    s >> e.name >> e.description >> e.actionname >> e.iconfile >> nargs;
+    e.requirements.clear();
+    e.usetexts.clear();
+    e.selectstatements.clear();
+    for (quint32 i = 0; i < nargs && s.status() == QDataStream::Ok; ++i) {
+        QByteArray req;
+        QChar usetext, selectstat;
+        s >> req >> usetext >> selectstat;
+        e.requirements.push_back(req);
+        e.usetexts.append(usetext);
+        e.selectstatements.append(selectstat);
+    }
+    quint32 results = 0;
+    quint8 lastnode = 0;
+    s >> results >> lastnode >> e.lasttype >> e.construction;
+    e.numberofresults = results;
+    e.lastnode = static_cast<MacroIndex::LastNode>(lastnode);
+    return s;
+}
+
+MacroIndex::MacroIndex()
+    : mloaded(false)
+    , mdirty(false)
+{
+}
+
+MacroIndex::~MacroIndex()
+{
+}
+
+MacroIndex *MacroIndex::instance()
+{
+    static MacroIndex t;
+    return &t;
+}
+
+void MacroIndex::load()
+{
+    mloaded = true;
+    QFile file(indexFile());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream s(&file);
+    s.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0, nfiles = 0;
+    s >> magic >> version >> nfiles;
+    if (magic != indexmagic || version != indexversion)
+        return;
+
+    std::map<QString, File> files;
+    for (quint32 i = 0; i < nfiles; ++i) {
+        QString path;
+        File f;
+        quint32 nentries = 0;
+        s >> path >> f.mtime >> f.size >> nentries;
+        for (quint32 j = 0; j < nentries && s.status() == QDataStream::Ok; ++j) {
+            Entry e;
+            s >> e;
+            f.entries.push_back(e);
+        }
+        if (s.status() != QDataStream::Ok)
+            // a truncated index is as good as none..
+            return;
+        f.used = false;
+        files[path] = f;
+    }
+    mfiles.swap(files);
+}
+
+void MacroIndex::save()
+{
+    bool prune = false;
+    for (std::map<QString, File>::const_iterator i = mfiles.begin(); i != mfiles.end(); ++i)
+        prune |= !i->second.used;
+    if (!mdirty && !prune)
+        return;
+
+    const QString path = indexFile();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    quint32 nfiles = 0;
+    for (std::map<QString, File>::const_iterator i = mfiles.begin(); i != mfiles.end(); ++i)
+        if (i->second.used)
+            ++nfiles;
+
+    QDataStream s(&file);
+    s.setVersion(QDataStream::Qt_6_0);
+    s << indexmagic << indexversion << nfiles;
+    for (std::map<QString, File>::const_iterator i = mfiles.begin(); i != mfiles.end(); ++i) {
+        if (!i->second.used)
+            continue;
+        const vectype &entries = i->second.entries;
+        s << i->first << i->second.mtime << i->second.size << static_cast<quint32>(entries.size());
+        for (vectype::const_iterator j = entries.begin(); j != entries.end(); ++j)
+            s << *j;
+    }
+    if (s.status() == QDataStream::Ok && file.commit())
+        mdirty = false;
+}
+
+MacroIndex::Status MacroIndex::lookup(const QString &file, vectype &ret)
+{
+    if (!mloaded)
+        load();
+
+    const QFileInfo fi(file);
+    const QString path = fi.absoluteFilePath();
+    const qint64 mtime = fi.lastModified().toMSecsSinceEpoch();
+    const qint64 size = fi.size();
+
+    std::map<QString, File>::iterator i = mfiles.find(path);
+    if (i != mfiles.end() && i->second.mtime == mtime && i->second.size == size) {
+        i->second.used = true;
+        ret = i->second.entries;
+        return Ok;
+    }
+
+    vectype entries;
+    Status st = scan(file, entries);
+    if (st != Ok) {
+        if (i != mfiles.end()) {
+            mfiles.erase(i);
+            mdirty = true;
+        }
+        return st;
+    }
+
+    File &f = mfiles[path];
+    f.mtime = mtime;
+    f.size = size;
+    f.used = true;
+    f.entries = entries;
+    mdirty = true;
+    ret = entries;
+    return Ok;
+}
+
+/**
+ * copy the element \p xml is at to \p w, and collect the argument
+ * and result information for \p e on the way..
+ */
+static void scanConstruction(QXmlStreamReader &xml, QXmlStreamWriter &w, MacroIndex::Entry &e)
+{
+    int depth = 0;
+    int lastid = -1;
+    int input = -1;
+    while (!xml.atEnd()) {
+        if (xml.isStartElement()) {
+            w.writeStartElement(xml.name().toString());
+            w.writeAttributes(xml.attributes());
+
+            if (depth == 1) {
+                const QXmlStreamAttributes attrs = xml.attributes();
+                const int id = attrs.value(QLatin1String("id")).toInt();
+                input = -1;
+                if (xml.name() == QLatin1String("input")) {
+                    const uint n = qMax(id, 0);
+                    if (n > e.requirements.size()) {
+                        e.requirements.resize(n, QByteArray(ObjectImp::stype()->internalName()));
+                        e.usetexts.resize(n, QChar());
+                        e.selectstatements.resize(n, QChar());
+                    }
+                    if (n > 0) {
+                        e.requirements[n - 1] = attrs.value(QLatin1String("requirement")).toLatin1();
+                        input = n - 1;
+                    }
+                } else {
+                    if (xml.name() == QLatin1String("result"))
+                        ++e.numberofresults;
+                    // the nodes are ordered by their id, the last one
+                    // gives the result type..
+                    if (id > lastid) {
+                        lastid = id;
+                        const QStringView action = attrs.value(QLatin1String("action"));
+                        if (action == QLatin1String("calc")) {
+                            e.lastnode = MacroIndex::CalcNode;
+                            e.lasttype = attrs.value(QLatin1String("type")).toLatin1();
+                        } else if (action == QLatin1String("fetch-property"))
+                            e.lastnode = MacroIndex::FetchPropertyNode;
+                        else
+                            e.lastnode = MacroIndex::PushNode;
+                    }
+                }
+            } else if (depth == 2 && input >= 0 && (xml.name() == QLatin1String("UseText") || xml.name() == QLatin1String("SelectStatement"))) {
+                const bool usetext = xml.name() == QLatin1String("UseText");
+                const QString text = xml.readElementText();
+                w.writeCharacters(text);
+                w.writeEndElement();
+                const QChar c = text.isEmpty() ? QChar() : text.at(0);
+                if (usetext)
+                    e.usetexts[input] = c;
+                else
+                    e.selectstatements[input] = c;
+                xml.readNext();
+                continue;
+            }
+            ++depth;
+        } else if (xml.isEndElement()) {
+            w.writeEndElement();
+            if (--depth == 0)
+                return;
+        } else if (xml.isCharacters() && !xml.isWhitespace())
+            w.writeCharacters(xml.text().toString());
+        xml.readNext();
+    }
+}
+
+MacroIndex::Status MacroIndex::scan(const QString &f, vectype &ret)
+{
+    QFile file(f);
+    if (!file.open(QIODevice::ReadOnly))
+        return CouldNotOpen;
+
+    QXmlStreamReader xml(&file);
+    if (!xml.readNextStartElement())
+        return CouldNotOpen;
+    if (xml.name() != QLatin1String("KigMacroFile"))
+        return OldFormat;
+
+    while (xml.readNextStartElement()) {
+        if (xml.name() != QLatin1String("Macro")) {
+            // forward compat ?
+            xml.skipCurrentElement();
+            continue;
+        }
+        Entry e;
+        e.iconfile = "system-run";
+        e.numberofresults = 0;
+        e.lastnode = PushNode;
+        while (xml.readNextStartElement()) {
+            if (xml.name() == QLatin1String("Name"))
+                e.name = xml.readElementText();
+            else if (xml.name() == QLatin1String("Description"))
+                e.description = xml.readElementText();
+            else if (xml.name() == QLatin1String("ActionName"))
+                e.actionname = xml.readElementText().toLatin1();
+            else if (xml.name() == QLatin1String("IconFileName"))
+                e.iconfile = xml.readElementText().toLatin1();
+            else if (xml.name() == QLatin1String("Construction")) {
+                QXmlStreamWriter w(&e.construction);
+                scanConstruction(xml, w, e);
+            } else
+                xml.skipCurrentElement();
+        }
+        if (e.construction.isEmpty())
+            // a macro without a construction is useless..
+            continue;
+        ret.push_back(e);
+    }
+    return xml.hasError() ? CouldNotOpen : Ok;
+}
@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+class ArgsParser;
+class ObjectImpType;
+
+/**
+ * A cheap index of the macro files we load at startup.  Building the
+ * ObjectHierarchy of a macro is expensive, so for every macro in a
+ * file we only remember what is needed to show it in the GUI and to
+ * check its arguments: its name, icon and argument types, the type of
+ * its result, and the (still serialized) construction.  The
+ * MacroConstructor builds the hierarchy from the latter on first use.
+ *
+ * The index is cached on disk, and an entry is reused as long as the
+ * modification time and size of its file don't change..
+ */
+class MacroIndex
+{
+public:
+    /**
+     * what the last node of a macro's hierarchy does, this is what
+     * determines its result type..
+     */
+    enum LastNode { CalcNode = 0, FetchPropertyNode, PushNode };
+
+    struct Entry {
+        QString name;
+        QString description;
+        QByteArray actionname;
+        QByteArray iconfile;
+        /**
+         * the internal names of the ObjectImpType's of the arguments,
+         * and their one-character use texts and select statements, as
+         * stored in the macro file..
+         */
+        std::vector<QByteArray> requirements;
+        QString usetexts;
+        QString selectstatements;
+        uint numberofresults;
+        LastNode lastnode;
+        /**
+         * the name of the ObjectType of the last node, if it is a
+         * CalcNode..
+         */
+        QByteArray lasttype;
+        /**
+         * the "Construction" element of the macro, as compact xml..
+         */
+        QByteArray construction;
+
+        /**
+         * the ArgsParser for the arguments of this macro..
+         */
+        ArgsParser argParser() const;
+        /**
+         * the type of the last result of this macro, or 0 if we can't
+         * tell without building its hierarchy..
+         */
+        const ObjectImpType *lastResult() const;
+    };
+    typedef std::vector<Entry> vectype;
+
+    enum Status { Ok = 0, CouldNotOpen, OldFormat };
+
+private:
+    struct File {
+        qint64 mtime;
+        qint64 size;
+        bool used;
+        vectype entries;
+    };
+    std::map<QString, File> mfiles;
+    bool mloaded;
+    bool mdirty;
+
+    MacroIndex();
+    ~MacroIndex();
+
+    void load();
+    static Status scan(const QString &file, vectype &ret);
+
+public:
+    static MacroIndex *instance();
+
+    /**
+     * get the macros in \p file, from the cache if it is still up to
+     * date, or else by scanning the file..
+     */
+    Status lookup(const QString &file, vectype &ret);
+
+    /**
+     * write the index back to disk if it changed.  Only the files that
+     * were looked up in this session are kept..
+     */
+    void save();
+};
@@ -23,7 +23,9 @@
 
 #include "../modes/construct_mode.h"
 
+#include <QDebug>
 #include <QPen>
+#include <qdom.h>
 
 #include <algorithm>
 #include <functional>
@@ -315,12 +317,14 @@ KLazyLocalizedString MergeObjectConstructor::selectStatement(const std::vector<O
 
 MacroConstructor::MacroConstructor(const ObjectHierarchy &hier, const QString &name, const QString &desc, const QByteArray &iconfile)
     : ObjectConstructor()
-    , mhier(hier)
+    , mhier(new ObjectHierarchy(hier))
+    , mnumberofresults(mhier->numberOfResults())
+    , mlastresult(mhier->idOfLastResult())
     , mname(name)
     , mdesc(desc)
     , mbuiltin(false)
     , miconfile(iconfile)
-    , mparser(mhier.argParser())
+    , mparser(mhier->argParser())
 {
 }
 
@@ -330,12 +334,27 @@ MacroConstructor::MacroConstructor(const std::vector<ObjectCalcer *> &input,
                                    const QString &description,
                                    const QByteArray &iconfile)
     : ObjectConstructor()
-    , mhier(input, output)
+    , mhier(new ObjectHierarchy(input, output))
+    , mnumberofresults(mhier->numberOfResults())
+    , mlastresult(mhier->idOfLastResult())
     , mname(name)
     , mdesc(description)
     , mbuiltin(false)
     , miconfile(iconfile)
-    , mparser(mhier.argParser())
+    , mparser(mhier->argParser())
+{
+}
+
+MacroConstructor::MacroConstructor(const MacroIndex::Entry &entry, const QString &name, const QString &desc)
+    : ObjectConstructor()
+    , mconstruction(entry.construction)
+    , mnumberofresults(entry.numberofresults)
+    , mlastresult(entry.lastResult())
+    , mname(name)
+    , mdesc(desc)
+    , mbuiltin(false)
+    , miconfile(entry.iconfile)
+    , mparser(entry.argParser())
 {
 }
 
@@ -343,6 +362,37 @@ MacroConstructor::~MacroConstructor()
 {
 }
 
+bool MacroConstructor::loadHierarchy() const
+{
+    if (mhier)
+        return true;
+
+    QDomDocument doc;
+    QString error;
+    if (doc.setContent(mconstruction))
+        mhier.reset(ObjectHierarchy::buildSafeObjectHierarchy(doc.documentElement(), error));
+    if (!mhier) {
+        qWarning() << "Could not build the macro" << mname << error;
+        return false;
+    }
+    mconstruction.clear();
+    return true;
+}
+
+void MacroConstructor::serializeHierarchy(QDomElement &parent, QDomDocument &doc) const
+{
+    if (mhier) {
+        mhier->serialize(parent, doc);
+        return;
+    }
+    // not built yet, just copy what we loaded..
+    QDomDocument construction;
+    if (!construction.setContent(mconstruction))
+        return;
+    for (QDomNode n = construction.documentElement().firstChild(); !n.isNull(); n = n.nextSibling())
+        parent.appendChild(doc.importNode(n, true));
+}
+
 const QString MacroConstructor::descriptiveName() const
 {
     return mname;
@@ -370,13 +420,15 @@ int MacroConstructor::wantArgs(const std::vector<ObjectCalcer *> &os, const KigD
 
 void MacroConstructor::handleArgs(const std::vector<ObjectCalcer *> &os, KigPart &d, KigWidget &) const
 {
+    if (!loadHierarchy())
+        return;
     std::vector<ObjectCalcer *> args = mparser.parse(os);
-    std::vector<ObjectCalcer *> bos = mhier.buildObjects(args, d.document());
+    std::vector<ObjectCalcer *> bos = mhier->buildObjects(args, d.document());
+    // buildObjects() has calc'ed them already, the document calcs them
+    // again in one pass when they are added..
     std::vector<ObjectHolder *> hos;
-    for (std::vector<ObjectCalcer *>::iterator i = bos.begin(); i != bos.end(); ++i) {
+    for (std::vector<ObjectCalcer *>::iterator i = bos.begin(); i != bos.end(); ++i)
         hos.push_back(new ObjectHolder(*i));
-        hos.back()->calc(d.document());
-    }
 
     d.addObjects(hos);
 }
@@ -407,14 +459,14 @@ KLazyLocalizedString MacroConstructor::useText(const ObjectCalcer &o, const std:
 
 void MacroConstructor::handlePrelim(KigPainter &p, const std::vector<ObjectCalcer *> &sel, const KigDocument &doc, const KigWidget &) const
 {
-    if (sel.size() != mhier.numberOfArgs())
+    if (!loadHierarchy() || sel.size() != mhier->numberOfArgs())
         return;
 
     using namespace std;
     Args args;
     transform(sel.begin(), sel.end(), back_inserter(args), std::mem_fn(&ObjectCalcer::imp));
     args = mparser.parse(args);
-    std::vector<ObjectImp *> ret = mhier.calc(args, doc);
+    std::vector<ObjectImp *> ret = mhier->calc(args, doc);
     for (uint i = 0; i < ret.size(); ++i) {
         ObjectDrawer d;
         d.draw(*ret[i], p, true);
@@ -439,19 +491,23 @@ void MacroConstructor::plug(KigPart *doc, KigGUIAction *kact)
 {
     if (mbuiltin)
         return;
-    if (mhier.numberOfResults() != 1)
+    // a macro ending with a pushed imp has to be built to know its
+    // result type..
+    if (!mlastresult && loadHierarchy())
+        mlastresult = mhier->idOfLastResult();
+    if (mnumberofresults != 1 || !mlastresult)
         doc->aMNewOther.append(kact);
     else {
-        if (mhier.idOfLastResult() == SegmentImp::stype())
+        if (mlastresult == SegmentImp::stype())
             doc->aMNewSegment.append(kact);
-        else if (mhier.idOfLastResult() == PointImp::stype())
+        else if (mlastresult == PointImp::stype())
             doc->aMNewPoint.append(kact);
-        else if (mhier.idOfLastResult() == CircleImp::stype())
+        else if (mlastresult == CircleImp::stype())
             doc->aMNewCircle.append(kact);
-        else if (mhier.idOfLastResult()->inherits(AbstractLineImp::stype()))
+        else if (mlastresult->inherits(AbstractLineImp::stype()))
             // line or ray
             doc->aMNewLine.append(kact);
-        else if (mhier.idOfLastResult() == ConicImp::stype())
+        else if (mlastresult == ConicImp::stype())
             doc->aMNewConic.append(kact);
         else
             doc->aMNewOther.append(kact);
@@ -459,11 +515,6 @@ void MacroConstructor::plug(KigPart *doc, KigGUIAction *kact)
     doc->aMNewAll.append(kact);
 }
 
-const ObjectHierarchy &MacroConstructor::hierarchy() const
-{
-    return mhier;
-}
-
 bool SimpleObjectTypeConstructor::isTransform() const
 {
     return mtype->isTransform();
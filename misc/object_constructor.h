@@ -5,9 +5,12 @@
 #pragma once
 
 #include "argsparser.h"
+#include "macro_index.h"
 #include "object_hierarchy.h"
 #include <KLazyLocalizedString>
 
+#include <memory>
+
 class KigPainter;
 class KigDocument;
 class KigGUIAction;
@@ -278,13 +281,22 @@ public:
  */
 class MacroConstructor : public ObjectConstructor
 {
-    ObjectHierarchy mhier;
+    /**
+     * the hierarchy is built from mconstruction on first use, for
+     * macros that come from a MacroIndex..
+     */
+    mutable std::unique_ptr<ObjectHierarchy> mhier;
+    QByteArray mconstruction;
+    uint mnumberofresults;
+    const ObjectImpType *mlastresult;
     QString mname;
     QString mdesc;
     bool mbuiltin;
     QByteArray miconfile;
     ArgsParser mparser;
 
+    bool loadHierarchy() const;
+
 public:
     MacroConstructor(const std::vector<ObjectCalcer *> &input,
                      const std::vector<ObjectCalcer *> &output,
@@ -292,9 +304,18 @@ public:
                      const QString &description,
                      const QByteArray &iconfile = nullptr);
     MacroConstructor(const ObjectHierarchy &hier, const QString &name, const QString &desc, const QByteArray &iconfile = nullptr);
+    /**
+     * a MacroConstructor whose hierarchy is only built when it is
+     * first needed.  \p entry is its entry in the MacroIndex..
+     */
+    MacroConstructor(const MacroIndex::Entry &entry, const QString &name, const QString &desc);
     ~MacroConstructor();
 
-    const ObjectHierarchy &hierarchy() const;
+    /**
+     * saves the hierarchy of this macro in children xml tags of \p
+     * parent, without building it if it isn't built yet..
+     */
+    void serializeHierarchy(QDomElement &parent, QDomDocument &doc) const;
 
     const QString descriptiveName() const override;
     const QString description() const override;
@@ -6,6 +6,8 @@
 
 #include <algorithm>
 
+#include "kigprofiler.h"
+
 #include "../objects/bogus_imp.h"
 #include "../objects/object_holder.h"
 #include "../objects/object_imp.h"
@@ -30,6 +32,8 @@ public:
     virtual Node *copy() const = 0;
 
     virtual void apply(std::vector<const ObjectImp *> &stack, int loc, const KigDocument &) const = 0;
+    // the same, for a batch of stacks at once..
+    virtual void applyBatch(std::vector<std::vector<const ObjectImp *>> &stacks, int loc, const KigDocument &) const;
 
     virtual void apply(std::vector<ObjectCalcer *> &stack, int loc) const = 0;
 
@@ -52,6 +56,12 @@ ObjectHierarchy::Node::~Node()
 {
 }
 
+void ObjectHierarchy::Node::applyBatch(std::vector<std::vector<const ObjectImp *>> &stacks, int loc, const KigDocument &doc) const
+{
+    for (std::vector<std::vector<const ObjectImp *>>::iterator i = stacks.begin(); i != stacks.end(); ++i)
+        apply(*i, loc, doc);
+}
+
 class PushStackNode : public ObjectHierarchy::Node
 {
     ObjectImp *mimp;
@@ -137,6 +147,7 @@ public:
 
     int id() const override;
     void apply(std::vector<const ObjectImp *> &stack, int loc, const KigDocument &) const override;
+    void applyBatch(std::vector<std::vector<const ObjectImp *>> &stacks, int loc, const KigDocument &) const override;
     void apply(std::vector<ObjectCalcer *> &stack, int loc) const override;
 
     void checkDependsOnGiven(std::vector<bool> &dependsstack, int loc) const override;
@@ -190,6 +201,20 @@ void ApplyTypeNode::apply(std::vector<const ObjectImp *> &stack, int loc, const
     stack[loc] = mtype->calc(args, doc);
 }
 
+void ApplyTypeNode::applyBatch(std::vector<std::vector<const ObjectImp *>> &stacks, int loc, const KigDocument &doc) const
+{
+    std::vector<Args> args(stacks.size());
+    for (uint j = 0; j < stacks.size(); ++j) {
+        for (uint i = 0; i < mparents.size(); ++i)
+            args[j].push_back(stacks[j][mparents[i]]);
+        args[j] = mtype->sortArgs(args[j]);
+    }
+    std::vector<ObjectImp *> results = mtype->calcBatch(args, doc);
+    assert(results.size() == stacks.size());
+    for (uint j = 0; j < stacks.size(); ++j)
+        stacks[j][loc] = results[j];
+}
+
 class FetchPropertyNode : public ObjectHierarchy::Node
 {
     mutable int mpropgid;
@@ -275,6 +300,7 @@ std::vector<ObjectImp *> ObjectHierarchy::calc(const Args &a, const KigDocument
     for (uint i = 0; i < a.size(); ++i)
         assert(a[i]->inherits(margrequirements[i]));
 
+    KigProfiler::Scope prof(this);
     std::vector<const ObjectImp *> stack;
     stack.resize(mnodes.size() + mnumberofargs, nullptr);
     std::copy(a.begin(), a.end(), stack.begin());
@@ -295,6 +321,32 @@ std::vector<ObjectImp *> ObjectHierarchy::calc(const Args &a, const KigDocument
     };
 }
 
+std::vector<std::vector<ObjectImp *>> ObjectHierarchy::calcBatch(const std::vector<Args> &a, const KigDocument &doc) const
+{
+    KigProfiler::Scope prof(this);
+    std::vector<std::vector<const ObjectImp *>> stacks(a.size());
+    for (uint j = 0; j < a.size(); ++j) {
+        assert(a[j].size() == mnumberofargs);
+        stacks[j].resize(mnodes.size() + mnumberofargs, nullptr);
+        std::copy(a[j].begin(), a[j].end(), stacks[j].begin());
+    }
+    for (uint i = 0; i < mnodes.size(); ++i)
+        mnodes[i]->applyBatch(stacks, mnumberofargs + i, doc);
+
+    std::vector<std::vector<ObjectImp *>> ret(a.size());
+    for (uint j = 0; j < a.size(); ++j) {
+        std::vector<const ObjectImp *> &stack = stacks[j];
+        for (uint i = mnumberofargs; i < stack.size() - mnumberofresults; ++i)
+            delete stack[i];
+        if (stack.size() < mnumberofargs + mnumberofresults)
+            ret[j].push_back(new InvalidImp);
+        else
+            for (uint i = stack.size() - mnumberofresults; i < stack.size(); ++i)
+                ret[j].push_back(const_cast<ObjectImp *>(stack[i]));
+    }
+    return ret;
+}
+
 int ObjectHierarchy::visit(const ObjectCalcer *o, std::map<const ObjectCalcer *, int> &seenmap, bool needed, bool neededatend)
 {
     using namespace std;
@@ -592,16 +644,21 @@ ObjectHierarchy *ObjectHierarchy::buildSafeObjectHierarchy(const QDomElement &pa
 }
 
 ArgsParser ObjectHierarchy::argParser() const
+{
+    return argParser(margrequirements, musetexts, mselectstatements);
+}
+
+ArgsParser ObjectHierarchy::argParser(const std::vector<const ObjectImpType *> &requirements, const QString &usetexts, const QString &selectstatements)
 {
     std::vector<ArgsParser::spec> specs;
-    for (uint i = 0; i < margrequirements.size(); ++i) {
-        const ObjectImpType *req = margrequirements[i];
+    for (uint i = 0; i < requirements.size(); ++i) {
+        const ObjectImpType *req = requirements[i];
         ArgsParser::spec spec;
         spec.type = req;
         char translateUseTextChar[1024]; // check arbitrary
         char translateSelectStatChar[1024]; // check arbitrary
-        translateUseTextChar[0] = static_cast<char>(musetexts[i].toLatin1());
-        translateSelectStatChar[0] = static_cast<char>(mselectstatements[i].toLatin1());
+        translateUseTextChar[0] = static_cast<char>(usetexts[i].toLatin1());
+        translateSelectStatChar[0] = static_cast<char>(selectstatements[i].toLatin1());
         spec.usetext = kli18n(translateUseTextChar);
         spec.selectstat = kli18n(translateSelectStatChar);
         specs.push_back(spec);
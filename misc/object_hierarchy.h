@@ -34,6 +34,7 @@ private:
     int storeObject(const ObjectCalcer *, const std::vector<ObjectCalcer *> &po, std::vector<int> &pl, std::map<const ObjectCalcer *, int> &seenmap);
 
     friend bool operator==(const ObjectHierarchy &lhs, const ObjectHierarchy &rhs);
+    friend class KigProfiler;
 
     void init(const std::vector<ObjectCalcer *> &from, const std::vector<ObjectCalcer *> &to);
 
@@ -62,6 +63,12 @@ public:
     ObjectHierarchy withFixedArgs(const Args &a) const;
 
     std::vector<ObjectImp *> calc(const Args &a, const KigDocument &doc) const;
+    /**
+     * calc() for every one of \p a, node by node, so that every type in
+     * the hierarchy gets all of its arguments in one
+     * ObjectType::calcBatch() call..
+     */
+    std::vector<std::vector<ObjectImp *>> calcBatch(const std::vector<Args> &a, const KigDocument &doc) const;
 
     /**
      * saves the ObjectHierarchy data in children xml tags of \p parent .
@@ -85,6 +92,12 @@ public:
     std::vector<ObjectCalcer *> buildObjects(const std::vector<ObjectCalcer *> &os, const KigDocument &) const;
 
     ArgsParser argParser() const;
+    /**
+     * the ArgsParser for a hierarchy with the given argument
+     * requirements, use texts and select statements, so that it can be
+     * built without the hierarchy itself..
+     */
+    static ArgsParser argParser(const std::vector<const ObjectImpType *> &requirements, const QString &usetexts, const QString &selectstatements);
 
     uint numberOfArgs() const
     {
@@ -9,9 +9,12 @@
 
 #include "ui_historywidget.h"
 
+#include "../kig/kig_commands.h"
+
 #include <QDialogButtonBox>
 #include <QIcon>
 #include <QIntValidator>
+#include <QLocale>
 #include <QPushButton>
 #include <QUndoStack>
 #include <QVBoxLayout>
@@ -44,8 +47,8 @@ HistoryDialog::HistoryDialog(QUndoStack *kch, QWidget *parent)
     mwidget->buttonBack->setIcon(QIcon::fromTheme(reversed ? "go-next" : "go-previous"));
     connect(mwidget->buttonBack, &QAbstractButton::clicked, this, &HistoryDialog::goBack);
 
-    mwidget->editStep->setValidator(new QIntValidator(1, mtotalsteps, mwidget->editStep));
-    mwidget->labelSteps->setText(QString::number(mtotalsteps));
+    mvalidator = new QIntValidator(1, mtotalsteps, mwidget->editStep);
+    mwidget->editStep->setValidator(mvalidator);
 
     mwidget->buttonNext->setIcon(QIcon::fromTheme(reversed ? "go-previous" : "go-next"));
     connect(mwidget->buttonNext, &QAbstractButton::clicked, this, &HistoryDialog::goToNext);
@@ -99,6 +102,12 @@ void HistoryDialog::goToLast()
 
 void HistoryDialog::updateWidgets()
 {
+    // the oldest steps may have been dropped to save memory..
+    mtotalsteps = mch->count() + 1;
+    mvalidator->setTop(mtotalsteps);
+    mwidget->labelSteps->setText(QString::number(mtotalsteps));
+    mwidget->labelMemory->setText(i18n("Memory used by the history: %1", QLocale().formattedDataSize(static_cast<qint64>(KigCommand::memoryUsage(*mch)))));
+
     int currentstep = mch->index() + 1;
 
     mwidget->editStep->setText(QString::number(currentstep));
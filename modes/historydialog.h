@@ -7,6 +7,7 @@
 
 #pragma once
 
+class QIntValidator;
 class QUndoStack;
 class QWidget;
 class Ui_HistoryWidget;
@@ -37,6 +38,7 @@ private:
     QUndoStack *mch;
 
     Ui_HistoryWidget *mwidget;
+    QIntValidator *mvalidator;
 
     int mtotalsteps;
 };
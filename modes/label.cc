@@ -176,8 +176,12 @@ void TextLabelModeBase::leftReleased(QMouseEvent *e, KigWidget *v, ObjectTypeCal
         else if (result == 0) {
             argcalcer = o->nameCalcer();
             if (!argcalcer) {
+                // naming the object is a change to the document of its
+                // own, it has to be undoable and journaled..
                 ObjectConstCalcer *c = new ObjectConstCalcer(new StringImp(i18n("<unnamed object>")));
-                o->setNameCalcer(c);
+                KigCommand *kc = new KigCommand(mdoc, i18n("Set Object Name"));
+                kc->addTask(new ChangeObjectNameTask(o, c));
+                mdoc.history()->push(kc);
                 argcalcer = c;
             }
         } else {
@@ -13,6 +13,7 @@
 #include "../misc/calcpaths.h"
 #include "../misc/coordinate_system.h"
 #include "../misc/kigpainter.h"
+#include "../misc/kigtracer.h"
 #include "../objects/object_factory.h"
 #include "../objects/object_imp.h"
 
@@ -41,8 +42,9 @@ void MovingModeBase::initScreen(const std::vector<ObjectCalcer *> &in)
     std::set_difference(docobjsset.begin(), docobjsset.end(), drawableset.begin(), drawableset.end(), std::inserter(notmovingobjs, notmovingobjs.begin()));
 
     mview.clearStillPix();
+    mview.drawGrid();
     KigPainter p(mview.screenInfo(), &mview.stillPix, mdoc.document());
-    p.drawGrid(mdoc.document().coordinateSystem(), mdoc.document().grid(), mdoc.document().axes());
+    p.setWholeWinOverlay();
     p.drawObjects(notmovingobjs.begin(), notmovingobjs.end(), false);
     mview.updateCurPix();
 
@@ -71,9 +73,15 @@ void MovingModeBase::mouseMoved(QMouseEvent *e, KigWidget *v)
     Coordinate c = v->fromScreen(e->pos());
 
     bool snaptogrid = e->modifiers() & Qt::ShiftModifier;
-    moveTo(c, snaptogrid);
-    for (std::vector<ObjectCalcer *>::iterator i = mcalcable.begin(); i != mcalcable.end(); ++i)
-        (*i)->calc(mdoc.document());
+    {
+        KigTracer::Span span("moveTo", "mode");
+        moveTo(c, snaptogrid);
+    }
+    {
+        KigTracer::Span span("recompute", "calc");
+        for (std::vector<ObjectCalcer *>::iterator i = mcalcable.begin(); i != mcalcable.end(); ++i)
+            (*i)->calc(mdoc.document());
+    }
     KigPainter p(v->screenInfo(), &v->curPix, mdoc.document());
     // TODO: only draw the explicitly moving objects as selected, the
     // other ones as deselected. Needs some support from the
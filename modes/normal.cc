@@ -20,6 +20,8 @@
 #include "popup/popup.h"
 #include "typesdialog.h"
 
+#include <QMouseEvent>
+
 
 #include <algorithm>
 #include <functional>
@@ -93,6 +95,7 @@ void NormalMode::redrawScreen(KigWidget *w)
     const std::set<ObjectHolder *> docobjs = mdoc.document().objectsSet();
     std::set_intersection(docobjs.begin(), docobjs.end(), sos.begin(), sos.end(), std::back_inserter(nsos));
     sos = std::set<ObjectHolder *>(nsos.begin(), nsos.end());
+    resetHover();
     w->redrawScreen(nsos, true);
     w->updateScrollBars();
 }
@@ -114,6 +117,19 @@ void NormalMode::browseHistory()
 NormalMode::NormalMode(KigPart &d)
     : BaseMode(d)
 {
+    resetHover();
+}
+
+void NormalMode::resetHover()
+{
+    mhovervalid = false;
+    mhoverwidget = nullptr;
+    mhoveros.clear();
+    mhoverstatos.clear();
+    mhoverstat.clear();
+    // we don't know what is on the screen anymore, so the next move
+    // has to clean up anyway..
+    mhovershown = true;
 }
 
 NormalMode::~NormalMode()
@@ -221,32 +237,60 @@ void NormalMode::rightClicked(const std::vector<ObjectHolder *> &os, const QPoin
     };
 }
 
+void NormalMode::mouseMoved(QMouseEvent *e, KigWidget *w)
+{
+    // the size in pixels of the cells in which we consider the cursor
+    // to be over the same objects..
+    static const int hoverCellSize = 3;
+
+    const QPoint cell(e->pos().x() / hoverCellSize, e->pos().y() / hoverCellSize);
+    if (!mhovervalid || mhoverwidget != w || mhovercell != cell) {
+        mhoveros = mdoc.document().whatAmIOn(w->fromScreen(e->pos()), *w);
+        mhoverwidget = w;
+        mhovercell = cell;
+        mhovervalid = true;
+    }
+    mouseMoved(mhoveros, e->pos(), *w, e->modifiers() & Qt::ShiftModifier);
+}
+
 void NormalMode::mouseMoved(const std::vector<ObjectHolder *> &os, const QPoint &plc, KigWidget &w, bool)
 {
-    w.updateCurPix();
     if (os.empty()) {
+        // nothing was shown the last time either, so there's nothing to
+        // clean up..
+        if (!mhovershown)
+            return;
+        w.updateCurPix();
         w.setCursor(Qt::ArrowCursor);
         mdoc.emitStatusBarText(nullptr);
         w.updateWidget();
+        mhoverstatos.clear();
+        mhoverstat.clear();
+        mhovershown = false;
     } else {
+        w.updateCurPix();
         // the cursor is over an object, show object type next to cursor
         // and set statusbar text
 
         w.setCursor(Qt::PointingHandCursor);
 
-        int id = ObjectChooserPopup::getObjectFromList(plc, &w, os, false);
-        QString stat = id == 0 ? os.front()->selectStatement() : i18n("Which object?");
+        if (os != mhoverstatos || mhoverstat.isNull()) {
+            int id = ObjectChooserPopup::getObjectFromList(plc, &w, os, false);
+            mhoverstat = id == 0 ? os.front()->selectStatement() : i18n("Which object?");
+            mhoverstatos = os;
 
-        // statusbar text
-        mdoc.emitStatusBarText(stat);
+            // statusbar text
+            mdoc.emitStatusBarText(mhoverstat);
+        }
         KigPainter p(w.screenInfo(), &w.curPix, mdoc.document());
 
         // set the text next to the arrow cursor
         QPoint point = plc;
         point.setX(point.x() + 15);
 
-        p.drawTextStd(point, stat);
+        p.drawTextStd(point, mhoverstat);
         w.updateWidget(p.overlay());
+        mhovershown = true;
     };
 }
 
@@ -7,7 +7,9 @@
 #include "base_mode.h"
 
 #include <QPoint>
+#include <QString>
 #include <set>
+#include <vector>
 
 class NormalMode : public BaseMode
 {
@@ -16,9 +18,10 @@ public:
     ~NormalMode();
 
     using BaseMode::midClicked;
-    using BaseMode::mouseMoved;
     using BaseMode::rightClicked;
 
+    void mouseMoved(QMouseEvent *e, KigWidget *v) override;
+
 protected:
     void dragRect(const QPoint &p, KigWidget &w) override;
     void dragObject(const std::vector<ObjectHolder *> &os, const QPoint &pointClickedOn, KigWidget &w, bool ctrlOrShiftDown) override;
@@ -57,4 +60,25 @@ protected:
      * selected objects...
      */
     std::set<ObjectHolder *> sos;
+
+private:
+    /**
+     * the objects under the cursor, when it was last in the cell
+     * mhovercell of mhoverwidget.  While the cursor stays in that cell
+     * and the document doesn't change ( redrawScreen() resets all of
+     * this ), we don't need to look for them again.
+     */
+    bool mhovervalid;
+    const KigWidget *mhoverwidget;
+    QPoint mhovercell;
+    std::vector<ObjectHolder *> mhoveros;
+    /**
+     * the objects for which we have shown mhoverstat, and whether we
+     * are showing anything at all...
+     */
+    std::vector<ObjectHolder *> mhoverstatos;
+    QString mhoverstat;
+    bool mhovershown;
+
+    void resetHover();
 };
@@ -23,7 +23,7 @@
 
 #include <QInputDialog>
 
-void addNameLabel(ObjectCalcer *object, ObjectCalcer *namecalcer, const Coordinate &loc, KigPart &doc)
+static void addNameLabel(ObjectCalcer *object, ObjectCalcer *namecalcer, const Coordinate &loc, KigPart &doc, KigCommand *kc)
 {
     std::vector<ObjectCalcer *> args;
     args.push_back(namecalcer);
@@ -32,7 +32,7 @@ void addNameLabel(ObjectCalcer *object, ObjectCalcer *namecalcer, const Coordina
     if (object->imp()->inherits(PointImp::stype()) || object->imp()->attachPoint().valid() || object->imp()->inherits(CurveImp::stype()))
         attachto = object;
     ObjectHolder *label = ObjectFactory::instance()->attachedLabel(QStringLiteral("%1"), attachto, loc, namelabelneedsframe, args, doc.document());
-    doc.addObject(label);
+    kc->addTask(new AddObjectsTask(std::vector<ObjectHolder *>(1, label)));
 }
 
 void NameObjectActionsProvider::fillUpMenu(NormalModePopupObjects &popup, int menu, int &nextfree)
@@ -62,29 +62,27 @@ bool NameObjectActionsProvider::executeAction(int menu,
         bool ok;
         name = QInputDialog::getText(&w, i18n("Set Object Name"), i18n("Set Name of this Object:"), QLineEdit::Normal, name, &ok);
         if (ok) {
-            bool justadded = false;
-            ObjectCalcer *namecalcer = os[0]->nameCalcer();
-            if (!namecalcer) {
-                justadded = true;
-                ObjectConstCalcer *c = new ObjectConstCalcer(new StringImp(i18n("<unnamed object>")));
-                os[0]->setNameCalcer(c);
-                namecalcer = c;
-            }
-            assert(dynamic_cast<ObjectConstCalcer *>(namecalcer));
-            ObjectConstCalcer *cnamecalcer = static_cast<ObjectConstCalcer *>(os[0]->nameCalcer());
-            MonitorDataObjects mon(cnamecalcer);
-            cnamecalcer->setImp(new StringImp(name));
+            // the name is given in a command, so that it can be undone,
+            // and reaches the journal..
             KigCommand *kc = new KigCommand(doc, i18n("Set Object Name"));
-            mon.finish(kc);
-            doc.history()->push(kc);
-
-            // if we just added the name, we add a label to show it to the user.
-            if (justadded)
+            ObjectConstCalcer *namecalcer = os[0]->nameCalcer();
+            if (!namecalcer) {
+                namecalcer = new ObjectConstCalcer(new StringImp(name));
+                kc->addTask(new ChangeObjectNameTask(os[0], namecalcer));
+                // we just added the name, so we add a label to show it
+                // to the user.
                 addNameLabel(os[0]->calcer(),
                              namecalcer,
                              //                    w.fromScreen( w.mapFromGlobal( popup.mapToGlobal( QPoint( 5, 0 ) ) ) ),
                              w.fromScreen(popup.plc()),
-                             doc);
+                             doc,
+                             kc);
+            } else {
+                MonitorDataObjects mon(namecalcer);
+                namecalcer->setImp(new StringImp(name));
+                mon.finish(kc);
+            }
+            doc.history()->push(kc);
         }
         return true;
     } else if (menu == NormalModePopupObjects::ShowMenu) {
@@ -93,17 +91,19 @@ bool NameObjectActionsProvider::executeAction(int menu,
             return false;
         }
         assert(os.size() == 1);
-        ObjectCalcer *namecalcer = os[0]->nameCalcer();
+        KigCommand *kc = new KigCommand(doc, i18n("Show Object Name"));
+        ObjectConstCalcer *namecalcer = os[0]->nameCalcer();
         if (!namecalcer) {
-            ObjectConstCalcer *c = new ObjectConstCalcer(new StringImp(i18n("<unnamed object>")));
-            os[0]->setNameCalcer(c);
-            namecalcer = c;
+            namecalcer = new ObjectConstCalcer(new StringImp(i18n("<unnamed object>")));
+            kc->addTask(new ChangeObjectNameTask(os[0], namecalcer));
         }
         addNameLabel(os[0]->calcer(),
                      namecalcer,
-                     //                  w.fromScreen( w.mapFromGlobal( popup.mapToGlobal( QPoint( 5, 0 ) ) ) ), doc );
+                     //                  w.fromScreen( w.mapFromGlobal( popup.mapToGlobal( QPoint( 5, 0 ) ) ), doc );
                      w.fromScreen(popup.plc()),
-                     doc);
+                     doc,
+                     kc);
+        doc.history()->push(kc);
         return true;
     } else {
         return false;
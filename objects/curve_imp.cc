@@ -120,6 +120,15 @@ double CurveImp::getDist(double param, const Coordinate &p, const KigDocument &d
     return p1.valid() ? (p1 - p).length() : +double_inf;
 }
 
+std::vector<Coordinate> CurveImp::getPoints(const std::vector<double> &params, const KigDocument &doc) const
+{
+    std::vector<Coordinate> ret;
+    ret.reserve(params.size());
+    for (std::vector<double>::const_iterator i = params.begin(); i != params.end(); ++i)
+        ret.push_back(getPoint(*i, doc));
+    return ret;
+}
+
 double CurveImp::getParam(const Coordinate &p, const KigDocument &doc) const
 {
     // this function ( and related functions like getInterval etc. ) is
@@ -149,13 +158,19 @@ double CurveImp::getParam(const Coordinate &p, const KigDocument &doc) const
     const int N = 64;
     const double incr = 1. / (double)N;
 
+    // the starting points are all sampled in one go..
+    std::vector<double> params;
+    for (int j = 0; j < N + 1; j++)
+        params.push_back(j * incr);
+    const std::vector<Coordinate> samples = getPoints(params, doc);
+
     // xm is the best parameter we've found so far, fxm is the distance
     // to the locus from that point.  We start with some
     // pseudo-values.
     // (mp) note that if the distance is actually increasing in the
     // whole interval [0,1] this value will be returned in the end.
     double xm = 0.;
-    double fxm = getDist(xm, p, doc);
+    double fxm = samples[0].valid() ? (samples[0] - p).length() : +double_inf;
     double x1, x2;
 
     double mm[N + 1];
@@ -166,7 +181,7 @@ double CurveImp::getParam(const Coordinate &p, const KigDocument &doc) const
         x1 = j * incr;
 
         // check the range x1,x2 for the first local maximum..
-        double mm1 = getDist(x1, p, doc);
+        double mm1 = samples[j].valid() ? (samples[j] - p).length() : +double_inf;
         if (mm1 < fxm) {
             xm = x1;
             fxm = mm1;
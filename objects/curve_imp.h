@@ -40,6 +40,10 @@ public:
     // the curve.  You can return an invalid Coordinate(
     // Coordinate::invalidCoord() ) if you need to in some cases.
     virtual const Coordinate getPoint(double param, const KigDocument &) const = 0;
+    // getPoint() for all of params at once.  Curves that are expensive
+    // to evaluate point by point, like loci through python scripts,
+    // override this to do all the work in one go.
+    virtual std::vector<Coordinate> getPoints(const std::vector<double> &params, const KigDocument &) const;
 
     CurveImp *copy() const override = 0;
 
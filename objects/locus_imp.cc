@@ -68,6 +68,36 @@ const Coordinate LocusImp::getPoint(double param, const KigDocument &doc) const
     return ret;
 }
 
+std::vector<Coordinate> LocusImp::getPoints(const std::vector<double> &params, const KigDocument &doc) const
+{
+    std::vector<Coordinate> ret = mcurve->getPoints(params, doc);
+    // only the valid points of the curve go through the hierarchy, all
+    // of them at once..
+    std::vector<PointImp *> argimps;
+    std::vector<Args> args;
+    std::vector<uint> which;
+    for (uint i = 0; i < ret.size(); ++i) {
+        if (!ret[i].valid())
+            continue;
+        argimps.push_back(new PointImp(ret[i]));
+        args.push_back(Args(1, argimps.back()));
+        which.push_back(i);
+    }
+    vector<vector<ObjectImp *>> calcret = mhier.calcBatch(args, doc);
+    for (uint j = 0; j < calcret.size(); ++j) {
+        assert(calcret[j].size() == 1);
+        ObjectImp *imp = calcret[j].front();
+        if (imp->inherits(PointImp::stype())) {
+            doc.mcachedparam = params[which[j]];
+            ret[which[j]] = static_cast<PointImp *>(imp)->coordinate();
+        } else
+            ret[which[j]] = Coordinate::invalidCoord();
+        delete imp;
+    }
+    delete_all(argimps.begin(), argimps.end());
+    return ret;
+}
+
 LocusImp::LocusImp(CurveImp *curve, const ObjectHierarchy &hier)
     : mcurve(curve)
     , mhier(hier)
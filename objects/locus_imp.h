@@ -62,6 +62,7 @@ public:
     Rect surroundingRect() const override;
     bool inRect(const Rect &r, int width, const KigWidget &) const override;
     const Coordinate getPoint(double param, const KigDocument &) const override;
+    std::vector<Coordinate> getPoints(const std::vector<double> &params, const KigDocument &) const override;
 
     // TODO ?
     int numberOfProperties() const override;
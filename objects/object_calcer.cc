@@ -5,6 +5,7 @@
 #include "object_calcer.h"
 
 #include "../misc/coordinate.h"
+#include "../misc/kigprofiler.h"
 #include "bogus_imp.h"
 #include "common.h"
 #include "object_holder.h"
@@ -18,6 +19,7 @@
 
 void ObjectTypeCalcer::calc(const KigDocument &doc)
 {
+    KigProfiler::Scope prof(mtype);
     Args a;
     a.reserve(mparents.size());
     std::transform(mparents.begin(), mparents.end(), std::back_inserter(a), std::mem_fn(&ObjectCalcer::imp));
@@ -173,6 +175,7 @@ void ObjectPropertyCalcer::calc(const KigDocument &doc)
         mparenttype = &typeid(*(mparent->imp()));
         //    printf ("changing type, new type: %s\n", mparenttype->internalName());
     }
+    KigProfiler::Scope prof(mpropgid);
     ObjectImp *n;
     if (mpropid >= 0) {
         n = mparent->imp()->property(mpropid, doc);
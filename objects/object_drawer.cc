@@ -5,6 +5,7 @@
 #include "object_drawer.h"
 
 #include "../misc/kigpainter.h"
+#include "../misc/kigprofiler.h"
 #include "object_imp.h"
 
 #include <QPen>
@@ -24,6 +25,7 @@ void ObjectDrawer::draw(const ObjectImp &imp, KigPainter &p, bool sel) const
         p.setPointStyle(mpointstyle);
         p.setFont(mfont);
         p.setSelected(sel);
+        KigProfiler::Scope prof(imp.type());
         imp.draw(p);
     }
 }
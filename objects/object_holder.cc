@@ -144,6 +144,13 @@ void ObjectHolder::setNameCalcer(ObjectConstCalcer *namecalcer)
     mnamecalcer = namecalcer;
 }
 
+ObjectConstCalcer::shared_ptr ObjectHolder::switchNameCalcer(ObjectConstCalcer *namecalcer)
+{
+    ObjectConstCalcer::shared_ptr old = mnamecalcer;
+    mnamecalcer = namecalcer;
+    return old;
+}
+
 QString ObjectHolder::selectStatement() const
 {
     const QString n = name();
@@ -61,6 +61,13 @@ public:
      * no name is set.
      */
     void setNameCalcer(ObjectConstCalcer *namecalcer);
+    /**
+     * Set the namecalcer of this ObjectHolder to \p namecalcer, which
+     * may be zero, and return the old one.  This is for
+     * ChangeObjectNameTask, which needs to be able to undo naming an
+     * object..
+     */
+    ObjectConstCalcer::shared_ptr switchNameCalcer(ObjectConstCalcer *namecalcer);
 
     /**
      * returns a null QString if no name is set.
@@ -7,8 +7,12 @@
 #include "bogus_imp.h"
 
 #include "../misc/coordinate.h"
+#include "../misc/kigprofiler.h"
 
 #include <KLazyLocalizedString>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QWriteLocker>
 #include <map>
 
 class ObjectImpType::StaticPrivate
@@ -19,6 +23,14 @@ public:
 
 ObjectImp::ObjectImp()
 {
+    if (KigProfiler::enabled())
+        KigProfiler::countImp();
+}
+
+ObjectImp::ObjectImp(const ObjectImp &)
+{
+    if (KigProfiler::enabled())
+        KigProfiler::countImp();
 }
 
 ObjectImp::~ObjectImp()
@@ -320,33 +332,50 @@ bool ObjectImp::isPropertyDefinedOnOrThroughThisImp(int) const
 }
 
 static QByteArrayList propertiesGlobalInternalNames;
+// the batch exporter builds and calculates documents on more than one
+// thread, and any of them may add a name to the table..
+static QReadWriteLock propertiesGlobalInternalNamesLock;
 
 int ObjectImp::getPropGid(const char *pname) const
 {
-    int wp = propertiesGlobalInternalNames.indexOf(pname);
-    if (wp >= 0)
-        return wp;
+    {
+        QReadLocker l(&propertiesGlobalInternalNamesLock);
+        int wp = propertiesGlobalInternalNames.indexOf(pname);
+        if (wp >= 0)
+            return wp;
+    }
 
     int lp = propertiesInternalNames().indexOf(pname);
     if (lp < 0)
         return lp; // insist that this exists as a property
 
+    QWriteLocker l(&propertiesGlobalInternalNamesLock);
+    // another thread may have added it in the meantime..
+    int wp = propertiesGlobalInternalNames.indexOf(pname);
+    if (wp >= 0)
+        return wp;
     propertiesGlobalInternalNames << pname;
-    wp = propertiesGlobalInternalNames.indexOf(pname);
-    assert(wp >= 0);
-    return wp;
+    return propertiesGlobalInternalNames.size() - 1;
 }
 
 int ObjectImp::getPropLid(int propgid) const
 {
-    assert(propgid >= 0 && propgid < propertiesGlobalInternalNames.size());
-    int proplid = propertiesInternalNames().indexOf(propertiesGlobalInternalNames[propgid]);
+    QByteArray name;
+    {
+        QReadLocker l(&propertiesGlobalInternalNamesLock);
+        assert(propgid >= 0 && propgid < propertiesGlobalInternalNames.size());
+        name = propertiesGlobalInternalNames.at(propgid);
+    }
+    int proplid = propertiesInternalNames().indexOf(name);
     //  printf ("getPropLid: converting %d in %d\n", propgid, proplid);
     return proplid;
 }
 
-const char *ObjectImp::getPropName(int propgid) const
+const char *ObjectImp::getPropName(int propgid)
 {
+    // the names are never removed, so their data stays where it is when
+    // the list grows..
+    QReadLocker l(&propertiesGlobalInternalNamesLock);
     assert(propgid >= 0 && propgid < propertiesGlobalInternalNames.size());
-    return propertiesGlobalInternalNames[propgid];
+    return propertiesGlobalInternalNames.at(propgid).constData();
 }
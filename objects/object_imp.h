@@ -218,6 +218,7 @@ class ObjectImp
 {
 protected:
     ObjectImp();
+    ObjectImp(const ObjectImp &);
 
 public:
     /**
@@ -266,7 +267,7 @@ public:
      */
     int getPropLid(int propgid) const;
     int getPropGid(const char *pname) const;
-    const char *getPropName(int propgid) const;
+    static const char *getPropName(int propgid);
 
     virtual ~ObjectImp();
 
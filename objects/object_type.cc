@@ -72,6 +72,15 @@ bool ObjectType::isTransform() const
     return false;
 }
 
+std::vector<ObjectImp *> ObjectType::calcBatch(const std::vector<Args> &parents, const KigDocument &d) const
+{
+    std::vector<ObjectImp *> ret;
+    ret.reserve(parents.size());
+    for (std::vector<Args>::const_iterator i = parents.begin(); i != parents.end(); ++i)
+        ret.push_back(calc(*i, d));
+    return ret;
+}
+
 QList<KLazyLocalizedString> ObjectType::specialActions() const
 {
     return QList<KLazyLocalizedString>();
@@ -30,6 +30,13 @@ public:
     virtual bool inherits(int type) const;
 
     virtual ObjectImp *calc(const Args &parents, const KigDocument &d) const = 0;
+    /**
+     * calc() every one of \p parents, the results are in the same
+     * order.  Types that pay a large fixed cost for every calc(), like
+     * PythonExecuteType, can override this to pay it once per batch.
+     * This is used when a locus is sampled..
+     */
+    virtual std::vector<ObjectImp *> calcBatch(const std::vector<Args> &parents, const KigDocument &d) const;
 
     virtual bool canMove(const ObjectTypeCalcer &ourobj) const;
     virtual bool isFreelyTranslatable(const ObjectTypeCalcer &ourobj) const;
@@ -37,8 +37,13 @@ ObjectImp *TextImp::transform(const Transformation &t) const
 
 void TextImp::draw(KigPainter &p) const
 {
-    mboundrect = p.simpleBoundingRect(mloc, mtext);
-    p.drawTextFrame(mboundrect, mtext, mframe);
+    if (mlayout.text() != mtext || mlayoutfont != p.font()) {
+        mlayoutfont = p.font();
+        mlayout.setText(mtext);
+        mlayout.setTextFormat(Qt::PlainText);
+        mlayout.prepare(QTransform(), mlayoutfont);
+    }
+    mboundrect = p.drawTextFrame(mloc, mlayout, mframe);
 }
 
 bool TextImp::contains(const Coordinate &p, int, const KigWidget &) const
@@ -9,6 +9,9 @@
 #include "../misc/coordinate.h"
 #include "../misc/rect.h"
 
+#include <QFont>
+#include <QStaticText>
+
 class TextImp : public ObjectImp
 {
     QString mtext;
@@ -17,6 +20,10 @@ class TextImp : public ObjectImp
     // with this var, we keep track of the place we drew in, for use in
     // the contains() function..
     mutable Rect mboundrect;
+    // the text laid out in mlayoutfont, so that we don't need to measure
+    // it again every time we draw it..
+    mutable QStaticText mlayout;
+    mutable QFont mlayoutfont;
 
 public:
     typedef ObjectImp Parent;
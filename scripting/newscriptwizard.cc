@@ -100,6 +100,11 @@ NewScriptWizard::NewScriptWizard(QWidget *parent, ScriptModeBase *mode, KIconLoa
         docview->setContextMenu(menu);
     }
 
+    mLabelStatistics = new QLabel(secondPage);
+    mLabelStatistics->setWordWrap(true);
+    mLabelStatistics->hide();
+    lay2->addWidget(mLabelStatistics);
+
     connect(this, SIGNAL(currentIdChanged(int)), this, SLOT(currentIdChanged(int)));
     connect(this, &QWizard::helpRequested, this, &NewScriptWizard::slotHelpClicked);
 }
@@ -151,6 +156,12 @@ void NewScriptWizard::setText(const QString &text)
     }
 }
 
+void NewScriptWizard::setStatistics(const QString &statistics)
+{
+    mLabelStatistics->setText(statistics);
+    mLabelStatistics->setVisible(!statistics.isEmpty());
+}
+
 QString NewScriptWizard::text() const
 {
     if (!document) {
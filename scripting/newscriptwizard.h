@@ -33,6 +33,11 @@ public:
     QString text() const;
 
     void setType(ScriptType::Type type);
+    /**
+     * show \p statistics about how the script did so far below the
+     * code, or nothing if it is empty..
+     */
+    void setStatistics(const QString &statistics);
 
 public Q_SLOTS:
     void accept() override;
@@ -44,6 +49,7 @@ protected Q_SLOTS:
 
 protected:
     QLabel *mLabelFillCode;
+    QLabel *mLabelStatistics;
     QTextEdit *textedit;
     KTextEditor::Document *document;
     KTextEditor::View *docview;
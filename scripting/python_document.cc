@@ -0,0 +1,217 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Python.h has to come before the Qt headers, see python_scripter.cc..
+// krazy:excludeall=includes
+#undef _XOPEN_SOURCE // it will be defined inside Python
+#include <Python.h>
+
+#include "python_document.h"
+
+#include "../filters/batchexporter.h"
+#include "../filters/filter.h"
+#include "../kig/kig_document.h"
+#include "../misc/calcpaths.h"
+#include "../misc/coordinate.h"
+#include "../objects/bogus_imp.h"
+#include "../objects/object_drawer.h"
+#include "../objects/object_factory.h"
+#include "../objects/object_holder.h"
+#include "../objects/object_imp.h"
+#include "../objects/object_type.h"
+#include "../objects/object_type_factory.h"
+
+#include <QMimeDatabase>
+#include <QSize>
+#include <QString>
+
+using namespace boost::python;
+
+/**
+ * raise a python exception of type \p type with the message \p msg..
+ */
+static void raise(PyObject *type, const QString &msg)
+{
+    PyErr_SetString(type, msg.toUtf8().constData());
+    throw_error_already_set();
+}
+
+static void calcAll(KigDocument &doc)
+{
+    std::vector<ObjectCalcer *> tmp = calcPath(getAllParents(getAllCalcers(doc.objects())));
+    for (std::vector<ObjectCalcer *>::iterator i = tmp.begin(); i != tmp.end(); ++i)
+        (*i)->calc(doc);
+}
+
+PythonCalcer::PythonCalcer(ObjectCalcer *c)
+    : calcer(c)
+{
+}
+
+ObjectImp *PythonCalcer::imp() const
+{
+    return calcer->imp()->copy();
+}
+
+PythonDocument::PythonDocument()
+    : mdoc(new KigDocument)
+{
+}
+
+PythonDocument::PythonDocument(KigDocument *doc)
+    : mdoc(doc)
+{
+}
+
+PythonDocument::~PythonDocument()
+{
+    delete mdoc;
+}
+
+PythonDocument *PythonDocument::load(const std::string &file)
+{
+    const QString path = QString::fromStdString(file);
+    const QMimeDatabase mimeDb;
+    KigFilter *filter = KigFilters::instance()->find(mimeDb.mimeTypeForFile(path).name());
+    if (!filter)
+        raise(PyExc_ValueError, QStringLiteral("the type of the file \"%1\" is not supported by Kig").arg(path));
+    KigDocument *doc = filter->load(path);
+    if (!doc)
+        raise(PyExc_IOError, QStringLiteral("could not read the file \"%1\"").arg(path));
+    // some of the filters build the hierarchy out of order..
+    calcAll(*doc);
+    return new PythonDocument(doc);
+}
+
+PythonCalcer PythonDocument::constant(const ObjectImp &imp)
+{
+    return PythonCalcer(new ObjectConstCalcer(imp.copy()));
+}
+
+PythonCalcer PythonDocument::fixedPoint(const Coordinate &c)
+{
+    ObjectCalcer *ret = ObjectFactory::instance()->fixedPointCalcer(c);
+    ret->calc(*mdoc);
+    return PythonCalcer(ret);
+}
+
+PythonCalcer PythonDocument::object(const std::string &type, const list &parents)
+{
+    const ObjectType *t = ObjectTypeFactory::instance()->find(type.c_str());
+    if (!t)
+        raise(PyExc_ValueError, QStringLiteral("there is no object type called \"%1\"").arg(QString::fromStdString(type)));
+
+    std::vector<ObjectCalcer *> args;
+    const long n = len(parents);
+    for (long i = 0; i < n; ++i)
+        args.push_back(extract<const PythonCalcer &>(parents[i])().calcer.get());
+    // the types sort their parents assuming that they fit, and assert
+    // that they do..
+    const ArgsParserObjectType *at = dynamic_cast<const ArgsParserObjectType *>(t);
+    if (at && at->argsParser().check(args) != ArgsParser::Complete)
+        raise(PyExc_ValueError, QStringLiteral("the parents don't fit an object of type \"%1\"").arg(QString::fromStdString(type)));
+
+    ObjectTypeCalcer *ret = new ObjectTypeCalcer(t, args);
+    ret->calc(*mdoc);
+    return PythonCalcer(ret);
+}
+
+PythonCalcer PythonDocument::property(const PythonCalcer &c, const std::string &property)
+{
+    ObjectCalcer *ret = ObjectFactory::instance()->propertyObjectCalcer(c.calcer.get(), property.c_str());
+    if (!ret)
+        raise(PyExc_ValueError, QStringLiteral("the object has no property called \"%1\"").arg(QString::fromStdString(property)));
+    ret->calc(*mdoc);
+    return PythonCalcer(ret);
+}
+
+void PythonDocument::add(const PythonCalcer &c, const std::string &name)
+{
+    ObjectHolder *o;
+    if (name.empty())
+        o = new ObjectHolder(c.calcer.get());
+    else
+        o = new ObjectHolder(c.calcer.get(), new ObjectDrawer, new ObjectConstCalcer(new StringImp(QString::fromStdString(name))));
+    mdoc->addObject(o);
+}
+
+list PythonDocument::objects() const
+{
+    list ret;
+    const std::vector<ObjectHolder *> os = mdoc->objects();
+    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
+        ret.append(PythonCalcer((*i)->calcer()));
+    return ret;
+}
+
+void PythonDocument::setConstant(const PythonCalcer &c, const ObjectImp &imp)
+{
+    ObjectConstCalcer *cc = dynamic_cast<ObjectConstCalcer *>(c.calcer.get());
+    if (!cc)
+        raise(PyExc_TypeError, QStringLiteral("only constants can be changed"));
+    delete cc->switchImp(imp.copy());
+
+    // only what depends on the constant is calculated again..
+    std::set<ObjectCalcer *> children = getAllChildren(cc);
+    std::vector<ObjectCalcer *> path = calcPath(std::vector<ObjectCalcer *>(children.begin(), children.end()));
+    for (std::vector<ObjectCalcer *>::iterator i = path.begin(); i != path.end(); ++i)
+        (*i)->calc(*mdoc);
+}
+
+void PythonDocument::beginTransaction()
+{
+    mdoc->beginTransaction();
+}
+
+void PythonDocument::commitTransaction()
+{
+    mdoc->commitTransaction();
+}
+
+void PythonDocument::setGrid(bool showgrid)
+{
+    mdoc->setGrid(showgrid);
+}
+
+void PythonDocument::setAxes(bool showaxes)
+{
+    mdoc->setAxes(showaxes);
+}
+
+void PythonDocument::save(const std::string &file) const
+{
+    if (!KigFilters::instance()->save(*mdoc, QString::fromStdString(file)))
+        raise(PyExc_IOError, QStringLiteral("could not save to \"%1\"").arg(QString::fromStdString(file)));
+}
+
+void PythonDocument::exportTo(const std::string &format, const std::string &file, int width, int height) const
+{
+    const QString f = QString::fromStdString(format);
+    if (!KigBatchExporter::supportedFormats().contains(f))
+        raise(PyExc_ValueError, QStringLiteral("unknown export format \"%1\"").arg(f));
+    if (!KigBatchExporter::write(*mdoc, f, QString::fromStdString(file), QSize(width, height)))
+        raise(PyExc_IOError, QStringLiteral("could not export to \"%1\"").arg(QString::fromStdString(file)));
+}
+
+void exportDocumentApi()
+{
+    class_<PythonCalcer>("Calcer", no_init).def("imp", &PythonCalcer::imp, return_value_policy<manage_new_object>());
+
+    class_<PythonDocument, boost::noncopyable>("Document")
+        .def("load", &PythonDocument::load, return_value_policy<manage_new_object>())
+        .staticmethod("load")
+        .def("constant", &PythonDocument::constant)
+        .def("fixedPoint", &PythonDocument::fixedPoint)
+        .def("object", &PythonDocument::object)
+        .def("property", &PythonDocument::property)
+        .def("add", &PythonDocument::add, (arg("calcer"), arg("name") = std::string()))
+        .def("objects", &PythonDocument::objects)
+        .def("setConstant", &PythonDocument::setConstant)
+        .def("beginTransaction", &PythonDocument::beginTransaction)
+        .def("commitTransaction", &PythonDocument::commitTransaction)
+        .def("setGrid", &PythonDocument::setGrid)
+        .def("setAxes", &PythonDocument::setAxes)
+        .def("save", &PythonDocument::save)
+        .def("exportTo", &PythonDocument::exportTo, (arg("format"), arg("file"), arg("width") = 800, arg("height") = 600));
+}
@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <string>
+
+#include <boost/python.hpp>
+
+#include "../objects/object_calcer.h"
+
+class Coordinate;
+class KigDocument;
+class ObjectImp;
+
+/**
+ * An ObjectCalcer, as the python scripts see it.  Scripts build their
+ * constructions out of these, and only the ones they add() to a
+ * PythonDocument become objects of the document..
+ */
+class PythonCalcer
+{
+public:
+    explicit PythonCalcer(ObjectCalcer *c);
+
+    ObjectCalcer::shared_ptr calcer;
+
+    /**
+     * a copy of the current imp of the calcer, it may change when the
+     * document is recalculated..
+     */
+    ObjectImp *imp() const;
+};
+
+/**
+ * A KigDocument that a python script builds, calculates and exports
+ * without a KigPart or a GUI, see "kig --run-script"..
+ */
+class PythonDocument
+{
+    KigDocument *mdoc;
+
+public:
+    PythonDocument();
+    explicit PythonDocument(KigDocument *doc);
+    ~PythonDocument();
+
+    /**
+     * read the document in \p file, with the filter for its file
+     * type..
+     */
+    static PythonDocument *load(const std::string &file);
+
+    /**
+     * a calcer that always has a copy of \p imp..
+     */
+    PythonCalcer constant(const ObjectImp &imp);
+    PythonCalcer fixedPoint(const Coordinate &c);
+    /**
+     * an object of the ObjectType with the internal name \p type, with
+     * the calcers in \p parents as its arguments, in any order.
+     * Raises a ValueError if they are not the arguments the type
+     * wants..
+     */
+    PythonCalcer object(const std::string &type, const boost::python::list &parents);
+    /**
+     * the property with the internal name \p property of \p c..
+     */
+    PythonCalcer property(const PythonCalcer &c, const std::string &property);
+
+    /**
+     * make \p c an object of the document, drawn with the default
+     * style, and with the name \p name..
+     */
+    void add(const PythonCalcer &c, const std::string &name);
+    /**
+     * the calcers of all the objects of the document..
+     */
+    boost::python::list objects() const;
+    /**
+     * change the imp of the constant \p c to a copy of \p imp, and
+     * recalculate everything that depends on it..
+     */
+    void setConstant(const PythonCalcer &c, const ObjectImp &imp);
+
+    /**
+     * between these, added objects are only calculated once, when the
+     * transaction is committed, see KigDocument::beginTransaction()..
+     */
+    void beginTransaction();
+    void commitTransaction();
+
+    void setGrid(bool showgrid);
+    void setAxes(bool showaxes);
+
+    /**
+     * save the document as a native Kig file..
+     */
+    void save(const std::string &file) const;
+    /**
+     * export the document to \p file in \p format, one of the formats
+     * of "kig --export-to", the way it is shown in a view of \p width
+     * by \p height pixels..
+     */
+    void exportTo(const std::string &format, const std::string &file, int width, int height) const;
+
+    Q_DISABLE_COPY(PythonDocument)
+};
+
+/**
+ * add the classes above to the kig python module..
+ */
+void exportDocumentApi();
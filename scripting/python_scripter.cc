@@ -10,12 +10,19 @@
 #include "python_scripter.h"
 #include <Python.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
 #include <string>
 
 #include <boost/mpl/bool.hpp>
 #include <boost/python.hpp>
 
+#include "python_document.h"
+
 #include "../misc/common.h"
 #include "../misc/coordinate.h"
 #include "../misc/cubic-common.h"
@@ -30,6 +37,20 @@
 #include "../objects/polygon_imp.h"
 #include "../objects/text_imp.h"
 
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <marshal.h>
+
 using namespace boost::python;
 
 BOOST_PYTHON_MODULE_INIT(kig)
@@ -293,6 +314,8 @@ BOOST_PYTHON_MODULE_INIT(kig)
         .def("stype", &CubicImp::stype, return_value_policy<reference_existing_object>())
         .staticmethod("stype")
         .def("data", &CubicImp::data);
+
+    exportDocumentApi();
 }
 
 // helper class to initialize Python in a constructor;
@@ -324,12 +347,118 @@ PythonScripter *PythonScripter::instance()
     return &t;
 }
 
+static std::recursive_mutex pythonmutex;
+
+/**
+ * Python may be used by more than one thread, e.g. by the batch
+ * exporter, whose worker threads draw loci that run scripts.  Every
+ * entry point into the interpreter holds one of these: it makes the
+ * callers take turns, and then takes the GIL, which the thread that
+ * started python gives up as soon as it is done with that.  The mutex
+ * comes first, so that no thread waits for it while holding the GIL..
+ */
+class PythonLock
+{
+    std::lock_guard<std::recursive_mutex> mlocker;
+    PyGILState_STATE mstate;
+
+public:
+    PythonLock()
+        : mlocker(pythonmutex)
+        , mstate(PyGILState_Ensure())
+    {
+    }
+    ~PythonLock()
+    {
+        PyGILState_Release(mstate);
+    }
+
+    PythonLock(const PythonLock &) = delete;
+    PythonLock &operator=(const PythonLock &) = delete;
+};
+
+/**
+ * the number of compiled scripts kept by PythonScripter::compile()..
+ */
+static size_t compiledCacheSize()
+{
+    static const size_t size = qMax(KSharedConfig::openConfig()->group(QStringLiteral("Scripting")).readEntry("CompiledScriptCacheSize", 64), 0);
+    return size;
+}
+
 class PythonScripter::Private : private PythonInitializer
 {
 public:
     dict mainnamespace;
+    /**
+     * the scripts that were compiled without errors, by the hash of
+     * their source.  Documents often contain the same script many
+     * times, and are opened more than once.  Only the
+     * compiledCacheSize() most recently used ones are kept, lru has
+     * their hashes with the most recently used first, and every entry
+     * of compiled points to its place in it..
+     */
+    std::map<QByteArray, std::pair<CompiledPythonScript, std::list<QByteArray>::iterator>> compiled;
+    std::list<QByteArray> lru;
 };
 
+/**
+ * where the marshalled code of the script with hash \p key is kept
+ * between sessions, or an empty string if that is turned off.  The
+ * magic number of the interpreter is part of the name, since
+ * marshalled code can't be read by another python version..
+ */
+static QString codeCacheFile(const QByteArray &key)
+{
+    static const bool enabled = KSharedConfig::openConfig()->group(QStringLiteral("Scripting")).readEntry("CacheCompiledScripts", true);
+    if (!enabled)
+        return QString();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/python/") + QString::fromLatin1(key.toHex())
+        + QLatin1Char('-') + QString::number(PyImport_GetMagicNumber(), 16) + QStringLiteral(".kigpyc");
+}
+
+/**
+ * the code object for the script with hash \p key from the disk
+ * cache, or 0 if it isn't there..
+ */
+static PyObject *loadCachedCode(const QByteArray &key)
+{
+    const QString path = codeCacheFile(key);
+    if (path.isEmpty())
+        return nullptr;
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly))
+        return nullptr;
+    QByteArray data = f.readAll();
+    PyObject *ret = PyMarshal_ReadObjectFromString(data.data(), data.size());
+    if (!ret || !PyCode_Check(ret)) {
+        // a broken cache file is simply ignored..
+        Py_XDECREF(ret);
+        PyErr_Clear();
+        return nullptr;
+    }
+    return ret;
+}
+
+static void storeCachedCode(const QByteArray &key, PyObject *code)
+{
+    const QString path = codeCacheFile(key);
+    if (path.isEmpty())
+        return;
+    PyObject *data = PyMarshal_WriteObjectToString(code, Py_MARSHAL_VERSION);
+    if (!data) {
+        PyErr_Clear();
+        return;
+    }
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile f(path);
+    if (f.open(QIODevice::WriteOnly)) {
+        f.write(PyBytes_AS_STRING(data), PyBytes_GET_SIZE(data));
+        f.commit();
+    }
+    Py_DECREF(data);
+}
+
 PythonScripter::PythonScripter()
 {
     d = new Private;
@@ -340,10 +469,15 @@ PythonScripter::PythonScripter()
 
     handle<> mnh(borrowed(PyModule_GetDict(main_module.get())));
     d->mainnamespace = extract<dict>(mnh.get());
+
+    // from now on, the GIL is taken by PythonLock..
+    PyEval_SaveThread();
 }
 
 PythonScripter::~PythonScripter()
 {
+    // python is shut down with the GIL held, it isn't given back..
+    PyGILState_Ensure();
     PyErr_Clear();
     delete d;
     // Py_FinalizeEx();
@@ -353,37 +487,157 @@ PythonScripter::~PythonScripter()
 class CompiledPythonScript::Private
 {
 public:
-    int ref;
+    // the imps holding the script are copied on any thread..
+    std::atomic<int> ref;
     object calcfunc;
+    // the optional vectorized version of calcfunc..
+    object calcbatchfunc;
     // TODO
     //  object movefunc;
 };
 
+struct CompiledPythonScript::Statistics {
+    // how often the script was run, and how long that took, in
+    // nanoseconds..
+    int calls = 0;
+    qint64 totaltime = 0;
+    qint64 maxtime = 0;
+    // set once the script went over the time budget..
+    bool throttled = false;
+};
+
+/**
+ * the time budget of a single evaluation of a script, in milliseconds,
+ * or 0 for no limit..
+ */
+static qint64 scriptTimeBudget()
+{
+    static const qint64 budget = KSharedConfig::openConfig()->group(QStringLiteral("Scripting")).readEntry("TimeBudget", 250);
+    return budget;
+}
+
+/**
+ * the evaluation that is running now on this thread, for the trace
+ * function, which python also keeps per thread..
+ */
+static thread_local QElapsedTimer runningtimer;
+static thread_local bool runningexpired = false;
+
+static int budgetTraceFunc(PyObject *, PyFrameObject *, int what, PyObject *)
+{
+    // checking the clock on every line is cheap enough, and also catches
+    // loops that never call a function..
+    if ((what == PyTrace_LINE || what == PyTrace_CALL) && runningtimer.elapsed() > scriptTimeBudget()) {
+        runningexpired = true;
+        PyErr_SetString(PyExc_TimeoutError, "the script took too long to run, and was stopped");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Times one evaluation of a script, and stops it with a TimeoutError
+ * when it goes over the time budget.  The script is throttled then:
+ * it is not run again, so that a slow script can't make dragging
+ * objects around unusable..
+ */
+class ScriptTimer
+{
+    CompiledPythonScript::Statistics &mstats;
+    bool mlimited;
+
+public:
+    explicit ScriptTimer(CompiledPythonScript::Statistics &stats)
+        : mstats(stats)
+        , mlimited(scriptTimeBudget() > 0)
+    {
+        runningexpired = false;
+        runningtimer.start();
+        if (mlimited)
+            PyEval_SetTrace(budgetTraceFunc, nullptr);
+    }
+    ~ScriptTimer()
+    {
+        stop();
+    }
+    void stop()
+    {
+        if (!runningtimer.isValid())
+            return;
+        // the trace function stays installed on this thread after it
+        // raised the TimeoutError too..
+        if (mlimited)
+            PyEval_SetTrace(nullptr, nullptr);
+        const qint64 t = runningtimer.nsecsElapsed();
+        ++mstats.calls;
+        mstats.totaltime += t;
+        mstats.maxtime = std::max(mstats.maxtime, t);
+        if (runningexpired)
+            mstats.throttled = true;
+        runningtimer.invalidate();
+    }
+};
+
 ObjectImp *CompiledPythonScript::calc(const Args &args, const KigDocument &)
 {
     return PythonScripter::instance()->calc(*this, args);
 }
 
+std::vector<ObjectImp *> CompiledPythonScript::calcBatch(const std::vector<Args> &args, const KigDocument &doc)
+{
+    if (!d->calcbatchfunc) {
+        std::vector<ObjectImp *> ret;
+        for (std::vector<Args>::const_iterator i = args.begin(); i != args.end(); ++i)
+            ret.push_back(calc(*i, doc));
+        return ret;
+    }
+    return PythonScripter::instance()->calcBatch(*this, args);
+}
+
+bool CompiledPythonScript::sameScript(const CompiledPythonScript &s) const
+{
+    return d == s.d && mstats == s.mstats;
+}
+
 CompiledPythonScript::~CompiledPythonScript()
 {
-    --d->ref;
-    if (d->ref == 0)
+    if (--d->ref == 0) {
+        // this releases the python functions..
+        PythonLock l;
         delete d;
+    }
 }
 
 CompiledPythonScript::CompiledPythonScript(Private *ind)
     : d(ind)
+    , mstats(std::make_shared<Statistics>())
 {
     ++d->ref;
 }
 
 CompiledPythonScript PythonScripter::compile(const char *code)
 {
+    PythonLock l;
     clearErrors();
+    const QByteArray key = QCryptographicHash::hash(QByteArray(code), QCryptographicHash::Sha1);
+    std::map<QByteArray, std::pair<CompiledPythonScript, std::list<QByteArray>::iterator>>::iterator cached = d->compiled.find(key);
+    if (cached != d->compiled.end()) {
+        d->lru.splice(d->lru.begin(), d->lru, cached->second.second);
+        // the same code, but for another object..
+        return CompiledPythonScript(cached->second.first.d);
+    }
+
     dict retdict;
     bool error = false;
     try {
-        (void)PyRun_String(const_cast<char *>(code), Py_file_input, d->mainnamespace.ptr(), retdict.ptr());
+        // this is what PyRun_String() does, except that the compiled code
+        // may come from the disk cache..
+        handle<> codeh(allow_null(loadCachedCode(key)));
+        if (!codeh) {
+            codeh = handle<>(Py_CompileString(code, "<kig script>", Py_file_input));
+            storeCachedCode(key, codeh.get());
+        }
+        handle<> reth(allow_null(PyEval_EvalCode(codeh.get(), d->mainnamespace.ptr(), retdict.ptr())));
     } catch (...) {
         error = true;
     };
@@ -399,11 +653,23 @@ CompiledPythonScript PythonScripter::compile(const char *code)
     CompiledPythonScript::Private *ret = new CompiledPythonScript::Private;
     ret->ref = 0;
     ret->calcfunc = retdict.get("calc");
-    return CompiledPythonScript(ret);
+    ret->calcbatchfunc = retdict.get("calc_batch");
+    CompiledPythonScript script(ret);
+    if (!error && compiledCacheSize() > 0) {
+        d->lru.push_front(key);
+        d->compiled.insert(std::make_pair(key, std::make_pair(script, d->lru.begin())));
+        // the objects that use an evicted script keep it alive..
+        while (d->compiled.size() > compiledCacheSize()) {
+            d->compiled.erase(d->lru.back());
+            d->lru.pop_back();
+        }
+    }
+    return script;
 }
 
 CompiledPythonScript::CompiledPythonScript(const CompiledPythonScript &s)
     : d(s.d)
+    , mstats(s.mstats)
 {
     ++d->ref;
 }
@@ -423,10 +689,70 @@ std::string PythonScripter::lastErrorExceptionTraceback() const
     return lastexceptiontraceback;
 }
 
+void PythonScripter::saveThrottledError(const CompiledPythonScript &script)
+{
+    erroroccurred = true;
+    lastexceptiontype = "TimeoutError";
+    lastexceptionvalue = "the script took too long to run, and was stopped";
+    lastexceptiontraceback = "TimeoutError: the script took longer than " + std::to_string(scriptTimeBudget()) + " ms to run, and is not run anymore. "
+        + "It was run " + std::to_string(script.calls()) + " times, in " + std::to_string(script.averageTime() / 1000) + " ms on average, and "
+        + std::to_string(script.maxTime() / 1000) + " ms at most.\n";
+}
+
+int PythonScripter::run(const char *code, const char *filename, const std::vector<std::string> &argv)
+{
+    PythonLock l;
+    clearErrors();
+    try {
+        list argvlist;
+        for (std::vector<std::string>::const_iterator i = argv.begin(); i != argv.end(); ++i)
+            argvlist.append(str(*i));
+        PySys_SetObject("argv", argvlist.ptr());
+
+        // the script gets its own globals, so that it doesn't change the
+        // namespace of the scripts in the documents..
+        dict globals = d->mainnamespace.copy();
+        globals["__name__"] = "__main__";
+        globals["__file__"] = filename;
+        handle<> codeh(Py_CompileString(code, filename, Py_file_input));
+        handle<> reth(PyEval_EvalCode(codeh.get(), globals.ptr(), globals.ptr()));
+    } catch (...) {
+        if (PyErr_ExceptionMatches(PyExc_SystemExit)) {
+            // sys.exit() with a number or None is not an error..
+            PyObject *type;
+            PyObject *value;
+            PyObject *traceback;
+            PyErr_Fetch(&type, &value, &traceback);
+            PyErr_NormalizeException(&type, &value, &traceback);
+            handle<> typeh(type);
+            handle<> valueh(allow_null(value));
+            handle<> tracebackh(allow_null(traceback));
+            object exitcode = valueh ? object(valueh).attr("code") : object();
+            if (exitcode.is_none())
+                return 0;
+            extract<int> status(exitcode);
+            if (status.check())
+                return status();
+            // sys.exit( "message" )..
+            std::cerr << extract<std::string>(str(exitcode))() << std::endl;
+            return 1;
+        }
+        saveErrors();
+        return 1;
+    }
+    return 0;
+}
+
 ObjectImp *PythonScripter::calc(CompiledPythonScript &script, const Args &args)
 {
+    PythonLock l;
     clearErrors();
+    if (script.mstats->throttled) {
+        saveThrottledError(script);
+        return new InvalidImp;
+    }
     object calcfunc = script.d->calcfunc;
+    ScriptTimer timer(*script.mstats);
     try {
         std::vector<object> objectvect;
         objectvect.reserve(args.size());
@@ -464,12 +790,66 @@ ObjectImp *PythonScripter::calc(CompiledPythonScript &script, const Args &args)
             return ret.copy();
         };
     } catch (...) {
+        timer.stop();
         saveErrors();
 
         return new InvalidImp;
     };
 }
 
+std::vector<ObjectImp *> PythonScripter::calcBatch(CompiledPythonScript &script, const std::vector<Args> &args)
+{
+    PythonLock l;
+    clearErrors();
+    std::vector<ObjectImp *> ret;
+    if (args.empty())
+        return ret;
+    if (script.mstats->throttled) {
+        saveThrottledError(script);
+        for (uint i = 0; i < args.size(); ++i)
+            ret.push_back(new InvalidImp);
+        return ret;
+    }
+    object calcbatchfunc = script.d->calcbatchfunc;
+    // the whole batch gets the budget of a single evaluation, it is what
+    // the user is waiting for..
+    ScriptTimer timer(*script.mstats);
+    try {
+        // calc_batch gets one list per argument, with the values of that
+        // argument for every call..
+        const uint nargs = args.front().size();
+        handle<> argstuph(PyTuple_New(nargs));
+        for (uint j = 0; j < nargs; ++j) {
+            list column;
+            for (std::vector<Args>::const_iterator i = args.begin(); i != args.end(); ++i)
+                column.append(object(boost::ref(*(*i)[j])));
+            // PyTuple_SetItem steals a reference, see calc() above..
+            Py_INCREF(column.ptr());
+            PyTuple_SetItem(argstuph.get(), j, column.ptr());
+        }
+        tuple argstup(argstuph);
+
+        handle<> reth(PyObject_CallObject(calcbatchfunc.ptr(), argstup.ptr()));
+        object resulto(reth);
+
+        if (len(resulto) == static_cast<long>(args.size())) {
+            for (uint i = 0; i < args.size(); ++i) {
+                extract<ObjectImp &> result(resulto[i]);
+                ret.push_back(result.check() ? result().copy() : new InvalidImp);
+            }
+        }
+    } catch (...) {
+        timer.stop();
+        saveErrors();
+        delete_all(ret.begin(), ret.end());
+        ret.clear();
+    };
+    // a wrong number of results makes the whole batch invalid..
+    while (ret.size() < args.size())
+        ret.push_back(new InvalidImp);
+    return ret;
+}
+
 void PythonScripter::saveErrors()
 {
     erroroccurred = true;
@@ -523,6 +903,32 @@ bool CompiledPythonScript::valid()
     return !!d->calcfunc;
 }
 
+// the statistics are written by whichever thread runs the script..
+
+int CompiledPythonScript::calls() const
+{
+    std::lock_guard<std::recursive_mutex> l(pythonmutex);
+    return mstats->calls;
+}
+
+qint64 CompiledPythonScript::averageTime() const
+{
+    std::lock_guard<std::recursive_mutex> l(pythonmutex);
+    return mstats->calls == 0 ? 0 : mstats->totaltime / mstats->calls / 1000;
+}
+
+qint64 CompiledPythonScript::maxTime() const
+{
+    std::lock_guard<std::recursive_mutex> l(pythonmutex);
+    return mstats->maxtime / 1000;
+}
+
+bool CompiledPythonScript::throttled() const
+{
+    std::lock_guard<std::recursive_mutex> l(pythonmutex);
+    return mstats->throttled;
+}
+
 bool PythonScripter::errorOccurred() const
 {
     return erroroccurred;
@@ -6,6 +6,7 @@
 
 #include "../objects/common.h"
 
+#include <memory>
 #include <string>
 
 class KigDocument;
@@ -14,16 +15,48 @@ class ObjectImp;
 class CompiledPythonScript
 {
     friend class PythonScripter;
+    friend class ScriptTimer;
     class Private;
     Private *const d;
+    /**
+     * how this script did for the object that compiled it.  The
+     * compiled code is shared by all the objects with the same script,
+     * but every call to PythonScripter::compile() gets statistics of
+     * its own, which its copies share..
+     */
+    struct Statistics;
+    std::shared_ptr<Statistics> mstats;
     CompiledPythonScript(Private *);
 
 public:
     CompiledPythonScript(const CompiledPythonScript &s);
     ~CompiledPythonScript();
     ObjectImp *calc(const Args &a, const KigDocument &doc);
+    /**
+     * calc() for every one of \p a.  If the script defines calc_batch,
+     * it is called only once, with the lists of the first, second, ...
+     * arguments, and returns the list of the results..
+     */
+    std::vector<ObjectImp *> calcBatch(const std::vector<Args> &a, const KigDocument &doc);
 
     bool valid();
+    /**
+     * how often the script was run, and how long that took on average
+     * and at most, in microseconds..
+     */
+    int calls() const;
+    qint64 averageTime() const;
+    qint64 maxTime() const;
+    /**
+     * whether the script went over the time budget once, a throttled
+     * script is not run anymore for this object, and only gives
+     * invalid results, until it is compiled again..
+     */
+    bool throttled() const;
+    /**
+     * whether this and \p s are copies of the same compiled script..
+     */
+    bool sameScript(const CompiledPythonScript &s) const;
 };
 
 class PythonScripter
@@ -36,6 +69,7 @@ class PythonScripter
 
     void clearErrors();
     void saveErrors();
+    void saveThrottledError(const CompiledPythonScript &script);
 
     bool erroroccurred;
     std::string lastexceptiontype;
@@ -52,4 +86,13 @@ public:
 
     CompiledPythonScript compile(const char *code);
     ObjectImp *calc(CompiledPythonScript &script, const Args &args);
+    std::vector<ObjectImp *> calcBatch(CompiledPythonScript &script, const std::vector<Args> &args);
+
+    /**
+     * run the python program \p code from the file \p filename, with
+     * \p argv as sys.argv, see "kig --run-script".  Returns its exit
+     * status, 1 if it raised an exception, the details of which are
+     * available through the error functions above..
+     */
+    int run(const char *code, const char *filename, const std::vector<std::string> &argv);
 };
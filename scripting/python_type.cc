@@ -9,6 +9,8 @@
 #include "../objects/bogus_imp.h"
 #include "../objects/object_imp.h"
 
+#include <KLocalizedString>
+
 class PythonCompiledScriptImp : public BogusImp
 {
     mutable CompiledPythonScript mscript;
@@ -97,6 +99,26 @@ const ObjectImpType *PythonCompileType::resultId() const
     return PythonCompiledScriptImp::stype();
 }
 
+QString PythonCompileType::runStatistics(const ObjectImp *compiled)
+{
+    if (!compiled->inherits(PythonCompiledScriptImp::stype()))
+        return QString();
+    const CompiledPythonScript &script = static_cast<const PythonCompiledScriptImp *>(compiled)->data();
+    if (script.calls() == 0)
+        return QString();
+    QString ret;
+    if (script.calls() == 1)
+        ret = i18n("The script was run once, in %1 ms.", QString::number(script.maxTime() / 1000.0, 'f', 1));
+    else
+        ret = i18n("The script was run %1 times, in %2 ms on average and %3 ms at most.",
+                   script.calls(),
+                   QString::number(script.averageTime() / 1000.0, 'f', 1),
+                   QString::number(script.maxTime() / 1000.0, 'f', 1));
+    if (script.throttled())
+        ret += QLatin1Char(' ') + i18n("It took too long once, and is not run anymore until it is changed.");
+    return ret;
+}
+
 ObjectImp *PythonCompileType::calc(const Args &parents, const KigDocument &) const
 {
     assert(parents.size() == 1);
@@ -143,6 +165,30 @@ ObjectImp *PythonExecuteType::calc(const Args &parents, const KigDocument &d) co
     return script.calc(args, d);
 }
 
+std::vector<ObjectImp *> PythonExecuteType::calcBatch(const std::vector<Args> &parents, const KigDocument &d) const
+{
+    // we can only hand the batch to the script if every call is for
+    // the same script, which is what happens when sampling a locus..
+    const CompiledPythonScript *script = nullptr;
+    for (std::vector<Args>::const_iterator i = parents.begin(); i != parents.end(); ++i) {
+        if (i->empty() || !(*i)[0]->inherits(PythonCompiledScriptImp::stype()))
+            return ObjectType::calcBatch(parents, d);
+        const CompiledPythonScript &s = static_cast<const PythonCompiledScriptImp *>((*i)[0])->data();
+        if (!script)
+            script = &s;
+        else if (!script->sameScript(s))
+            return ObjectType::calcBatch(parents, d);
+    }
+    if (!script)
+        return std::vector<ObjectImp *>();
+
+    std::vector<Args> args;
+    args.reserve(parents.size());
+    for (std::vector<Args>::const_iterator i = parents.begin(); i != parents.end(); ++i)
+        args.push_back(Args(i->begin() + 1, i->end()));
+    return static_cast<const PythonCompiledScriptImp *>(parents.front()[0])->data().calcBatch(args, d);
+}
+
 const ObjectImpType *PythonExecuteType::impRequirement(const ObjectImp *o, const Args &parents) const
 {
     if (o == parents[0])
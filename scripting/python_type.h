@@ -6,6 +6,8 @@
 
 #include "../objects/object_type.h"
 
+#include <QString>
+
 class PythonCompileType : public ObjectType
 {
     PythonCompileType();
@@ -14,6 +16,14 @@ class PythonCompileType : public ObjectType
 public:
     static const PythonCompileType *instance();
 
+    /**
+     * how often the script compiled into \p compiled has run, and how
+     * long that took, as a sentence for the user.  Returns an empty
+     * string if \p compiled is not a compiled script, or hasn't run
+     * yet..
+     */
+    static QString runStatistics(const ObjectImp *compiled);
+
     ObjectImp *calc(const Args &parents, const KigDocument &d) const override;
 
     const ObjectImpType *impRequirement(const ObjectImp *o, const Args &parents) const override;
@@ -33,6 +43,7 @@ public:
     static const PythonExecuteType *instance();
 
     ObjectImp *calc(const Args &parents, const KigDocument &d) const override;
+    std::vector<ObjectImp *> calcBatch(const std::vector<Args> &parents, const KigDocument &d) const override;
 
     const ObjectImpType *impRequirement(const ObjectImp *o, const Args &parents) const override;
     bool isDefinedOnOrThrough(const ObjectImp *o, const Args &parents) const override;
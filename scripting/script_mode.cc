@@ -284,6 +284,9 @@ ScriptEditMode::ScriptEditMode(ObjectTypeCalcer *exec_calc, KigPart &doc)
 
     mwizard->setWindowTitle(i18nc("@title:window 'Edit' is a verb", "Edit Script"));
     mwizard->setText(morigscript);
+    // changing the script compiles it again, which also gives it
+    // another chance if it was throttled..
+    mwizard->setStatistics(PythonCompileType::runStatistics(mexecargs[0]->imp()));
     mwizard->show();
     mwizard->next();
     mwizard->button(QWizard::BackButton)->setEnabled(false);
@@ -338,9 +341,9 @@ bool ScriptEditMode::queryCancel()
     static_cast<ObjectConstCalcer *>(mcompiledargs[0])->switchImp(new StringImp(morigscript));
     mexecargs[0]->calc(mpart.document());
 
+    // this is not necessarily valid again, the original script may have
+    // been throttled, and may take too long again..
     mexecuted->calc(mpart.document());
-    // paranoic check
-    assert(!mexecuted->imp()->inherits(InvalidImp::stype()));
 
     mpart.redrawScreen();
 
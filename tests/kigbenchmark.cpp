@@ -0,0 +1,387 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../filters/filter.h"
+#include "../kig/kig_document.h"
+#include "../misc/calcpaths.h"
+#include "../misc/conic-common.h"
+#include "../misc/coordinate.h"
+#include "../misc/kignumerics.h"
+#include "../misc/kigpainter.h"
+#include "../misc/object_hierarchy.h"
+#include "../misc/rect.h"
+#include "../misc/screeninfo.h"
+#include "../objects/bezier_imp.h"
+#include "../objects/common.h"
+#include "../objects/curve_imp.h"
+#include "../objects/object_calcer.h"
+#include "../objects/object_factory.h"
+#include "../objects/object_imp.h"
+#include "../objects/object_type_factory.h"
+#include "../objects/point_imp.h"
+#include "../objects/polygon_imp.h"
+
+#include <memory>
+
+#include <QApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMimeDatabase>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QTextStream>
+
+#include <kig_version.h>
+
+/**
+ * Benchmarks of the core engine, the numerics, the painter and the
+ * filters.  Run it with "-json FILE" to have the results written as
+ * JSON too, e.g. to compare releases, the other arguments are passed
+ * on to QTest..
+ */
+class KigBenchmark : public QObject
+{
+    Q_OBJECT
+
+    KigDocument mdoc;
+
+    /**
+     * a fixed point..
+     */
+    ObjectCalcer::shared_ptr point(double x, double y);
+    /**
+     * an object of the type with internal name \p type..
+     */
+    ObjectCalcer::shared_ptr object(const char *type, const std::vector<ObjectCalcer *> &parents);
+    /**
+     * the locus of the midpoint of a fixed point and a point moving on
+     * a circle..
+     */
+    ObjectCalcer::shared_ptr locus();
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void calcPath_data();
+    void calcPath();
+    void hierarchyCalc();
+    void getParam_data();
+    void getParam();
+    void drawCurve_data();
+    void drawCurve();
+    void conicThroughPoints();
+    void cubicRoot();
+    void bezierPoint_data();
+    void bezierPoint();
+    void convexHull_data();
+    void convexHull();
+    void filterLoad_data();
+    void filterLoad();
+};
+
+ObjectCalcer::shared_ptr KigBenchmark::point(double x, double y)
+{
+    ObjectCalcer::shared_ptr ret = ObjectFactory::instance()->fixedPointCalcer(Coordinate(x, y));
+    ret->calc(mdoc);
+    return ret;
+}
+
+ObjectCalcer::shared_ptr KigBenchmark::object(const char *type, const std::vector<ObjectCalcer *> &parents)
+{
+    ObjectCalcer::shared_ptr ret = new ObjectTypeCalcer(ObjectTypeFactory::instance()->find(type), parents);
+    ret->calc(mdoc);
+    return ret;
+}
+
+ObjectCalcer::shared_ptr KigBenchmark::locus()
+{
+    ObjectCalcer::shared_ptr center = point(0, 0);
+    ObjectCalcer::shared_ptr through = point(2, 0);
+    ObjectCalcer::shared_ptr circle = object("CircleBCP", {center.get(), through.get()});
+    ObjectCalcer::shared_ptr moving = ObjectFactory::instance()->constrainedPointCalcer(circle.get(), 0.3);
+    moving->calc(mdoc);
+    ObjectCalcer::shared_ptr fixed = point(5, 1);
+    ObjectCalcer::shared_ptr mid = object("MidPoint", {moving.get(), fixed.get()});
+    ObjectCalcer::shared_ptr ret = ObjectFactory::instance()->locusCalcer(moving.get(), mid.get());
+    ret->calc(mdoc);
+    return ret;
+}
+
+void KigBenchmark::initTestCase()
+{
+    // the filters may not show message boxes here..
+    KigFilter::setBatchMode(true);
+}
+
+void KigBenchmark::calcPath_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+}
+
+void KigBenchmark::calcPath()
+{
+    QFETCH(int, size);
+
+    // a chain of midpoints, every one depending on the two before it..
+    std::vector<ObjectCalcer::shared_ptr> chain;
+    chain.push_back(point(0, 0));
+    chain.push_back(point(1, 0));
+    for (int i = 2; i < size; ++i)
+        chain.push_back(object("MidPoint", {chain[i - 1].get(), chain[i - 2].get()}));
+
+    const std::vector<ObjectCalcer *> from(1, chain.front().get());
+    QBENCHMARK {
+        std::vector<ObjectCalcer *> path = ::calcPath(from);
+        QVERIFY(path.size() == chain.size());
+    }
+}
+
+void KigBenchmark::hierarchyCalc()
+{
+    ObjectCalcer::shared_ptr a = point(0, 0);
+    ObjectCalcer::shared_ptr b = point(4, 0);
+    ObjectCalcer::shared_ptr c = point(1, 3);
+    ObjectCalcer::shared_ptr circle = object("CircleBTP", {a.get(), b.get(), c.get()});
+    ObjectCalcer::shared_ptr center = ObjectFactory::instance()->propertyObjectCalcer(circle.get(), "center");
+    center->calc(mdoc);
+    ObjectCalcer::shared_ptr mid = object("MidPoint", {center.get(), a.get()});
+
+    const std::vector<ObjectCalcer *> from = {a.get(), b.get(), c.get()};
+    const ObjectHierarchy hier(from, mid.get());
+    const PointImp pa(Coordinate(0, 0));
+    const PointImp pb(Coordinate(4, 0));
+    const PointImp pc(Coordinate(1, 3));
+    Args args;
+    args.push_back(&pa);
+    args.push_back(&pb);
+    args.push_back(&pc);
+
+    QBENCHMARK {
+        std::vector<ObjectImp *> ret = hier.calc(args, mdoc);
+        delete_all(ret.begin(), ret.end());
+    }
+}
+
+void KigBenchmark::getParam_data()
+{
+    QTest::addColumn<bool>("islocus");
+    QTest::newRow("bezier") << false;
+    QTest::newRow("locus") << true;
+}
+
+void KigBenchmark::getParam()
+{
+    QFETCH(bool, islocus);
+
+    // both use the generic CurveImp::getParam()..
+    ObjectCalcer::shared_ptr l;
+    std::unique_ptr<CurveImp> bezier;
+    const CurveImp *curve;
+    if (islocus) {
+        l = locus();
+        curve = static_cast<const CurveImp *>(l->imp());
+    } else {
+        bezier.reset(new BezierImp({Coordinate(0, 0), Coordinate(1, 3), Coordinate(3, -2), Coordinate(4, 1)}));
+        curve = bezier.get();
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < 16; ++i)
+            curve->getParam(Coordinate(i * 0.25, 1), mdoc);
+    }
+}
+
+void KigBenchmark::drawCurve_data()
+{
+    QTest::addColumn<bool>("islocus");
+    QTest::newRow("bezier") << false;
+    QTest::newRow("locus") << true;
+}
+
+void KigBenchmark::drawCurve()
+{
+    QFETCH(bool, islocus);
+
+    ObjectCalcer::shared_ptr l;
+    std::unique_ptr<CurveImp> bezier;
+    const CurveImp *curve;
+    if (islocus) {
+        l = locus();
+        curve = static_cast<const CurveImp *>(l->imp());
+    } else {
+        bezier.reset(new BezierImp({Coordinate(-5, 0), Coordinate(-2, 6), Coordinate(2, -6), Coordinate(5, 0)}));
+        curve = bezier.get();
+    }
+
+    QImage image(800, 600, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    const ScreenInfo si(Rect(-8, -6, 16, 12), image.rect());
+    KigPainter p(si, &image, mdoc, false);
+    QBENCHMARK {
+        p.drawCurve(curve);
+    }
+}
+
+void KigBenchmark::conicThroughPoints()
+{
+    const std::vector<Coordinate> points = {Coordinate(0, 1), Coordinate(2, 0.5), Coordinate(3, -1), Coordinate(-1, -2), Coordinate(-2, 0)};
+    QBENCHMARK {
+        QVERIFY(calcConicThroughPoints(points).valid());
+    }
+}
+
+void KigBenchmark::cubicRoot()
+{
+    // x^3 - x, with roots -1, 0 and 1..
+    QBENCHMARK {
+        for (int root = 1; root <= 3; ++root) {
+            bool valid;
+            int numroots;
+            calcCubicRoot(-2, 2, 1, 0, -1, 0, root, valid, numroots);
+        }
+    }
+}
+
+void KigBenchmark::bezierPoint_data()
+{
+    QTest::addColumn<int>("degree");
+    QTest::newRow("3") << 3;
+    QTest::newRow("10") << 10;
+}
+
+void KigBenchmark::bezierPoint()
+{
+    QFETCH(int, degree);
+
+    std::vector<Coordinate> points;
+    for (int i = 0; i <= degree; ++i)
+        points.push_back(Coordinate(i, (i % 2) ? 1 : -1));
+    const BezierImp bezier(points);
+    QBENCHMARK {
+        for (int i = 0; i <= 64; ++i)
+            bezier.getPoint(i / 64., mdoc);
+    }
+}
+
+void KigBenchmark::convexHull_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::newRow("100") << 100;
+    QTest::newRow("10000") << 10000;
+}
+
+void KigBenchmark::convexHull()
+{
+    QFETCH(int, size);
+
+    // always the same points, so that runs can be compared..
+    QRandomGenerator random(42);
+    std::vector<Coordinate> points;
+    for (int i = 0; i < size; ++i)
+        points.push_back(Coordinate(random.generateDouble(), random.generateDouble()));
+    QBENCHMARK {
+        computeConvexHull(points);
+    }
+}
+
+void KigBenchmark::filterLoad_data()
+{
+    QTest::addColumn<QString>("file");
+    const QDir dir(QStringLiteral(KIG_TEST_DATA_DIR));
+    const QStringList files = dir.entryList(QDir::Files, QDir::Name);
+    for (const QString &f : files) {
+        if (!f.endsWith(QLatin1String(".txt")))
+            QTest::newRow(f.toUtf8().constData()) << dir.filePath(f);
+    }
+}
+
+void KigBenchmark::filterLoad()
+{
+    QFETCH(QString, file);
+
+    const QMimeDatabase mimeDb;
+    KigFilter *filter = KigFilters::instance()->find(mimeDb.mimeTypeForFile(file).name());
+    if (!filter)
+        QSKIP("no filter for this file");
+    QBENCHMARK {
+        delete filter->load(file);
+    }
+}
+
+/**
+ * convert the CSV output of QTest in \p csv to JSON..
+ */
+static QJsonDocument resultsToJson(QFile &csv)
+{
+    QJsonArray results;
+    QTextStream s(&csv);
+    QString line;
+    while (s.readLineInto(&line)) {
+        // "function","tag","metric",value per iteration,total,iterations
+        const QStringList fields = line.split(QLatin1Char(','));
+        if (fields.size() < 6)
+            continue;
+        QJsonObject r;
+        r[QStringLiteral("name")] = fields[0].mid(1, fields[0].size() - 2);
+        r[QStringLiteral("tag")] = fields[1].mid(1, fields[1].size() - 2);
+        r[QStringLiteral("metric")] = fields[2].mid(1, fields[2].size() - 2);
+        r[QStringLiteral("value")] = fields[3].toDouble();
+        r[QStringLiteral("iterations")] = fields[5].toInt();
+        results.append(r);
+    }
+
+    QJsonObject ret;
+    ret[QStringLiteral("kig")] = QStringLiteral(KIG_VERSION_STRING);
+    ret[QStringLiteral("qt")] = QString::fromLatin1(qVersion());
+    ret[QStringLiteral("results")] = results;
+    return QJsonDocument(ret);
+}
+
+int main(int argc, char **argv)
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    QStringList args = app.arguments();
+    QString jsonfile;
+    const int json = args.indexOf(QStringLiteral("-json"));
+    if (json != -1 && json + 1 < args.size()) {
+        jsonfile = args[json + 1];
+        args.remove(json, 2);
+    }
+
+    KigBenchmark bench;
+    if (jsonfile.isEmpty())
+        return QTest::qExec(&bench, args);
+
+    // QTest has no JSON output, so we let it write CSV next to the
+    // normal output, and convert that..
+    QTemporaryFile csv;
+    if (!csv.open())
+        return 1;
+    args << QStringLiteral("-o") << QStringLiteral("-,txt") << QStringLiteral("-o") << csv.fileName() + QStringLiteral(",csv");
+    const int ret = QTest::qExec(&bench, args);
+
+    csv.seek(0);
+    QFile out(jsonfile);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qCritical() << "Could not write" << jsonfile;
+        return 1;
+    }
+    out.write(resultsToJson(csv).toJson());
+    return ret;
+}
+
+#include "kigbenchmark.moc"
@@ -0,0 +1,211 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../filters/filter.h"
+#include "../kig/kig_document.h"
+#include "../misc/coordinate.h"
+#include "../misc/object_hierarchy.h"
+#include "../objects/object_calcer.h"
+#include "../objects/object_factory.h"
+#include "../objects/object_holder.h"
+#include "../objects/object_type_factory.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+
+/*
+ * Writes big, reproducible documents for measuring how Kig scales:
+ *
+ * kigstressgen SHAPE N FILE
+ *
+ * The shapes are the pathological constructions that the engine has
+ * to cope with:
+ * - triangles: N triangles, each inscribed in the one before it, through
+ *   the midpoints of its sides, see calcpaths.cc;
+ * - macros: a chain of N applications of a small macro, every one
+ *   using the results of the two before it;
+ * - fan: N segments from one point, so that moving that point changes
+ *   all of them;
+ * - loci: N loci of the midpoint of a fixed point and a point moving on
+ *   a circle;
+ * - polygon: a single polygon with N vertices.
+ *
+ * The same arguments always give the same document.
+ */
+
+static ObjectCalcer *object(const char *type, const std::vector<ObjectCalcer *> &parents)
+{
+    return new ObjectTypeCalcer(ObjectTypeFactory::instance()->find(type), parents);
+}
+
+static ObjectCalcer *fixedPoint(double x, double y)
+{
+    return ObjectFactory::instance()->fixedPointCalcer(Coordinate(x, y));
+}
+
+/**
+ * the coordinate of point \p i of \p n, spread over a circle with
+ * radius \p r around \p c..
+ */
+static Coordinate onCircle(const Coordinate &c, double r, int i, int n)
+{
+    const double a = 2 * M_PI * i / n;
+    return c + Coordinate(r * std::cos(a), r * std::sin(a));
+}
+
+static void buildTriangles(int n, std::vector<ObjectHolder *> &os)
+{
+    ObjectCalcer *a = fixedPoint(-5, -3);
+    ObjectCalcer *b = fixedPoint(5, -3);
+    ObjectCalcer *c = fixedPoint(0, 5);
+    os.push_back(new ObjectHolder(a));
+    os.push_back(new ObjectHolder(b));
+    os.push_back(new ObjectHolder(c));
+    for (int i = 0; i < n; ++i) {
+        os.push_back(new ObjectHolder(object("TriangleB3P", {a, b, c})));
+        ObjectCalcer *ab = object("MidPoint", {a, b});
+        ObjectCalcer *bc = object("MidPoint", {b, c});
+        ObjectCalcer *ca = object("MidPoint", {c, a});
+        os.push_back(new ObjectHolder(ab));
+        os.push_back(new ObjectHolder(bc));
+        os.push_back(new ObjectHolder(ca));
+        a = ab;
+        b = bc;
+        c = ca;
+    }
+}
+
+static void buildMacros(int n, const KigDocument &doc, std::vector<ObjectHolder *> &os)
+{
+    // the macro: the point three quarters of the way from a to b, built
+    // through the reflection of a in b..
+    ObjectCalcer::shared_ptr ma = fixedPoint(0, 0);
+    ObjectCalcer::shared_ptr mb = fixedPoint(1, 1);
+    ObjectCalcer::shared_ptr reflection = object("PointReflection", {ma.get(), mb.get()});
+    ObjectCalcer::shared_ptr side = object("MidPoint", {mb.get(), reflection.get()});
+    ObjectCalcer::shared_ptr mresult = object("MidPoint", {ma.get(), side.get()});
+    // the hierarchy needs the types of the imps..
+    ma->calc(doc);
+    mb->calc(doc);
+    reflection->calc(doc);
+    side->calc(doc);
+    mresult->calc(doc);
+    const ObjectHierarchy macro(std::vector<ObjectCalcer *>{ma.get(), mb.get()}, mresult.get());
+
+    ObjectCalcer *prev = fixedPoint(0, 0);
+    ObjectCalcer *cur = fixedPoint(4, 1);
+    os.push_back(new ObjectHolder(prev));
+    os.push_back(new ObjectHolder(cur));
+    for (int i = 0; i < n; ++i) {
+        std::vector<ObjectCalcer *> result = macro.buildObjects({prev, cur}, doc);
+        prev = cur;
+        cur = result.front();
+        os.push_back(new ObjectHolder(cur));
+    }
+}
+
+static void buildFan(int n, std::vector<ObjectHolder *> &os)
+{
+    ObjectCalcer *c = fixedPoint(0, 0);
+    os.push_back(new ObjectHolder(c));
+    for (int i = 0; i < n; ++i) {
+        const Coordinate p = onCircle(Coordinate(0, 0), 5, i, n);
+        os.push_back(new ObjectHolder(object("SegmentAB", {c, fixedPoint(p.x, p.y)})));
+    }
+}
+
+static void buildLoci(int n, const KigDocument &doc, std::vector<ObjectHolder *> &os)
+{
+    ObjectCalcer *center = fixedPoint(0, 0);
+    ObjectCalcer *through = fixedPoint(2, 0);
+    ObjectCalcer *circle = object("CircleBCP", {center, through});
+    // the loci need the types of the imps..
+    center->calc(doc);
+    through->calc(doc);
+    circle->calc(doc);
+    os.push_back(new ObjectHolder(center));
+    os.push_back(new ObjectHolder(through));
+    os.push_back(new ObjectHolder(circle));
+    ObjectCalcer *moving = ObjectFactory::instance()->constrainedPointCalcer(circle, 0.);
+    moving->calc(doc);
+    os.push_back(new ObjectHolder(moving));
+    for (int i = 0; i < n; ++i) {
+        const Coordinate p = onCircle(Coordinate(0, 0), 6, i, n);
+        ObjectCalcer *fixed = fixedPoint(p.x, p.y);
+        fixed->calc(doc);
+        ObjectCalcer *mid = object("MidPoint", {moving, fixed});
+        mid->calc(doc);
+        os.push_back(new ObjectHolder(ObjectFactory::instance()->locusCalcer(moving, mid)));
+    }
+}
+
+static void buildPolygon(int n, std::vector<ObjectHolder *> &os)
+{
+    std::vector<ObjectCalcer *> points;
+    for (int i = 0; i < n; ++i) {
+        // a star, so that the polygon is not convex..
+        const Coordinate p = onCircle(Coordinate(0, 0), (i % 2) ? 3 : 5, i, n);
+        points.push_back(fixedPoint(p.x, p.y));
+    }
+    os.push_back(new ObjectHolder(object("PolygonBNP", points)));
+}
+
+int main(int argc, char **argv)
+{
+    // the native filter needs the fonts of the labels..
+    QGuiApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Writes big Kig documents for scaling tests."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("shape"), QStringLiteral("One of triangles, macros, fan, loci or polygon."));
+    parser.addPositionalArgument(QStringLiteral("n"), QStringLiteral("The size of the construction."));
+    parser.addPositionalArgument(QStringLiteral("file"), QStringLiteral("The document to write, .kig, .kigz or .kigb."));
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 3)
+        parser.showHelp(1);
+    const QString shape = args[0];
+    bool ok;
+    const int n = args[1].toInt(&ok);
+    if (!ok || n < 1) {
+        qCritical() << "Error: the size has to be a positive number.";
+        return 1;
+    }
+
+    QElapsedTimer t;
+    t.start();
+    KigDocument doc;
+    std::vector<ObjectHolder *> os;
+    if (shape == QLatin1String("triangles"))
+        buildTriangles(n, os);
+    else if (shape == QLatin1String("macros"))
+        buildMacros(n, doc, os);
+    else if (shape == QLatin1String("fan"))
+        buildFan(n, os);
+    else if (shape == QLatin1String("loci"))
+        buildLoci(n, doc, os);
+    else if (shape == QLatin1String("polygon"))
+        buildPolygon(n, os);
+    else {
+        qCritical() << "Error: unknown shape" << shape;
+        return 1;
+    }
+    // this calcs everything in one pass..
+    doc.addObjects(os);
+    const qint64 build = t.restart();
+
+    KigFilter::setBatchMode(true);
+    if (!KigFilters::instance()->save(doc, args[2])) {
+        qCritical() << "Error: could not write" << args[2];
+        return 1;
+    }
+    fprintf(stdout, "%s %d: %zu objects, build %lld ms, save %lld ms\n", qPrintable(shape), n, os.size(), build, t.elapsed());
+    return 0;
+}
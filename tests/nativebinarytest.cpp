@@ -0,0 +1,268 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../filters/filter.h"
+#include "../filters/native-binary-filter.h"
+#include "../filters/native-filter.h"
+#include "../kig/kig_document.h"
+#include "../misc/coordinate.h"
+#include "../misc/kigtransform.h"
+#include "../objects/bogus_imp.h"
+#include "../objects/circle_imp.h"
+#include "../objects/line_imp.h"
+#include "../objects/object_calcer.h"
+#include "../objects/object_drawer.h"
+#include "../objects/object_holder.h"
+#include "../objects/object_imp.h"
+#include "../objects/object_type.h"
+#include "../objects/other_imp.h"
+#include "../objects/point_imp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <typeinfo>
+#include <utility>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+/**
+ * Checks that saving a document as .kigb and loading it again gives
+ * exactly the document we started with: the same objects, with the
+ * same values down to the last bit of every double..
+ */
+class NativeBinaryTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir mdir;
+
+    KigDocument *roundTrip(const KigDocument &doc, const QString &name);
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testFiles_data();
+    void testFiles();
+    void xmlData();
+};
+
+/**
+ * a description of \p imp that is exact for the imps that the binary
+ * format stores packed, and for points..
+ */
+static QString describeImp(const ObjectImp *imp)
+{
+    QString ret = QString::fromLatin1(imp->type()->internalName());
+    if (imp->inherits(IntImp::stype()))
+        ret += QLatin1Char(' ') + QString::number(static_cast<const IntImp *>(imp)->data());
+    else if (imp->inherits(DoubleImp::stype()))
+        ret += QLatin1Char(' ') + QString::number(static_cast<const DoubleImp *>(imp)->data(), 'g', 17);
+    else if (imp->inherits(StringImp::stype()))
+        ret += QLatin1Char(' ') + static_cast<const StringImp *>(imp)->data();
+    else if (imp->inherits(PointImp::stype())) {
+        const Coordinate c = static_cast<const PointImp *>(imp)->coordinate();
+        ret += QStringLiteral(" %1 %2").arg(c.x, 0, 'g', 17).arg(c.y, 0, 'g', 17);
+    }
+    return ret;
+}
+
+typedef std::map<const ObjectCalcer *, QString> DescriptionMap;
+
+static QString describe(const ObjectCalcer *c, DescriptionMap &done)
+{
+    DescriptionMap::const_iterator i = done.find(c);
+    if (i != done.end())
+        return i->second;
+
+    QString ret;
+    if (dynamic_cast<const ObjectConstCalcer *>(c))
+        ret = QStringLiteral("const");
+    else if (const ObjectTypeCalcer *t = dynamic_cast<const ObjectTypeCalcer *>(c))
+        ret = QString::fromLatin1(t->type()->fullName());
+    else if (const ObjectPropertyCalcer *p = dynamic_cast<const ObjectPropertyCalcer *>(c))
+        ret = QString::fromLatin1(p->parent()->imp()->getPropName(p->propGid()));
+    QStringList parents;
+    const std::vector<ObjectCalcer *> ps = c->parents();
+    for (std::vector<ObjectCalcer *>::const_iterator j = ps.begin(); j != ps.end(); ++j)
+        parents << describe(*j, done);
+    ret += QLatin1Char('(') + parents.join(QStringLiteral(", ")) + QStringLiteral(") = ") + describeImp(c->imp());
+    done[c] = ret;
+    return ret;
+}
+
+static QString describe(const ObjectHolder *o, DescriptionMap &done)
+{
+    const ObjectDrawer *d = o->drawer();
+    QString ret = describe(o->calcer(), done);
+    ret += QStringLiteral(" drawn %1 %2 %3 %4 %5 %6")
+               .arg(static_cast<int>(d->shown()))
+               .arg(d->color().name())
+               .arg(d->width())
+               .arg(static_cast<int>(d->style()))
+               .arg(static_cast<int>(d->pointStyle()))
+               .arg(d->font().toString());
+    if (o->nameCalcer())
+        ret += QStringLiteral(" named ") + describe(o->nameCalcer(), done);
+    return ret;
+}
+
+/**
+ * the objects of \p doc sorted by their description, which doesn't
+ * depend on where they are in memory..
+ */
+static std::vector<std::pair<QString, const ObjectHolder *>> sortedObjects(const KigDocument &doc)
+{
+    DescriptionMap done;
+    std::vector<std::pair<QString, const ObjectHolder *>> ret;
+    const std::vector<ObjectHolder *> os = doc.objects();
+    for (std::vector<ObjectHolder *>::const_iterator i = os.begin(); i != os.end(); ++i)
+        ret.push_back(std::make_pair(describe(*i, done), *i));
+    std::stable_sort(ret.begin(), ret.end(), [](const std::pair<QString, const ObjectHolder *> &a, const std::pair<QString, const ObjectHolder *> &b) {
+        return a.first < b.first;
+    });
+    return ret;
+}
+
+/**
+ * compares the imps of \p a and \p b and all of their parents with
+ * ObjectImp::equals(), which compares the doubles exactly..
+ */
+static void compareCalcers(const ObjectCalcer *a, const ObjectCalcer *b)
+{
+    QCOMPARE(typeid(*a).name(), typeid(*b).name());
+    QVERIFY2(a->imp()->equals(*b->imp()), qPrintable(describeImp(a->imp()) + QStringLiteral(" != ") + describeImp(b->imp())));
+    const std::vector<ObjectCalcer *> pa = a->parents();
+    const std::vector<ObjectCalcer *> pb = b->parents();
+    QCOMPARE(pa.size(), pb.size());
+    for (uint i = 0; i < pa.size(); ++i) {
+        compareCalcers(pa[i], pb[i]);
+        if (QTest::currentTestFailed())
+            return;
+    }
+}
+
+static void compareDocuments(const KigDocument &a, const KigDocument &b)
+{
+    QCOMPARE(a.grid(), b.grid());
+    QCOMPARE(a.axes(), b.axes());
+    QCOMPARE(QString::fromLatin1(a.coordinateSystem().type()), QString::fromLatin1(b.coordinateSystem().type()));
+
+    const std::vector<std::pair<QString, const ObjectHolder *>> oa = sortedObjects(a);
+    const std::vector<std::pair<QString, const ObjectHolder *>> ob = sortedObjects(b);
+    QCOMPARE(oa.size(), ob.size());
+    for (uint i = 0; i < oa.size(); ++i) {
+        QCOMPARE(oa[i].first, ob[i].first);
+        compareCalcers(oa[i].second->calcer(), ob[i].second->calcer());
+        if (QTest::currentTestFailed())
+            return;
+    }
+}
+
+KigDocument *NativeBinaryTest::roundTrip(const KigDocument &doc, const QString &name)
+{
+    const QString file = mdir.filePath(name);
+    if (!KigFilterNativeBinary::instance()->save(doc, file))
+        return nullptr;
+    return KigFilterNativeBinary::instance()->load(file);
+}
+
+void NativeBinaryTest::initTestCase()
+{
+    // the filters may not show message boxes here..
+    KigFilter::setBatchMode(true);
+    QVERIFY(mdir.isValid());
+}
+
+void NativeBinaryTest::testFiles_data()
+{
+    QTest::addColumn<QString>("file");
+    const QDir dir(QStringLiteral(KIG_TEST_DATA_DIR));
+    const QStringList files = dir.entryList(QStringList() << QStringLiteral("*.kig"), QDir::Files, QDir::Name);
+    for (const QString &f : files)
+        QTest::newRow(f.toUtf8().constData()) << dir.filePath(f);
+}
+
+void NativeBinaryTest::testFiles()
+{
+    QFETCH(QString, file);
+
+    std::unique_ptr<KigDocument> xml(KigFilterNative::instance()->load(file));
+    if (!xml)
+        QSKIP("this file can't be loaded in this build");
+    std::unique_ptr<KigDocument> binary(roundTrip(*xml, QFileInfo(file).completeBaseName() + QStringLiteral(".kigb")));
+    QVERIFY(binary);
+    compareDocuments(*xml, *binary);
+}
+
+void NativeBinaryTest::xmlData()
+{
+    // the imps that aren't ints, doubles or strings are stored in the
+    // .kigb file as the XML that the .kig format uses, so they must come
+    // back exactly as they do from a .kig file, while the packed ones
+    // must not lose anything at all..
+    KigDocument doc;
+    const double third = 1.0 / 3;
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new DoubleImp(third))));
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new IntImp(-123456789))));
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new StringImp(QStringLiteral("<a & \"b\">")))));
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new PointImp(Coordinate(third, M_PI)))));
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new SegmentImp(Coordinate(-third, 0.1), Coordinate(2e-20, 7e20)))));
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new CircleImp(Coordinate(1.5, -2.25), std::sqrt(2.0)))));
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new AngleImp(Coordinate(0, 0), third, M_PI / 7, false))));
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new TransformationImp(Transformation::rotation(third, Coordinate(1, 2))))));
+
+    const QString kig = mdir.filePath(QStringLiteral("xmldata.kig"));
+    QVERIFY(KigFilterNative::instance()->save(doc, kig));
+    std::unique_ptr<KigDocument> xml(KigFilterNative::instance()->load(kig));
+    QVERIFY(xml);
+    std::unique_ptr<KigDocument> binary(roundTrip(doc, QStringLiteral("xmldata.kigb")));
+    QVERIFY(binary);
+
+    const std::vector<std::pair<QString, const ObjectHolder *>> original = sortedObjects(doc);
+    const std::vector<std::pair<QString, const ObjectHolder *>> fromxml = sortedObjects(*xml);
+    const std::vector<std::pair<QString, const ObjectHolder *>> frombinary = sortedObjects(*binary);
+    QCOMPARE(frombinary.size(), original.size());
+    QCOMPARE(fromxml.size(), original.size());
+
+    std::vector<const ObjectImp *> packed;
+    std::vector<const ObjectImp *> xmlimps;
+    std::vector<const ObjectImp *> binaryimps;
+    for (uint i = 0; i < original.size(); ++i) {
+        const ObjectImp *imp = original[i].second->imp();
+        if (imp->inherits(IntImp::stype()) || imp->inherits(DoubleImp::stype()) || imp->inherits(StringImp::stype()))
+            packed.push_back(imp);
+    }
+    for (uint i = 0; i < frombinary.size(); ++i) {
+        const ObjectImp *imp = frombinary[i].second->imp();
+        if (imp->inherits(IntImp::stype()) || imp->inherits(DoubleImp::stype()) || imp->inherits(StringImp::stype())) {
+            const std::vector<const ObjectImp *>::const_iterator j = std::find_if(packed.begin(), packed.end(), [imp](const ObjectImp *p) {
+                return p->equals(*imp);
+            });
+            QVERIFY2(j != packed.end(), qPrintable(describeImp(imp)));
+        } else
+            binaryimps.push_back(imp);
+    }
+    for (uint i = 0; i < fromxml.size(); ++i) {
+        const ObjectImp *imp = fromxml[i].second->imp();
+        if (!(imp->inherits(IntImp::stype()) || imp->inherits(DoubleImp::stype()) || imp->inherits(StringImp::stype())))
+            xmlimps.push_back(imp);
+    }
+    QCOMPARE(binaryimps.size(), xmlimps.size());
+    for (uint i = 0; i < binaryimps.size(); ++i) {
+        const std::vector<const ObjectImp *>::const_iterator j = std::find_if(xmlimps.begin(), xmlimps.end(), [&binaryimps, i](const ObjectImp *p) {
+            return p->equals(*binaryimps[i]);
+        });
+        QVERIFY2(j != xmlimps.end(), qPrintable(describeImp(binaryimps[i])));
+    }
+}
+
+QTEST_MAIN(NativeBinaryTest)
+
+#include "nativebinarytest.moc"
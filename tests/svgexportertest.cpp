@@ -0,0 +1,150 @@
+// SPDX-FileCopyrightText: 2026 Kig developers
+
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../filters/filter.h"
+#include "../filters/svgexporter.h"
+#include "../kig/kig_document.h"
+#include "../misc/coordinate.h"
+#include "../misc/rect.h"
+#include "../misc/screeninfo.h"
+#include "../objects/line_imp.h"
+#include "../objects/object_calcer.h"
+#include "../objects/object_holder.h"
+#include "../objects/polygon_imp.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <QDomDocument>
+#include <QDomElement>
+#include <QDomNodeList>
+#include <QFile>
+#include <QObject>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTest>
+
+/**
+ * Exports small documents as SVG and checks how the shapes end up in
+ * path elements..
+ */
+class SVGExporterTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir mdir;
+
+    /**
+     * the path elements of \p doc exported as SVG, as pairs of their
+     * css and their path data..
+     */
+    std::vector<std::pair<QString, QString>> exportPaths(const KigDocument &doc);
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void mergeOutlines();
+    void separateFills();
+};
+
+static std::vector<Coordinate> square(double x, double y, double size)
+{
+    std::vector<Coordinate> ret;
+    ret.push_back(Coordinate(x, y));
+    ret.push_back(Coordinate(x + size, y));
+    ret.push_back(Coordinate(x + size, y + size));
+    ret.push_back(Coordinate(x, y + size));
+    return ret;
+}
+
+/**
+ * the number of subpaths in the path data \p d..
+ */
+static int subpaths(const QString &d)
+{
+    return d.count(QLatin1Char('M')) + d.count(QLatin1Char('m'));
+}
+
+std::vector<std::pair<QString, QString>> SVGExporterTest::exportPaths(const KigDocument &doc)
+{
+    std::vector<std::pair<QString, QString>> ret;
+    const QString file = mdir.filePath(QStringLiteral("test.svg"));
+    const ScreenInfo si(Rect(-10, -10, 20, 20), QRect(0, 0, 200, 200));
+    if (!SVGExporter::write(doc, si, file, false, false))
+        return ret;
+
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly))
+        return ret;
+    QDomDocument svg;
+    if (!svg.setContent(&f))
+        return ret;
+
+    // ".s0{fill:none;stroke:#00f}" and so on..
+    std::map<QString, QString> styles;
+    const QString css = svg.documentElement().firstChildElement(QStringLiteral("style")).text();
+    const QRegularExpression re(QStringLiteral("\\.(s\\d+)\\{([^}]*)\\}"));
+    QRegularExpressionMatchIterator i = re.globalMatch(css);
+    while (i.hasNext()) {
+        const QRegularExpressionMatch m = i.next();
+        styles[m.captured(1)] = m.captured(2);
+    }
+
+    const QDomNodeList paths = svg.elementsByTagName(QStringLiteral("path"));
+    for (int j = 0; j < paths.size(); ++j) {
+        const QDomElement e = paths.at(j).toElement();
+        ret.push_back(std::make_pair(styles[e.attribute(QStringLiteral("class"))], e.attribute(QStringLiteral("d"))));
+    }
+    return ret;
+}
+
+void SVGExporterTest::initTestCase()
+{
+    KigFilter::setBatchMode(true);
+    QVERIFY(mdir.isValid());
+}
+
+void SVGExporterTest::mergeOutlines()
+{
+    // two segments drawn the same way go into a single path..
+    KigDocument doc;
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new SegmentImp(Coordinate(-5, -5), Coordinate(5, 5)))));
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new SegmentImp(Coordinate(-5, 5), Coordinate(5, -5)))));
+
+    const std::vector<std::pair<QString, QString>> paths = exportPaths(doc);
+    QCOMPARE(paths.size(), size_t(1));
+    QVERIFY(paths[0].first.startsWith(QLatin1String("fill:none")));
+    QCOMPARE(subpaths(paths[0].second), 2);
+}
+
+void SVGExporterTest::separateFills()
+{
+    // two overlapping polygons of the same colour must not share a
+    // path, or the nonzero fill rule would cut a hole where they
+    // overlap, and their translucent fills would not add up..
+    KigDocument doc;
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new FilledPolygonImp(square(-5, -5, 6)))));
+    std::vector<Coordinate> reversed = square(-3, -3, 6);
+    std::reverse(reversed.begin(), reversed.end());
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new FilledPolygonImp(reversed))));
+    doc.addObject(new ObjectHolder(new ObjectConstCalcer(new SegmentImp(Coordinate(-5, 5), Coordinate(5, -5)))));
+
+    const std::vector<std::pair<QString, QString>> paths = exportPaths(doc);
+    int fills = 0;
+    int outlines = 0;
+    for (std::vector<std::pair<QString, QString>>::const_iterator i = paths.begin(); i != paths.end(); ++i) {
+        QCOMPARE(subpaths(i->second), 1);
+        if (i->first.startsWith(QLatin1String("fill:none")))
+            ++outlines;
+        else
+            ++fills;
+    }
+    QCOMPARE(fills, 2);
+    QCOMPARE(outlines, 1);
+}
+
+QTEST_MAIN(SVGExporterTest)
+
+#include "svgexportertest.moc"